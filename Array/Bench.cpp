@@ -0,0 +1,242 @@
+#include "array.h"
+#include "parallel.h"
+#include "vector.h"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Time a callable, in milliseconds
+template<class F>
+static double timeIt(F f)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	f();
+	std::chrono::duration<double, std::milli> took =
+		std::chrono::steady_clock::now() - start;
+	return took.count();
+}
+
+// Keeps results alive so the loops aren't optimized away
+static volatile long sink;
+static void keep(long v) { sink = sink + v; }
+
+// Kernels at each level vs a plain loop, GB/s over a buffer that doesn't fit
+// in cache
+template<class T>
+static void benchKernels(const char* type, int reps)
+{
+	const std::size_t N = 1 << 22;
+	std::unique_ptr<array<T, N>> a(new array<T, N>), b(new array<T, N>);
+	const char* name[3] = { "scalar", "sse2", "avx2" };
+	double gb = double(N) * sizeof(T) * reps / 1e9;
+
+	Kernels::Level detected = Kernels::level();
+	for (int level = Kernels::SCALAR; level <= detected; level++) {
+		Kernels::level() = static_cast<Kernels::Level>(level);
+
+		double fill = timeIt([&] {
+			for (int r = 0; r < reps; r++)
+				a->fill(T(r + 1));
+		});
+		double copy = timeIt([&] {
+			for (int r = 0; r < reps; r++)
+				*b = *a;
+		});
+		double eq = timeIt([&] {
+			for (int r = 0; r < reps; r++)
+				keep(*a == *b);
+		});
+		double find = timeIt([&] {
+			for (int r = 0; r < reps; r++)
+				keep(a->find(T(-1)) == a->end());
+		});
+		double sum = timeIt([&] {
+			for (int r = 0; r < reps; r++)
+				keep(static_cast<long>(a->sum()));
+		});
+		double max = timeIt([&] {
+			for (int r = 0; r < reps; r++)
+				keep(static_cast<long>(a->max()));
+		});
+
+		std::printf("%-6s %-6s  fill %5.1f  copy %5.1f  == %5.1f  "
+		            "find %5.1f  sum %5.1f  max %5.1f GB/s\n",
+		            type, name[level], gb / fill * 1e3, gb / copy * 1e3,
+		            gb / eq * 1e3, gb / find * 1e3, gb / sum * 1e3,
+		            gb / max * 1e3);
+	}
+	Kernels::level() = detected;
+
+	// Reference, element by element
+	double loop = timeIt([&] {
+		for (int r = 0; r < reps; r++) {
+			T* p = a->data();
+			for (std::size_t i = 0; i < N; i++)
+				p[i] = T(r + 1);
+		}
+	});
+	std::printf("%-6s loop    fill %5.1f GB/s\n", type, gb / loop * 1e3);
+}
+
+// std algorithms through array iterators vs the same calls on raw pointers,
+// the wrapper should cost nothing
+static void benchIterator(int reps)
+{
+	const std::size_t N = 1 << 20;
+	std::unique_ptr<array<int, N>> a(new array<int, N>), b(new array<int, N>);
+	std::mt19937 rng(1);
+	for (std::size_t i = 0; i < N; i++)
+		a->at(i) = static_cast<int>(rng());
+
+	for (int mode = 0; mode < 2; mode++) {
+		const char* name = mode == 0 ? "iterator" : "pointer";
+		double copy, sort, search;
+		if (mode == 0) {
+			copy = timeIt([&] {
+				for (int r = 0; r < reps; r++)
+					std::copy(a->begin(), a->end(), b->begin());
+			});
+			sort = timeIt([&] { std::sort(b->begin(), b->end()); });
+			search = timeIt([&] {
+				for (std::size_t i = 0; i < N; i++)
+					keep(std::lower_bound(b->begin(), b->end(),
+					                      a->at(i)) - b->begin());
+			});
+		}
+		else {
+			copy = timeIt([&] {
+				for (int r = 0; r < reps; r++)
+					std::copy(a->data(), a->data() + N, b->data());
+			});
+			sort = timeIt([&] { std::sort(b->data(), b->data() + N); });
+			search = timeIt([&] {
+				for (std::size_t i = 0; i < N; i++)
+					keep(std::lower_bound(b->data(), b->data() + N,
+					                      a->at(i)) - b->data());
+			});
+		}
+
+		std::printf("%-8s  n=%zu  %dx copy %.2f ms  sort %.2f ms  "
+		            "n x lower_bound %.2f ms\n",
+		            name, N, reps, copy, sort, search);
+	}
+}
+
+// push_back throughput against std::vector, and many short vectors where the
+// small buffer saves the allocations
+static void benchVector(int n)
+{
+	double ours = timeIt([&] {
+		vector<int> v;
+		for (int i = 0; i < n; i++)
+			v.push_back(i);
+		keep(v.back());
+	});
+	double std = timeIt([&] {
+		std::vector<int> v;
+		for (int i = 0; i < n; i++)
+			v.push_back(i);
+		keep(v.back());
+	});
+	double oursStr = timeIt([&] {
+		vector<std::string> v;
+		for (int i = 0; i < n / 8; i++)
+			v.emplace_back(24, 'x');
+		keep(v.size());
+	});
+	double stdStr = timeIt([&] {
+		std::vector<std::string> v;
+		for (int i = 0; i < n / 8; i++)
+			v.emplace_back(24, 'x');
+		keep(v.size());
+	});
+	std::printf("push_back  n=%d  int: vector %.2f ms  std::vector %.2f ms  "
+	            "string (n/8): vector %.2f ms  std::vector %.2f ms\n",
+	            n, ours, std, oursStr, stdStr);
+
+	double heap = timeIt([&] {
+		for (int i = 0; i < n / 8; i++) {
+			vector<int> v;
+			for (int j = 0; j < 8; j++)
+				v.push_back(j);
+			keep(v.back());
+		}
+	});
+	double small = timeIt([&] {
+		for (int i = 0; i < n / 8; i++) {
+			small_vector<int, 8> v;
+			for (int j = 0; j < 8; j++)
+				v.push_back(j);
+			keep(v.back());
+		}
+	});
+	std::printf("%d vectors of 8: vector %.2f ms  small_vector %.2f ms\n",
+	            n / 8, heap, small);
+}
+
+// Parallel algorithms from one thread to every core, over an array too
+// large for the caches
+static void benchParallel(void)
+{
+	const std::size_t N = 1 << 24;
+	unsigned cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+
+	std::unique_ptr<array<double, N>> a(new array<double, N>());
+	std::unique_ptr<array<double, N>> out(new array<double, N>());
+	for (unsigned threads = 1; threads <= cores; threads *= 2) {
+		ThreadPool pool(threads);
+		std::mt19937 gen(7);
+		std::uniform_real_distribution<double> dist(-1.0, 1.0);
+		for (double& x : *a)
+			x = dist(gen);
+
+		double each = timeIt([&] {
+			parallel_for_each(a->begin(), a->end(),
+			                  [](double& x) { x = x * 1.5 + 0.25; }, pool);
+		});
+		double transform = timeIt([&] {
+			parallel_transform(a->begin(), a->end(), out->begin(),
+			                   [](double x) { return std::sqrt(x * x + 1); },
+			                   pool);
+		});
+		double sum = 0, ordered = 0;
+		double reduce = timeIt([&] {
+			sum = parallel_reduce(a->begin(), a->end(), 0.0,
+			                      std::plus<double>(), false, pool);
+		});
+		double deterministic = timeIt([&] {
+			ordered = parallel_reduce(a->begin(), a->end(), 0.0,
+			                          std::plus<double>(), true, pool);
+		});
+		double sort = timeIt([&] { parallel_sort(a->begin(), a->end(), pool); });
+		keep(static_cast<long>(sum + ordered + out->at(N / 2)));
+		std::printf("parallel N=%zu  threads=%u  for_each %.2f ms  "
+		            "transform %.2f ms  reduce %.2f ms  deterministic %.2f ms  "
+		            "sort %.2f ms\n", N, threads, each, transform, reduce,
+		            deterministic, sort);
+
+		if (threads < cores && threads * 2 > cores)
+			threads = cores / 2;    // always end on every core
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	benchKernels<int>("int", 20);
+	benchKernels<float>("float", 20);
+	benchKernels<double>("double", 10);
+	benchKernels<char>("char", 40);
+	benchIterator(20);
+	benchVector(1 << 24);
+	benchParallel();
+	return 0;
+}
@@ -0,0 +1,724 @@
+#include "array.h"
+#include "kernels.h"
+#include "parallel.h"
+#include "vector.h"
+#include "../List/BufferedIO.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L
+#include <ranges>
+#endif
+#include <vector>
+
+// Stateful allocator counting live objects, equal if ids match
+template<class T, bool Propagate>
+struct Counting {
+	typedef T value_type;
+	typedef std::integral_constant<bool, Propagate> Tag;
+	typedef Tag propagate_on_container_copy_assignment;
+	typedef Tag propagate_on_container_move_assignment;
+	typedef Tag propagate_on_container_swap;
+	template<class U> struct rebind { typedef Counting<U, Propagate> other; };
+
+	Counting(long* Live, int Id) : live(Live), id(Id) {}
+	template<class U>
+	Counting(const Counting<U, Propagate>& from) : live(from.live), id(from.id) {}
+
+	T* allocate(std::size_t k)
+	{
+		*live += k;
+		return static_cast<T*>(::operator new(k * sizeof(T)));
+	}
+	void deallocate(T* p, std::size_t k)
+	{
+		*live -= k;
+		::operator delete(p);
+	}
+
+	long* live;
+	int id;
+};
+
+template<class T, class U, bool P>
+static bool operator==(const Counting<T, P>& a, const Counting<U, P>& b)
+{
+	return a.id == b.id;
+}
+
+template<class T, class U, bool P>
+static bool operator!=(const Counting<T, P>& a, const Counting<U, P>& b)
+{
+	return a.id != b.id;
+}
+
+static void testAccess(void)
+{
+	array<int, 4> a;
+	for (std::size_t i = 0; i < 4; i++)
+		assert(a.at(i) == 0);
+	a.at(2) = 5;
+	const array<int, 4>& c = a;
+	assert(c.at(2) == 5);
+
+	bool thrown = false;
+	try { a.at(4); }
+	catch (const std::out_of_range&) { thrown = true; }
+	assert(thrown);
+}
+
+// Built at compile time
+static constexpr array<int, 16> squares(void)
+{
+	array<int, 16> a;
+	for (std::size_t i = 0; i < 16; i++)
+		a.at(i) = static_cast<int>(i * i);
+	return a;
+}
+
+static constexpr int sumOf(array<int, 16> a)
+{
+	int sum = 0;
+	for (array<int, 16>::iterator it = a.begin(); it != a.end(); ++it)
+		sum += *it;
+	return sum;
+}
+
+static constexpr array<char, 4> filled(char c)
+{
+	array<char, 4> a;
+	a.fill(c);
+	return a;
+}
+
+static void testInline(void)
+{
+	static constexpr array<int, 16> table = squares();
+	static_assert(table.at(7) == 49, "squares");
+	static_assert(sumOf(squares()) == 1240, "sum");
+	static_assert(filled('x').at(3) == 'x', "fill");
+	static_assert(sizeof(array<int, 16>) == 16 * sizeof(int), "inline");
+	static_assert(sizeof(array<int, 1000>) < 1000 * sizeof(int), "heap");
+	static_assert(array<int, 256>::IS_INLINE, "threshold");
+	static_assert(!array<int, 257>::IS_INLINE, "threshold");
+	static_assert(array<int, 512, std::allocator<int>, 2048>::IS_INLINE,
+	              "threshold");
+	static_assert(!array<int, 4, Counting<int, false>>::IS_INLINE, "alloc");
+	assert(table.at(15) == 225);
+
+	// Copies and moves are element wise
+	array<std::string, 4> a;
+	a.fill("a");
+	array<std::string, 4> b(a);
+	b.at(0) = "b";
+	assert(a.at(0) == "a" && b.at(1) == "a");
+	array<std::string, 4> c(std::move(b));
+	assert(c.at(0) == "b" && b.data() != c.data());
+	a.swap(c);
+	assert(a.at(0) == "b" && c.at(0) == "a");
+	a = c;
+	assert(a.at(0) == "a");
+
+	// Heap arrays get filled too
+	array<int, 1000> h;
+	h.fill(7);
+	assert(h.at(0) == 7 && h.at(999) == 7);
+}
+
+enum Colour { RED, GREEN, BLUE };
+
+// Kernel results against plain loops, every length up to a few vectors
+template<class T, class Gen>
+static void checkKernels(Gen gen)
+{
+	for (std::size_t n = 0; n < 80; n++) {
+		std::vector<T> a(n), b(n);
+		for (std::size_t i = 0; i < n; i++)
+			a[i] = b[i] = gen(i);
+		assert(Kernels::equal(a.data(), b.data(), n));
+		assert(Kernels::compare(a.data(), b.data(), n) == 0);
+		if (n == 0)
+			continue;
+
+		// One difference anywhere
+		std::size_t at = std::rand() % n;
+		b[at] = gen(at + 1);
+		bool diff = !(a[at] == b[at]);
+		assert(Kernels::mismatch(a.data(), b.data(), n) == (diff ? at : n));
+		assert(Kernels::equal(a.data(), b.data(), n) == !diff);
+		int cmp = Kernels::compare(a.data(), b.data(), n);
+		assert((cmp < 0) == std::lexicographical_compare(a.begin(), a.end(),
+		                                                 b.begin(), b.end()));
+		assert((cmp > 0) == std::lexicographical_compare(b.begin(), b.end(),
+		                                                 a.begin(), a.end()));
+
+		T val = gen(std::rand() % n);
+		assert(Kernels::find(a.data(), n, val) ==
+		       static_cast<std::size_t>(std::find(a.begin(), a.end(), val) -
+		                                a.begin()));
+		assert(Kernels::find(a.data(), n, gen(n + 1000)) == n ||
+		       a[Kernels::find(a.data(), n, gen(n + 1000))] == gen(n + 1000));
+
+		Kernels::fill(b.data(), n, val);
+		assert(std::count(b.begin(), b.end(), val) ==
+		       static_cast<std::ptrdiff_t>(n));
+		Kernels::copy(a.data(), n, b.data());
+		assert(a == b);
+	}
+}
+
+template<class T>
+static void checkReductions(void)
+{
+	for (std::size_t n = 1; n < 80; n++) {
+		std::vector<T> a(n);
+		for (std::size_t i = 0; i < n; i++)
+			a[i] = static_cast<T>(std::rand() % 1000 - 500);
+		T sum = 0;
+		for (std::size_t i = 0; i < n; i++)
+			sum += a[i];
+		assert(Kernels::sum(a.data(), n) == sum);   // exact for small ints
+		assert(Kernels::min(a.data(), n) ==
+		       *std::min_element(a.begin(), a.end()));
+		assert(Kernels::max(a.data(), n) ==
+		       *std::max_element(a.begin(), a.end()));
+	}
+}
+
+static void testKernels(void)
+{
+	static int pool[100];
+	Kernels::Level detected = Kernels::level();
+	for (int level = detected; level >= Kernels::SCALAR; level--) {
+		Kernels::level() = static_cast<Kernels::Level>(level);
+		checkKernels<std::int8_t>([](std::size_t i) {
+			return std::int8_t(i * 7);
+		});
+		checkKernels<unsigned short>([](std::size_t i) {
+			return (unsigned short)(i * 3);
+		});
+		checkKernels<int>([](std::size_t i) { return int(i * i) - 100; });
+		checkKernels<std::int64_t>([](std::size_t i) {
+			return std::int64_t(i) << 33;
+		});
+		checkKernels<float>([](std::size_t i) { return float(i) * 0.5f; });
+		checkKernels<double>([](std::size_t i) { return double(i) - 40.0; });
+		checkKernels<Colour>([](std::size_t i) { return Colour(i % 3); });
+		checkKernels<int*>([](std::size_t i) { return pool + i % 100; });
+		checkKernels<std::string>([](std::size_t i) {
+			return std::to_string(i);
+		});
+		checkReductions<int>();
+		checkReductions<float>();
+		checkReductions<double>();
+		checkReductions<long>();
+
+		// == semantics for floating point, not bits
+		const double nan = NAN;
+		double z[9] = { 0, 0, 0, 0, 0, nan, 0, 0, 0 };
+		double m[9] = { -0.0, -0.0, -0.0, -0.0, -0.0, nan, -0.0, -0.0, 1 };
+		assert(Kernels::mismatch(z, m, 9) == 5);
+		assert(Kernels::find(m, 9, 0.0) == 0 && Kernels::find(z, 9, nan) == 9);
+		assert(Kernels::compare(z, m, 9) < 0);
+	}
+	Kernels::level() = detected;
+
+	// Through array
+	array<int, 100> a, b;
+	assert(a == b && !(a < b) && a <= b);
+	a.fill(3);
+	assert(a.sum() == 300 && a.min() == 3 && a.max() == 3 && a != b);
+	a.at(50) = -1;
+	assert(a.min() == -1 && a.find(-1) == a.begin() + 50);
+	assert(a.find(9) == a.end());
+	assert(b < a && a > b && b <= a && a >= b);
+	b = a;
+	assert(a == b);
+	array<int, 2000> h, g;
+	h.fill(5);
+	g = h;
+	assert(g == h && g.sum() == 10000);
+	array<std::string, 4> s, t;
+	s.fill("x");
+	assert(t < s && s.find("x") == s.begin());
+}
+
+static void testIterator(void)
+{
+	typedef array<int, 64>::iterator It;
+	typedef array<int, 64>::const_iterator CIt;
+	typedef std::iterator_traits<It> Traits;
+	static_assert(std::is_same<Traits::value_type, int>::value, "value");
+	static_assert(std::is_same<Traits::difference_type, std::ptrdiff_t>::value,
+	              "difference");
+	static_assert(std::is_same<Traits::iterator_category,
+	                           std::random_access_iterator_tag>::value, "tag");
+	static_assert(std::is_same<std::iterator_traits<CIt>::value_type,
+	                           int>::value, "const value");
+	static_assert(std::is_trivially_copyable<It>::value, "trivial");
+	static_assert(!std::is_convertible<CIt, It>::value, "const");
+#if __cplusplus >= 202002L
+	static_assert(std::contiguous_iterator<It>, "contiguous");
+	static_assert(std::contiguous_iterator<CIt>, "contiguous");
+	static_assert(std::ranges::contiguous_range<array<int, 64>>, "range");
+#endif
+
+	array<int, 64> a;
+	for (std::size_t i = 0; i < 64; i++)
+		a.at(i) = static_cast<int>((i * 37) % 64);
+
+	// Arithmetic
+	It it = a.begin() + 10;
+	assert(it - a.begin() == 10 && a.end() - a.begin() == 64);
+	assert(--it == a.begin() + 9 && it-- == a.begin() + 9);
+	assert(it == 8 + a.begin() && it[2] == a.at(10) && &*it == it.operator->());
+	CIt c = it;
+	assert(c == it && it == c && c - a.begin() == 8 && a.cend() > c);
+
+	// Library algorithms
+	std::sort(a.begin(), a.end());
+	assert(std::is_sorted(a.cbegin(), a.cend()));
+	const array<int, 64>& k = a;
+	assert(std::lower_bound(k.begin(), k.end(), 20) - k.begin() == 20);
+	assert(k.find(33) - k.begin() == 33);
+	array<int, 64> b;
+	std::copy(a.begin(), a.end(), b.begin());
+	assert(a == b);
+	std::copy_backward(a.begin(), a.end() - 1, b.end());
+	assert(b.at(0) == 0 && b.at(1) == 0 && b.at(63) == 62);
+	std::reverse_copy(a.begin(), a.end(), b.begin());
+	assert(std::equal(b.rbegin(), b.rend(), a.begin()));
+	assert(*k.rbegin() == 63 && *(k.crend() - 1) == 0);
+#if __cplusplus >= 202002L
+	std::ranges::sort(b, std::greater<int>());
+	assert(std::ranges::equal(b, a | std::views::reverse));
+	assert(std::to_address(a.begin() + 5) == a.data() + 5);
+#endif
+}
+
+// Throws on the n-th copy, counts live objects
+struct Fragile {
+	static int live, copies, throwAt;
+
+	Fragile(int Value) : value(Value) { live++; }
+	Fragile(const Fragile& from) : value(from.value)
+	{
+		if (++copies == throwAt)
+			throw std::runtime_error("copy");
+		live++;
+	}
+	~Fragile(void) { live--; }
+
+	int value;
+};
+int Fragile::live = 0, Fragile::copies = 0, Fragile::throwAt = -1;
+
+// Over-aligned element, like a SIMD register or a cache line
+struct alignas(64) CacheLine {
+	long words[8];
+};
+
+static void testVector(void)
+{
+	vector<int> v;
+	assert(v.empty() && v.capacity() == 0 && v.data() == nullptr);
+	for (int i = 0; i < 1000; i++)
+		v.push_back(i);
+	assert(v.size() == 1000 && v.at(999) == 999);
+	assert(v.capacity() >= 1000 && v.capacity() < 2000);
+	int sum = 0;
+	for (int x : v)
+		sum += x;
+	assert(sum == 999 * 1000 / 2);
+
+	// Over-aligned elements stay aligned through every growth (as far as
+	// std::allocator aligns them, from C++17 on)
+#ifdef __cpp_aligned_new
+	for (int round = 0; round < 20; round++) {
+		vector<CacheLine> lines;
+		for (int i = 0; i < 100; i++) {
+			CacheLine line = {};
+			line.words[0] = i;
+			lines.push_back(line);
+			assert(reinterpret_cast<std::uintptr_t>(lines.data()) % 64 == 0);
+		}
+		assert(lines.at(99).words[0] == 99 && lines.at(50).words[0] == 50);
+	}
+#endif
+
+	// Geometric growth, few reallocations
+	vector<int> g;
+	int grows = 0;
+	for (int i = 0; i < 100000; i++) {
+		std::size_t before = g.capacity();
+		g.emplace_back(i);
+		grows += g.capacity() != before;
+	}
+	assert(grows < 20);
+
+	// Growing one element at a time through resize() too
+	vector<int> r;
+	grows = 0;
+	for (std::size_t i = 1; i <= 100000; i++) {
+		std::size_t before = r.capacity();
+		if (i % 2 == 0)
+			r.resize(i);
+		else
+			r.resize(i, 7);
+		grows += r.capacity() != before;
+	}
+	assert(grows < 20 && r.at(0) == 7 && r.at(1) == 0);
+
+	// Elements of its own, across a growth
+	vector<std::string> s;
+	s.push_back("first");
+	while (s.size() < s.capacity())
+		s.push_back(s.back());
+	s.push_back(s.at(0));
+	s.emplace_back(s.at(0), 1, 3);
+	assert(s.at(s.size() - 2) == "first" && s.back() == "irs");
+
+	v.resize(10);
+	v.shrink_to_fit();
+	assert(v.capacity() == 10 && v.at(9) == 9);
+	v.resize(12, v.at(3));
+	assert(v.at(11) == 3 && v.size() == 12);
+	v.reserve(100);
+	assert(v.capacity() == 100 && v.at(11) == 3);
+	v.pop_back();
+	assert(v.size() == 11);
+
+	vector<int> c(v), m(std::move(c));
+	assert(c.empty() && m == v && m.data() != v.data());
+	m = { 1, 2, 3 };
+	v = m;
+	assert(v.size() == 3 && v == m);
+	std::sort(g.rbegin(), g.rend());
+	assert(g.at(0) == 99999 && g.back() == 0);
+	vector<double> d(4, 0.5);
+	assert(std::accumulate(d.begin(), d.end(), 0.0) == 2.0);
+
+	bool thrown = false;
+	try { d.at(4); }
+	catch (const std::out_of_range&) { thrown = true; }
+	assert(thrown);
+
+	// A failed growth leaves the elements as they were
+	{
+		vector<Fragile> f;
+		for (int i = 0; i < 4; i++)
+			f.emplace_back(i);
+		assert(f.capacity() == 4);
+		Fragile::copies = 0;
+		Fragile::throwAt = 3;
+		thrown = false;
+		try { f.push_back(Fragile(9)); }
+		catch (const std::runtime_error&) { thrown = true; }
+		assert(thrown && f.size() == 4 && f.capacity() == 4);
+		assert(f.at(3).value == 3 && Fragile::live == 4);
+		Fragile::throwAt = -1;
+	}
+	assert(Fragile::live == 0);
+
+	// Allocator aware
+	long live1 = 0, live2 = 0;
+	{
+		typedef Counting<std::string, false> Sticky;
+		vector<std::string, Sticky> a(Sticky(&live1, 1)), b(Sticky(&live2, 2));
+		a.push_back("a");
+		b = a;
+		assert(live2 > 0 && b.get_allocator().id == 2 && b.at(0) == "a");
+		vector<std::string, Sticky> e(std::move(a));
+		assert(e.get_allocator().id == 1 && e.at(0) == "a" && a.empty());
+		thrown = false;
+		try { e.swap(b); }
+		catch (const std::invalid_argument&) { thrown = true; }
+		assert(thrown);
+	}
+	assert(live1 == 0 && live2 == 0);
+}
+
+static void testSmallVector(void)
+{
+	small_vector<int, 8> a;
+	assert(a.isInline() && a.capacity() == 8);
+	for (int i = 0; i < 8; i++)
+		a.push_back(i);
+	assert(a.isInline());
+	a.push_back(8);
+	assert(!a.isInline() && a.size() == 9 && a.at(8) == 8 && a.at(0) == 0);
+	a.resize(5);
+	a.shrink_to_fit();
+	assert(a.isInline() && a.capacity() == 8 && a.at(4) == 4);
+
+	// Copies and moves stay inline when they fit
+	small_vector<std::string, 4> s = { "a", "b" };
+	small_vector<std::string, 4> t(s), u(std::move(s));
+	assert(t.isInline() && u.isInline() && u.at(1) == "b" && s.empty());
+	for (int i = 0; i < 10; i++)
+		t.push_back(std::to_string(i));
+	const std::string* heap = t.data();
+	small_vector<std::string, 4> w(std::move(t));
+	assert(w.data() == heap && t.isInline() && t.empty());
+
+	// Swaps between inline and heap storage
+	w.swap(u);
+	assert(w.size() == 2 && u.size() == 12 && u.data() == heap);
+	assert(w.at(0) == "a" && u.at(11) == "9");
+
+	// Usable as a vector
+	vector<std::string>& base = u;
+	vector<std::string> moved(std::move(base));
+	assert(moved.size() == 12 && u.empty() && u.isInline());
+	u = { "x" };
+	vector<std::string> copied(u);
+	assert(copied.size() == 1 && copied.at(0) == "x");
+
+	// An empty vector has no storage to hand over, the inline one stays
+	vector<std::string> none;
+	base = std::move(none);
+	assert(u.empty() && u.isInline() && u.capacity() == 4);
+	for (int i = 0; i < 10; i++)
+		u.push_back(std::to_string(i));
+	base.swap(none);
+	assert(u.empty() && u.isInline() && none.size() == 10);
+}
+
+static void testParallel(void)
+{
+	const std::size_t N = 1 << 18;
+	std::unique_ptr<array<int, N>> a(new array<int, N>());
+	std::srand(7);
+	for (int& x : *a)
+		x = std::rand() % 100000 - 50000;
+	std::vector<int> want(a->begin(), a->end());
+
+	ThreadPool one(1), four(4);
+	assert(one.size() == 1 && four.size() == 4);
+	for (ThreadPool* pool : { &one, &four }) {
+		array<int, N>& b = *a;
+		parallel_for_each(b.begin(), b.end(), [](int& x) { x *= 2; }, *pool);
+		for (std::size_t i = 0; i < N; i++)
+			assert(b.at(i) == want.at(i) * 2);
+		parallel_transform(b.begin(), b.end(), b.begin(),
+		                   [](int x) { return x / 2; }, *pool);
+		assert(std::equal(b.begin(), b.end(), want.begin()));
+
+		long sum = std::accumulate(want.begin(), want.end(), 10L);
+		assert(parallel_reduce(b.cbegin(), b.cend(), 10L, std::plus<long>(),
+		                       false, *pool) == sum);
+		assert(parallel_reduce(b.cbegin(), b.cend(), 10L, std::plus<long>(),
+		                       true, *pool) == sum);
+		int low = parallel_reduce(b.begin(), b.end(), 0,
+		                          [](int x, int y) { return std::min(x, y); },
+		                          false, *pool);
+		assert(low == *std::min_element(want.begin(), want.end()));
+
+		// Sorts, both ways, odd sizes and ranges too small to split
+		std::vector<int> sorted(want);
+		std::sort(sorted.begin(), sorted.end());
+		parallel_sort(b.begin(), b.end(), *pool);
+		assert(std::equal(b.begin(), b.end(), sorted.begin()));
+		parallel_sort(b.begin(), b.end(), std::greater<int>(), *pool);
+		assert(std::equal(b.rbegin(), b.rend(), sorted.begin()));
+		std::copy(want.begin(), want.end(), b.begin());
+		for (std::size_t n : { std::size_t(0), std::size_t(1),
+		                       std::size_t(100), N - 12345 }) {
+			std::vector<int> part(want.begin(), want.begin() + n);
+			std::sort(part.begin(), part.end());
+			parallel_sort(b.begin(), b.begin() + n, *pool);
+			assert(std::equal(part.begin(), part.end(), b.begin()));
+			std::copy(want.begin(), want.end(), b.begin());
+		}
+	}
+
+	// Deterministic sums don't depend on the pool
+	vector<double> d;
+	for (std::size_t i = 0; i < N; i++)
+		d.push_back(1.0 / (1 + std::rand() % 1000) - 0.0005);
+	ThreadPool three(3);
+	double first = parallel_reduce(d.begin(), d.end(), 0.0,
+	                               std::plus<double>(), true, one);
+	for (ThreadPool* pool : { &one, &three, &four })
+		for (int run = 0; run < 5; run++)
+			assert(parallel_reduce(d.begin(), d.end(), 0.0,
+			                       std::plus<double>(), true, *pool) == first);
+	assert(std::fabs(first - std::accumulate(d.begin(), d.end(), 0.0)) < 1e-6);
+
+	// Partial results are combined in range order, op needn't commute. A
+	// pause now and then lets every task take chunks, even on one core.
+	std::vector<std::string> words;
+	for (int i = 0; i < 20000; i++)
+		words.push_back(i % 500 == 0 ? "|" : std::to_string(i % 10));
+	auto join = [](const std::string& a, const std::string& b) {
+		if (b == "|")
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return a + b;
+	};
+	std::string joined = std::accumulate(words.begin(), words.end(),
+	                                     std::string(">"));
+	for (bool deterministic : { false, true })
+		assert(parallel_reduce(words.begin(), words.end(), std::string(">"),
+		                       join, deterministic, four) == joined);
+
+	// Strings are sorted by moves
+	vector<std::string> s;
+	for (std::size_t i = 0; i < N / 4; i++)
+		s.push_back(std::to_string(std::rand()));
+	std::vector<std::string> strings(s.begin(), s.end());
+	std::sort(strings.begin(), strings.end());
+	parallel_sort(s.begin(), s.end(), four);
+	assert(std::equal(s.begin(), s.end(), strings.begin()));
+
+	// Nested algorithms run on the same pool
+	std::vector<long> rows(64);
+	parallel_for_each(rows.begin(), rows.end(), [&](long& r) {
+		r = parallel_reduce(a->begin(), a->end(), 0L, std::plus<long>(),
+		                    true, four);
+	}, four);
+	for (long r : rows)
+		assert(r == std::accumulate(want.begin(), want.end(), 0L));
+
+	// The first exception reaches the caller, the pool is still usable
+	bool thrown = false;
+	try {
+		parallel_for_each(a->begin(), a->end(), [](int& x) {
+			if (x == 0)
+				throw std::runtime_error("zero");
+		}, four);
+	}
+	catch (const std::runtime_error&) { thrown = true; }
+	assert(thrown == (std::find(want.begin(), want.end(), 0) != want.end()));
+	std::fill(a->begin(), a->end(), 0);
+	thrown = false;
+	try {
+		parallel_for_each(a->begin(), a->end(), [](int& x) {
+			throw std::runtime_error("any");
+		}, four);
+	}
+	catch (const std::runtime_error&) { thrown = true; }
+	assert(thrown);
+	assert(parallel_reduce(a->begin(), a->end(), 1, std::plus<int>(), false,
+	                       four) == 1);
+}
+
+static void testAllocator(void)
+{
+	long live1 = 0, live2 = 0;
+	{
+		typedef Counting<std::string, false> Sticky;
+		array<std::string, 8, Sticky> a(Sticky(&live1, 1)), b(Sticky(&live2, 2));
+		assert(live1 == 8 && live2 == 8);
+		a.at(3) = "three";
+
+		// Copies keep the source's allocator, assignment keeps the target's
+		array<std::string, 8, Sticky> c(a);
+		assert(live1 == 16 && c.get_allocator().id == 1 && c.at(3) == "three");
+		b = a;
+		assert(live2 == 8 && b.get_allocator().id == 2 && b.at(3) == "three");
+
+		// Unequal allocators that don't propagate, elements are moved over
+		a.at(0) = "zero";
+		b = std::move(a);
+		assert(b.at(0) == "zero" && b.get_allocator().id == 2 && live1 == 16);
+
+		// Equal ones, storage is stolen and the source gets fresh elements
+		array<std::string, 8, Sticky> d(std::move(c));
+		assert(d.at(3) == "three" && live1 == 24);
+		assert(c.at(3).empty() && c.get_allocator().id == 1 && c < d);
+		c.at(3) = "three";
+		assert(c == d);
+		d.at(3) = "four";
+		c = std::move(d);
+		assert(c.at(3) == "four" && d.at(3) == "three" && live1 == 24);
+
+		bool thrown = false;
+		try { a.swap(b); }
+		catch (const std::invalid_argument&) { thrown = true; }
+		assert(thrown);
+	}
+	assert(live1 == 0 && live2 == 0);
+	{
+		typedef Counting<int, true> Follow;
+		array<int, 8, Follow> a(Follow(&live1, 1)), b(Follow(&live2, 2));
+		a.at(0) = 1;
+		b.at(0) = 2;
+
+		// Propagating allocators travel with the storage
+		a.swap(b);
+		assert(a.at(0) == 2 && a.get_allocator().id == 2);
+		a = b;
+		assert(a.at(0) == 1 && a.get_allocator().id == 1);
+		assert(live1 == 16 && live2 == 0);
+		array<int, 8, Follow> c(Follow(&live2, 2));
+		c = std::move(a);
+		assert(c.at(0) == 1 && c.get_allocator().id == 1 && live2 == 8);
+	}
+	assert(live1 == 0 && live2 == 0);
+}
+
+static void testBufferedIO(void)
+{
+	array<int, 1000> a;
+	for (std::size_t i = 0; i < 1000; i++)
+		a.at(i) = static_cast<int>(i) - 500;
+	assert(a.data() + 999 == &a.at(999));
+
+	std::ostringstream text;
+	{
+		Writer out(text);
+		writeText(out, a.begin(), a.begin() + 3, ',');
+	}
+	assert(text.str() == "-500,-499,-498,");
+
+	// One block out, one block in
+	std::stringstream bin;
+	{
+		Writer out(bin, 256);
+		writeBinary(out, a.data(), 1000);
+	}
+	array<int, 1000> b;
+	Reader in(bin, 256);
+	assert(readBinary(in, b.data(), 1000));
+	for (std::size_t i = 0; i < 1000; i++)
+		assert(b.at(i) == a.at(i));
+
+	// Count has to match
+	bin.clear();
+	bin.seekg(0);
+	Reader again(bin);
+	array<int, 999> c;
+	assert(!readBinary(again, c.data(), 999));
+}
+
+int main(int argc, char *argv[])
+{
+	testAccess();
+	testInline();
+	testKernels();
+	testIterator();
+	testVector();
+	testSmallVector();
+	testParallel();
+	testAllocator();
+	testBufferedIO();
+
+	std::cout << "All tests passed" << std::endl;
+	return 0;
+}
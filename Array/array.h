@@ -3,26 +3,55 @@
 
 // Libraries
 #include <new>          // bad alloc
-#include <stdexcept>    // out_of_range
-//#include <iterator>
+#include <stdexcept>    // out_of_range, invalid_argument
+#include <iterator>     // iterator tags, reverse_iterator
 #include <cstddef>
+#include <memory>       // allocator, allocator_traits
+#include <type_traits>  // true_type, false_type
+#include <utility>      // move, swap, declval
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+#include "kernels.h"
 
 /**
  * My notes:
  *  - This class doesn't support initializing or assigning arrays of diffrent
  *    sizes.
+ *  - Small arrays on the default allocator keep their elements inline, like
+ *    std::array, so they cost no allocation and at() no extra indirection.
+ *    Above InlineBytes, or with any other allocator, elements are on the
+ *    heap. Inline arrays of literal types can be built, filled, indexed and
+ *    iterated in constant expressions (C++14).
+ *  - fill, copies, comparisons, sum, min, max and find run on the vector
+ *    kernels in kernels.h (memset/memcpy for trivially copyable types).
+ *  - Iterators are contiguous (std::contiguous_iterator in C++20) with the
+ *    standard traits, so std algorithms and ranges take them as they take
+ *    pointers.
  */
 
 
+/**
+ * Iterator over contiguous elements, a thin wrapper of T*. The const version
+ * is RandomAccessIterator<const T>, a non-const iterator converts to it.
+ */
 template<class T>
-class RandomAccessIterator
-    : public std::iterator<std::random_access_iterator_tag, T*> {
+class RandomAccessIterator {
 public:
+    typedef std::random_access_iterator_tag iterator_category;
+#if __cplusplus >= 202002L
+    typedef std::contiguous_iterator_tag iterator_concept;
+#endif
+    typedef typename std::remove_cv<T>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* pointer;
+    typedef T& reference;
+
 // Life Cycle
 
     /** Default constructor
      */
-    RandomAccessIterator(void)
+    constexpr RandomAccessIterator(void)
         : ptr(nullptr)
     {
     }
@@ -31,7 +60,7 @@ public:
      *
      * @param ptr_      Pointer to a container elemenet.
      */
-    RandomAccessIterator(T* ptr_)
+    constexpr RandomAccessIterator(T* ptr_)
         : ptr(ptr_)
     {
     }
@@ -40,7 +69,15 @@ public:
      *
      * @param from      Iterator that is to be copied.
      */
-    RandomAccessIterator(const RandomAccessIterator& from)
+    constexpr RandomAccessIterator(const RandomAccessIterator& from) = default;
+
+    /** Converting constructor, iterator to const iterator
+     *
+     * @param from      Iterator that is to be converted.
+     */
+    template<class U, class = typename std::enable_if<
+                          std::is_convertible<U*, T*>::value>::type>
+    constexpr RandomAccessIterator(const RandomAccessIterator<U>& from)
         : ptr(from.ptr)
     {
     }
@@ -50,17 +87,17 @@ public:
     /** Assignment operator
      *
      * @param from      Iterator that is to be assigned from.
+     * @return          Reference to this object.
      */
-    const RandomAccessIterator& operator=(const RandomAccessIterator& from)
-    {
-        this->ptr = from.ptr;
-    }
+    constexpr RandomAccessIterator& operator=(const RandomAccessIterator& from)
+        = default;
 
     /** Equal to operator
      *
      * @param that      Iterator to compare this object with.
      */
-    bool operator==(const RandomAccessIterator& that)
+    template<class U>
+    constexpr bool operator==(const RandomAccessIterator<U>& that) const
     {
         return this->ptr == that.ptr;
     }
@@ -69,7 +106,8 @@ public:
      *
      * @param that      Iterator to compare this object with.
      */
-    bool operator!=(const RandomAccessIterator& that)
+    template<class U>
+    constexpr bool operator!=(const RandomAccessIterator<U>& that) const
     {
         return this->ptr != that.ptr;
     }
@@ -78,7 +116,8 @@ public:
      *
      * @param that      Iterator to compare this object with.
      */
-    bool operator>(const RandomAccessIterator& that)
+    template<class U>
+    constexpr bool operator>(const RandomAccessIterator<U>& that) const
     {
         return this->ptr > that.ptr;
     }
@@ -87,7 +126,8 @@ public:
      *
      * @param that      Iterator to compare this object with.
      */
-    bool operator>=(const RandomAccessIterator& that)
+    template<class U>
+    constexpr bool operator>=(const RandomAccessIterator<U>& that) const
     {
         return this->ptr >= that.ptr;
     }
@@ -96,7 +136,8 @@ public:
      *
      * @param that      Iterator to compare this object with.
      */
-    bool operator<(const RandomAccessIterator& that)
+    template<class U>
+    constexpr bool operator<(const RandomAccessIterator<U>& that) const
     {
         return this->ptr < that.ptr;
     }
@@ -105,7 +146,8 @@ public:
      *
      * @param that      Iterator to compare this object with.
      */
-    bool operator <=(const RandomAccessIterator& that)
+    template<class U>
+    constexpr bool operator<=(const RandomAccessIterator<U>& that) const
     {
         return this->ptr <= that.ptr;
     }
@@ -116,7 +158,7 @@ public:
      *
      * @return          Reference to this object.
      */
-    RandomAccessIterator& operator++(void)
+    constexpr RandomAccessIterator& operator++(void)
     {
         ++this->ptr;
         return *this;
@@ -124,9 +166,9 @@ public:
 
     /** Postfix increment operator
      *
-     * @return          Rvalue object with post decrement data.
+     * @return          Rvalue object with pre increment data.
      */
-    RandomAccessIterator operator++(int)
+    constexpr RandomAccessIterator operator++(int)
     {
         RandomAccessIterator<T> tmp(*this);
         ++this->ptr;
@@ -137,57 +179,55 @@ public:
      *
      * @return          Reference to this object.
      */
-    RandomAccessIterator& operator--(void)
+    constexpr RandomAccessIterator& operator--(void)
     {
-        ++this->ptr;
+        --this->ptr;
         return *this;
     }
 
     /** Postfix decrement operator
      *
-     * @return          Rvalue object with post decrement data.
+     * @return          Rvalue object with pre decrement data.
      */
-    RandomAccessIterator operator--(int)
+    constexpr RandomAccessIterator operator--(int)
     {
         RandomAccessIterator<T> tmp(*this);
-        ++this->ptr;
+        --this->ptr;
         return tmp;
     }
 
-    /** Addition operator (iterator version)
+    /** Subtraction operator (iterator version)
      *
-     * @param that      Iterator to add with this object.
-     * @return          Rvalue object with result.
+     * @param that      Iterator to subtract from this object.
+     * @return          Number of elements from that to this object.
      */
-    RandomAccessIterator operator+(const RandomAccessIterator& that)
+    template<class U>
+    constexpr difference_type operator-(const RandomAccessIterator<U>& that)
+        const
     {
-        RandomAccessIterator<T> tmp(*this);
-        tmp.ptr += tmp.ptr + that.ptr;
-        return tmp;
+        return this->ptr - that.ptr;
     }
 
-    /** Subtraction  operator (iterator version)
+    /** Addition operator (integer version)
      *
-     * @param that      Iterator to subtract with this object.
+     * @param i         Amount of incremenets from current iterator positition.
      * @return          Rvalue object with result.
      */
-    RandomAccessIterator operator-(const RandomAccessIterator& that)
+    constexpr RandomAccessIterator operator+(difference_type i) const
     {
-        RandomAccessIterator<T> tmp(*this);
-        tmp.ptr -= (tmp.ptr - that.ptr);
-        return tmp;
+        return RandomAccessIterator<T>(this->ptr + i);
     }
 
-    /** Addition operator (integer version)
+    /** Addition operator (integer first version)
      *
-     * @param i         Amount of incremenets from current iterator positition.
+     * @param i         Amount of incremenets from it.
+     * @param it        Iterator to start from.
      * @return          Rvalue object with result.
      */
-    RandomAccessIterator operator+(int i)
+    friend constexpr RandomAccessIterator operator+(difference_type i,
+        const RandomAccessIterator& it)
     {
-        RandomAccessIterator<T> tmp(*this);
-        tmp.ptr += i;
-        return tmp;
+        return it + i;
     }
 
     /** Subtraction operator (integer versino)
@@ -195,11 +235,9 @@ public:
      * @param i         Amount of decrements from current iterator position.
      * @return          Rvalue object with result.
      */
-    RandomAccessIterator operator-(int i)
+    constexpr RandomAccessIterator operator-(difference_type i) const
     {
-        RandomAccessIterator<T> tmp(*this);
-        tmp.ptr -= i; 
-        return tmp;
+        return RandomAccessIterator<T>(this->ptr - i);
     }
 
     /** Addition assignment with integer
@@ -207,7 +245,7 @@ public:
      * @param i         Amount of incremenets from current iterator position.
      * @return          Reference to this object.
      */
-    RandomAccessIterator& operator+=(int i)
+    constexpr RandomAccessIterator& operator+=(difference_type i)
     {
         this->ptr += i;
         return *this;
@@ -218,7 +256,7 @@ public:
      * @param i         Amount of decrements from current iterator position.
      * @return          Reference to this object.
      */
-    RandomAccessIterator& operator-=(int i)
+    constexpr RandomAccessIterator& operator-=(difference_type i)
     {
         this->ptr -= i;
         return *this;
@@ -239,44 +277,36 @@ public:
 // Access
 
     /** Dereference operator
+     *
+     * Constness is the element's (T), not the iterator's, like a pointer.
      *
      * @return          Reference to the iterators current element.
      */
-    T& operator*(void)
+    constexpr T& operator*(void) const
     {
         return *this->ptr;
     }
 
-    /** Dereference operator (constant version)
+    /** Member access operator
      *
-     * @return          Constant reference to the iterators current element.
+     * @return          Pointer to the iterators current element.
      */
-    const T& operator*(void) const
+    constexpr T* operator->(void) const
     {
-        return *this->ptr;
+        return this->ptr;
     }
 
-    // -> operator ?
-
     /** Offset dereference operator
      *
      * @return          Reference to the indexed elemenet.
      */
-    T& operator[](int i)
-    {
-        return *(this->ptr + i);
-    }
-
-    /** Offset dereference operator (constant version)
-     *
-     * @return          Constant reference to the indexed element.
-     */
-    const T& operator[](int i) const
+    constexpr T& operator[](difference_type i) const
     {
         return *(this->ptr + i);
     }
 
 private:
+    template<class U> friend class RandomAccessIterator;
     
     /** Pointer to iterators current element.
      */
@@ -285,47 +315,284 @@ private:
 };
 
 
-template<class T, std::size_t N>
-class array {
-public:
-    typedef RandomAccessIterator<T> iterator;
+/**
+ * Tells if an array keeps its elements inline. Only arrays on the default
+ * allocator qualify, anything else asked for its storage to come from Alloc.
+ */
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+struct ArrayIsInline
+    : std::integral_constant<bool,
+          std::is_same<Alloc, std::allocator<T>>::value &&
+          (N > 0) && N * sizeof(T) <= InlineBytes> {
+};
+
+/**
+ * Tells if constructing a T through Alloc is placement new, so that trivially
+ * copyable elements can be copied into fresh storage in bulk.
+ */
+template<class T, class Alloc>
+struct ArrayPlainConstruct {
+    template<class A>
+    static auto custom(int) -> decltype(
+        std::declval<A&>().construct(std::declval<T*>(),
+                                     std::declval<const T&>()),
+        std::true_type());
+    template<class A>
+    static std::false_type custom(...);
+
+    static const bool value =
+        std::is_trivially_copyable<T>::value &&
+        (std::is_same<Alloc, std::allocator<T>>::value ||
+         !decltype(custom<Alloc>(0))::value);
+};
+
+/**
+ * Element storage of an array, specialized below on whether the elements are
+ * inline or on the heap.
+ */
+template<class T, std::size_t N, class Alloc, bool Inline>
+class ArrayStorage;
 
-    iterator begin(void) { return iterator(ptr); }
-    iterator end(void) { return iterator(ptr + N); }
+/**
+ * Heap storage, elements come from Alloc and the object holds a pointer.
+ */
+template<class T, std::size_t N, class Alloc>
+class ArrayStorage<T, N, Alloc, false> {
+public:
+    typedef ArrayStorage<T, N, Alloc, false> Storage;
 
 // Life Cycle
-    
+
     /** Constructor
-     * 
-     * @bad_alloc       Generated if new failed.
+     *
+     * Elements are value initialized.
+     *
+     * @param Allocator Allocator the storage is taken from.
+     *
+     * @bad_alloc       Generated if the allocation failed.
      */
-    array(void);
+    explicit ArrayStorage(const Alloc& Allocator = Alloc());
 
     /** Copy constructor
+     *
+     * The allocator is obtained through select_on_container_copy_construction.
      *
      * @param from      Constant reference to an object to copy.
      */
-    array(const array<T, N>& from);
+    ArrayStorage(const Storage& from);
+
+    /** Copy constructor (allocator version)
+     *
+     * @param from      Constant reference to an object to copy.
+     * @param Allocator Allocator the storage is taken from.
+     */
+    ArrayStorage(const Storage& from, const Alloc& Allocator);
 
     /** Move constructor
+     *
+     * Steals the storage, from gets fresh value initialized elements from
+     * its allocator so it stays a usable array of N.
      *
      * @param from      Rvalue reference to an object to steal.
      */
-    array(array<T, N>&& from);
+    ArrayStorage(Storage&& from);
 
     /** Destructor
      */
-    ~array(void);
+    ~ArrayStorage(void);
 
 // Operators
 
+    /** Assignment operator
+     *
+     * Elements are copied into the existing storage. The allocator is taken
+     * over from from only if Alloc propagates on copy assignment.
+     *
+     * @param from      Constant reference to an object to copy.
+     * @return          Reference to this object.
+     */
+    Storage& operator=(const Storage& from);
+
+    /** Move assignment operator
+     *
+     * Storage is swapped if Alloc propagates on move assignment or the
+     * allocators are equal, otherwise elements are moved one by one.
+     *
+     * @param from      Rvalue reference to an object to steal.
+     * @return          Reference to this object.
+     */
+    Storage& operator=(Storage&& from);
+
+// Operations
+
+    /** Swap storage with another array
+     *
+     * Allocators are exchanged if Alloc propagates on swap.
+     *
+     * @param with      Storage to swap with.
+     *
+     * @invalid_argument Generated if the allocators don't propagate and
+     *                  differ.
+     */
+    void swap(Storage& with);
+
+// Access
+
+    T* elements(void) { return ptr; }
+    const T* elements(void) const { return ptr; }
+    Alloc get_allocator(void) const { return alloc; }
+
+private:
+    typedef std::allocator_traits<Alloc> AllocTraits;
+
+    /** Allocator the storage came from
+     */
+    Alloc alloc;
+
+    /** Ptr to array start
+     */
+    T* ptr;
+
+    // Helper functions
+    T* create(const T* from);
+    void destroy(void);
+    static void swapAlloc(Alloc& a, Alloc& b, std::true_type);
+    static void swapAlloc(Alloc& a, Alloc& b, std::false_type);
+};
+
+/**
+ * Inline storage, elements are a member like in std::array. Copies and moves
+ * are element wise and nothing is ever allocated, which also makes the array
+ * a literal type when T is one.
+ */
+template<class T, std::size_t N, class Alloc>
+class ArrayStorage<T, N, Alloc, true> {
+public:
+    typedef ArrayStorage<T, N, Alloc, true> Storage;
+
+    constexpr ArrayStorage(void) : elems() {}
+    constexpr explicit ArrayStorage(const Alloc&) : elems() {}
+    constexpr ArrayStorage(const Storage& from, const Alloc&)
+        : Storage(from) {}
+
+    /** Swap elements with another array
+     *
+     * @param with      Storage to swap with.
+     */
+    void swap(Storage& with)
+    {
+        using std::swap;
+        for (std::size_t i = 0; i < N; i++)
+            swap(elems[i], with.elems[i]);
+    }
+
+    constexpr T* elements(void) { return elems; }
+    constexpr const T* elements(void) const { return elems; }
+    constexpr Alloc get_allocator(void) const { return Alloc(); }
+
+private:
+    T elems[N];
+};
+
+
+template<class T, std::size_t N, class Alloc = std::allocator<T>,
+         std::size_t InlineBytes = 1024>
+class array
+    : private ArrayStorage<T, N, Alloc,
+                           ArrayIsInline<T, N, Alloc, InlineBytes>::value> {
+    typedef ArrayStorage<T, N, Alloc,
+                         ArrayIsInline<T, N, Alloc, InlineBytes>::value>
+        Storage;
+
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef RandomAccessIterator<T> iterator;
+    typedef RandomAccessIterator<const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** True if elements are stored inside the object rather than on the heap.
+     */
+    static constexpr bool IS_INLINE =
+        ArrayIsInline<T, N, Alloc, InlineBytes>::value;
+
+    constexpr iterator begin(void) { return iterator(this->elements()); }
+    constexpr iterator end(void) { return iterator(this->elements() + N); }
+    constexpr const_iterator begin(void) const { return cbegin(); }
+    constexpr const_iterator end(void) const { return cend(); }
+    constexpr const_iterator cbegin(void) const
+    {
+        return const_iterator(this->elements());
+    }
+    constexpr const_iterator cend(void) const
+    {
+        return const_iterator(this->elements() + N);
+    }
+    reverse_iterator rbegin(void) { return reverse_iterator(end()); }
+    reverse_iterator rend(void) { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin(void) const { return crbegin(); }
+    const_reverse_iterator rend(void) const { return crend(); }
+    const_reverse_iterator crbegin(void) const
+    {
+        return const_reverse_iterator(cend());
+    }
+    const_reverse_iterator crend(void) const
+    {
+        return const_reverse_iterator(cbegin());
+    }
+
+// Life Cycle
+    
+    /** Constructor
+     * 
+     * Elements are value initialized, inline if IS_INLINE, otherwise in
+     * storage from a default constructed Alloc. Copies, moves and destruction
+     * follow the storage, see ArrayStorage.
+     *
+     * @bad_alloc       Generated if new failed.
+     */
+    constexpr array(void);
+
+    /** Constructor (allocator version)
+     *
+     * @param Allocator Allocator the storage is taken from.
+     *
+     * @bad_alloc       Generated if the allocation failed.
+     */
+    constexpr explicit array(const Alloc& Allocator);
+
+    /** Copy constructor (allocator version)
+     *
+     * @param from      Constant reference to an object to copy.
+     * @param Allocator Allocator the storage is taken from.
+     */
+    array(const array& from, const Alloc& Allocator);
+
 // Operations
 
     /** Fills the entire array with a value.
      *
      * @param val       Value to fill the array with.
      */
-    void fill(const T& val);
+    constexpr void fill(const T& val);
+
+    /** Swap contents with another array
+     *
+     * Heap storage is exchanged, allocators only if Alloc propagates on swap.
+     * Inline elements are swapped one by one.
+     *
+     * @param with      Array to swap with.
+     *
+     * @invalid_argument Generated if the allocators don't propagate and
+     *                  differ.
+     */
+    void swap(array& with);
 
 // Access
     
@@ -336,75 +603,388 @@ public:
      *
      * @out_of_range    Genererade if invalid index.
      */
-    T& at(std::size_t i);
+    constexpr T& at(std::size_t i);
 
     /** Constant version of 'at'
      */
-    const T& at(std::size_t i) const;
+    constexpr const T& at(std::size_t i) const;
 
-// Iterators
-    
-private:
-    /** Ptr to array start
+    /** Get the storage
+     *
+     * Elements are contiguous, eg. writeBinary(out, a.data(), N) dumps them
+     * in one block.
+     *
+     * @return          Pointer to the first element.
      */
-    T* ptr;
+    constexpr T* data(void);
+
+    /** Constant version of 'data'
+     */
+    constexpr const T* data(void) const;
+
+    /** Get the allocator
+     *
+     * @return          Copy of the allocator the storage came from.
+     */
+    Alloc get_allocator(void) const;
+
+    /** Find the first element equal to a value
+     *
+     * @param val       Value to look for.
+     * @return          Iterator to the element, end() if there is none.
+     */
+    iterator find(const T& val);
+
+    /** Constant version of 'find'
+     */
+    const_iterator find(const T& val) const;
+
+// Reductions
+
+    /** Sum of all elements
+     *
+     * Floating point sums are added lane wise, the last bits may differ from
+     * a left to right loop.
+     *
+     * @return          The sum.
+     */
+    T sum(void) const;
+
+    /** Smallest element, unspecified if there are NaNs
+     */
+    T min(void) const;
+
+    /** Largest element, unspecified if there are NaNs
+     */
+    T max(void) const;
 };
 
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr bool array<T, N, Alloc, InlineBytes>::IS_INLINE;
+
 ///////////////////////////// Life Cycle ///////////////////////////////////////
 
-template<class T, std::size_t N>
-array<T, N>::array(void)
-    : ptr(new T[N])
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr array<T, N, Alloc, InlineBytes>::array(void)
+    : Storage()
+{
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr array<T, N, Alloc, InlineBytes>::array(const Alloc& Allocator)
+    : Storage(Allocator)
 {
 }
 
-template<class T, std::size_t N>
-array<T, N>::array(const array<T, N>& from)
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+array<T, N, Alloc, InlineBytes>::array(const array& from,
+                                       const Alloc& Allocator)
+    : Storage(from, Allocator)
 {
-    // todo
 }
 
-template<class T, std::size_t N>
-array<T, N>::array(array<T, N>&& from)
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>::ArrayStorage(const Alloc& Allocator)
+    : alloc(Allocator), ptr(create(nullptr))
 {
-    // todo
 }
 
-template<class T, std::size_t N>
-array<T, N>::~array(void)
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>::ArrayStorage(const Storage& from)
+    : alloc(AllocTraits::select_on_container_copy_construction(from.alloc)),
+      ptr(create(from.ptr))
 {
-    delete[] ptr;
+}
+
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>::ArrayStorage(const Storage& from,
+                                               const Alloc& Allocator)
+    : alloc(Allocator), ptr(create(from.ptr))
+{
+}
+
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>::ArrayStorage(Storage&& from)
+    : alloc(from.alloc), ptr(from.create(nullptr))
+{
+    std::swap(ptr, from.ptr);
+}
+
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>::~ArrayStorage(void)
+{
+    destroy();
+}
+
+///////////////////////////// Operators ////////////////////////////////////////
+
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>&
+ArrayStorage<T, N, Alloc, false>::operator=(const Storage& from)
+{
+    typedef typename AllocTraits::propagate_on_container_copy_assignment
+        Propagate;
+
+    if (&from == this)
+        return *this;
+
+    if (ptr == nullptr || (Propagate::value && !(alloc == from.alloc))) {
+        // Storage has to come from from's allocator (or there is none)
+        Storage tmp(from, Propagate::value ? from.alloc : alloc);
+        std::swap(ptr, tmp.ptr);
+        swapAlloc(alloc, tmp.alloc, Propagate());
+    }
+    else {
+        Kernels::copy(from.ptr, N, ptr);
+    }
+
+    return *this;
+}
+
+template<class T, std::size_t N, class Alloc>
+ArrayStorage<T, N, Alloc, false>&
+ArrayStorage<T, N, Alloc, false>::operator=(Storage&& from)
+{
+    typedef typename AllocTraits::propagate_on_container_move_assignment
+        Propagate;
+
+    if (&from == this)
+        return *this;
+
+    if (Propagate::value || alloc == from.alloc) {
+        std::swap(ptr, from.ptr);   // old storage goes with from
+        swapAlloc(alloc, from.alloc, Propagate());
+    }
+    else if (ptr == nullptr) {
+        Storage tmp(from, alloc);
+        std::swap(ptr, tmp.ptr);
+    }
+    else {
+        Kernels::move(from.ptr, N, ptr);
+    }
+
+    return *this;
 }
 
 ///////////////////////////// Operations ///////////////////////////////////////
 
-template<class T, std::size_t N>
-void array<T, N>::fill(const T& val)
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr void array<T, N, Alloc, InlineBytes>::fill(const T& val)
+{
+    T* elems = this->elements();
+#if defined(__GNUC__)
+    if (!__builtin_is_constant_evaluated()) {
+        Kernels::fill(elems, N, val);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < N; i++)
+        elems[i] = val;
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+void array<T, N, Alloc, InlineBytes>::swap(array& with)
 {
-    // todo
+    Storage::swap(with);
 }
 
+template<class T, std::size_t N, class Alloc>
+void ArrayStorage<T, N, Alloc, false>::swap(Storage& with)
+{
+    typedef typename AllocTraits::propagate_on_container_swap Propagate;
+
+    if (!Propagate::value && !(alloc == with.alloc))
+        throw std::invalid_argument("array::swap");
+
+    std::swap(ptr, with.ptr);
+    swapAlloc(alloc, with.alloc, Propagate());
+}
 
 ///////////////////////////// Access ///////////////////////////////////////////
 
-template<class T, std::size_t N>
-T& array<T, N>::at(std::size_t i)
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr T& array<T, N, Alloc, InlineBytes>::at(std::size_t i)
 {
     if (i >= N)
         throw std::out_of_range("array::at");
 
-    return *(ptr + i);
+    return *(this->elements() + i);
 }
 
-template<class T, std::size_t N>
-const T& array<T, N>::at(std::size_t i) const
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr const T& array<T, N, Alloc, InlineBytes>::at(std::size_t i) const
 {
     if (i >= N)
         throw std::out_of_range("array::at");
 
-    return *(ptr + i);
+    return *(this->elements() + i);
 }
 
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr T* array<T, N, Alloc, InlineBytes>::data(void)
+{
+    return this->elements();
+}
 
-#endif // ARRAY_2_H
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+constexpr const T* array<T, N, Alloc, InlineBytes>::data(void) const
+{
+    return this->elements();
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+Alloc array<T, N, Alloc, InlineBytes>::get_allocator(void) const
+{
+    return Storage::get_allocator();
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+typename array<T, N, Alloc, InlineBytes>::iterator
+array<T, N, Alloc, InlineBytes>::find(const T& val)
+{
+    return iterator(data() + Kernels::find(data(), N, val));
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+typename array<T, N, Alloc, InlineBytes>::const_iterator
+array<T, N, Alloc, InlineBytes>::find(const T& val) const
+{
+    return const_iterator(data() + Kernels::find(data(), N, val));
+}
+
+///////////////////////////// Reductions ///////////////////////////////////////
 
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+T array<T, N, Alloc, InlineBytes>::sum(void) const
+{
+    return Kernels::sum(data(), N);
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+T array<T, N, Alloc, InlineBytes>::min(void) const
+{
+    return Kernels::min(data(), N);
+}
+
+template<class T, std::size_t N, class Alloc, std::size_t InlineBytes>
+T array<T, N, Alloc, InlineBytes>::max(void) const
+{
+    return Kernels::max(data(), N);
+}
+
+///////////////////////////// Comparison ///////////////////////////////////////
+
+template<class T, std::size_t N, class A1, std::size_t B1, class A2,
+         std::size_t B2>
+bool operator==(const array<T, N, A1, B1>& a, const array<T, N, A2, B2>& b)
+{
+    return Kernels::equal(a.data(), b.data(), N);
+}
+
+template<class T, std::size_t N, class A1, std::size_t B1, class A2,
+         std::size_t B2>
+bool operator!=(const array<T, N, A1, B1>& a, const array<T, N, A2, B2>& b)
+{
+    return !Kernels::equal(a.data(), b.data(), N);
+}
+
+template<class T, std::size_t N, class A1, std::size_t B1, class A2,
+         std::size_t B2>
+bool operator<(const array<T, N, A1, B1>& a, const array<T, N, A2, B2>& b)
+{
+    return Kernels::compare(a.data(), b.data(), N) < 0;
+}
+
+template<class T, std::size_t N, class A1, std::size_t B1, class A2,
+         std::size_t B2>
+bool operator>(const array<T, N, A1, B1>& a, const array<T, N, A2, B2>& b)
+{
+    return Kernels::compare(a.data(), b.data(), N) > 0;
+}
+
+template<class T, std::size_t N, class A1, std::size_t B1, class A2,
+         std::size_t B2>
+bool operator<=(const array<T, N, A1, B1>& a, const array<T, N, A2, B2>& b)
+{
+    return Kernels::compare(a.data(), b.data(), N) <= 0;
+}
+
+template<class T, std::size_t N, class A1, std::size_t B1, class A2,
+         std::size_t B2>
+bool operator>=(const array<T, N, A1, B1>& a, const array<T, N, A2, B2>& b)
+{
+    return Kernels::compare(a.data(), b.data(), N) >= 0;
+}
+
+///////////////////////////// Private //////////////////////////////////////////
+
+template<class T, std::size_t N, class Alloc>
+T* ArrayStorage<T, N, Alloc, false>::create(const T* from)
+{
+    // Copies of from, value initialized elements if from is nullptr
+    T* storage = AllocTraits::allocate(alloc, N);
+    if (ArrayPlainConstruct<T, Alloc>::value) {
+        if (from != nullptr) {
+            Kernels::copy(from, N, storage);
+            return storage;
+        }
+        if (std::is_trivial<T>::value) {
+            Kernels::fill(storage, N, T());
+            return storage;
+        }
+    }
+
+    std::size_t i = 0;
+    try {
+        for (; i < N; i++)
+            if (from != nullptr)
+                AllocTraits::construct(alloc, storage + i, from[i]);
+            else
+                AllocTraits::construct(alloc, storage + i);
+    }
+    catch (...) {
+        while (i-- > 0)
+            AllocTraits::destroy(alloc, storage + i);
+        AllocTraits::deallocate(alloc, storage, N);
+        throw;
+    }
+
+    return storage;
+}
+
+template<class T, std::size_t N, class Alloc>
+void ArrayStorage<T, N, Alloc, false>::destroy(void)
+{
+    if (ptr == nullptr)
+        return;
+
+    for (std::size_t i = 0; i < N; i++)
+        AllocTraits::destroy(alloc, ptr + i);
+    AllocTraits::deallocate(alloc, ptr, N);
+    ptr = nullptr;
+}
+
+template<class T, std::size_t N, class Alloc>
+void ArrayStorage<T, N, Alloc, false>::swapAlloc(Alloc& a, Alloc& b,
+                                                 std::true_type)
+{
+    using std::swap;
+    swap(a, b);
+}
+
+template<class T, std::size_t N, class Alloc>
+void ArrayStorage<T, N, Alloc, false>::swapAlloc(Alloc&, Alloc&,
+                                                 std::false_type)
+{
+    // Allocator doesn't propagate, each array keeps its own
+}
+
+#if __cplusplus >= 201703L
+namespace pmr {
+    template<class T, std::size_t N>
+    using array = ::array<T, N, std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
+
+#endif // ARRAY_2_H
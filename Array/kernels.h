@@ -0,0 +1,906 @@
+#ifndef ARRAY_KERNELS_H
+#define ARRAY_KERNELS_H
+
+// Libraries
+#include <cstddef>      // size_t
+#include <cstdint>      // int8_t ... int64_t
+#include <cstring>      // memset, memcpy
+#include <type_traits>  // is_trivially_copyable, conditional
+#include <utility>      // move
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ARRAY_KERNELS_X86
+#define ARRAY_KERNELS_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+/**
+ * My notes:
+ *  - Bulk operations over contiguous elements, the work behind array's
+ *    fill, copies, comparisons and reductions. Each vector kernel exists for
+ *    AVX2 and SSE2, level() picks one at run time. Types that don't map to
+ *    vector lanes take a plain loop.
+ *  - Lanes exist for integers, enums, pointers and bool, compared bit by
+ *    bit, and for float and double, compared with == (NaN never matches,
+ *    -0.0 matches 0.0). sum, min and max are vectorized for int32_t, float
+ *    and double.
+ *  - Vector sums add in a different order than a loop would, float and
+ *    double results may differ in the last bits. min and max are unspecified
+ *    with NaN in the range.
+ *  - fill is memset when all bytes of the value are equal (eg. zeroing),
+ *    copy and move are memcpy for trivially copyable types. libc already
+ *    runs those at memory bandwidth.
+ */
+class Kernels {
+public:
+    enum Level { SCALAR, SSE2, AVX2 };
+
+    // Reductions, tags picking the lane operation
+    struct Add {};
+    struct Min {};
+    struct Max {};
+
+    /** Instruction set in use
+     *
+     * Detected on the first call. It may be lowered, eg. to test the slower
+     * paths, raising it above what the CPU supports is undefined.
+     *
+     * @return          Reference to the current level.
+     */
+    static Level& level(void);
+
+    /** Assigns val to n elements
+     *
+     * @param dst       First element.
+     * @param n         Number of elements.
+     * @param val       Value to fill with.
+     */
+    template<class T>
+    static void fill(T* dst, std::size_t n, const T& val);
+
+    /** Copy assigns n elements, ranges must not overlap
+     *
+     * @param src       First element to copy.
+     * @param n         Number of elements.
+     * @param dst       First element to assign.
+     */
+    template<class T>
+    static void copy(const T* src, std::size_t n, T* dst);
+
+    /** Move assigns n elements, ranges must not overlap
+     *
+     * @param src       First element to move.
+     * @param n         Number of elements.
+     * @param dst       First element to assign.
+     */
+    template<class T>
+    static void move(T* src, std::size_t n, T* dst);
+
+    /** Finds the first position where two ranges differ
+     *
+     * @param a         First range.
+     * @param b         Second range.
+     * @param n         Number of elements in each.
+     * @return          Index of the first unequal pair, n if there is none.
+     */
+    template<class T>
+    static std::size_t mismatch(const T* a, const T* b, std::size_t n);
+
+    /** Equality of two ranges
+     *
+     * @return          True if all n pairs are equal.
+     */
+    template<class T>
+    static bool equal(const T* a, const T* b, std::size_t n);
+
+    /** Lexicographic comparison of two ranges
+     *
+     * @return          Negative if a is less, positive if b is less, 0 if
+     *                  neither is.
+     */
+    template<class T>
+    static int compare(const T* a, const T* b, std::size_t n);
+
+    /** Finds the first element equal to val
+     *
+     * @return          Its index, n if there is none.
+     */
+    template<class T>
+    static std::size_t find(const T* a, std::size_t n, const T& val);
+
+    /** Sum of n elements
+     *
+     * @return          The sum, T() if n is 0.
+     */
+    template<class T>
+    static T sum(const T* a, std::size_t n);
+
+    /** Smallest of n elements, n must be larger than 0
+     */
+    template<class T>
+    static T min(const T* a, std::size_t n);
+
+    /** Largest of n elements, n must be larger than 0
+     */
+    template<class T>
+    static T max(const T* a, std::size_t n);
+
+private:
+    // Integer lane of the same size, void if there is none
+    template<std::size_t Size> struct IntOf { typedef void type; };
+
+    /**
+     * Lane type T is processed as, void if T takes the plain loops.
+     */
+    template<class T>
+    struct LaneOf {
+        typedef typename std::conditional<
+            std::is_same<T, float>::value || std::is_same<T, double>::value,
+            T,
+            typename std::conditional<
+                std::is_integral<T>::value || std::is_enum<T>::value ||
+                std::is_pointer<T>::value,
+                typename IntOf<sizeof(T)>::type,
+                void>::type>::type type;
+    };
+
+    /**
+     * Types sum, min and max are vectorized for.
+     */
+    template<class T>
+    struct Reducible
+        : std::integral_constant<bool, std::is_same<T, std::int32_t>::value ||
+                                       std::is_same<T, float>::value ||
+                                       std::is_same<T, double>::value> {
+    };
+
+    static Level detect(void);
+
+    template<class T>
+    static bool uniformBytes(const T& val, std::true_type);
+    template<class T>
+    static bool uniformBytes(const T&, std::false_type) { return false; }
+
+    template<class T>
+    static std::size_t fillLanes(T* dst, std::size_t n, const T& val, void*);
+    template<class T, class L>
+    static std::size_t fillLanes(T* dst, std::size_t n, const T& val, L*);
+
+    template<class T>
+    static void copyTo(const T* src, std::size_t n, T* dst, std::true_type);
+    template<class T>
+    static void copyTo(const T* src, std::size_t n, T* dst, std::false_type);
+    template<class T>
+    static void moveTo(T* src, std::size_t n, T* dst, std::true_type);
+    template<class T>
+    static void moveTo(T* src, std::size_t n, T* dst, std::false_type);
+
+    template<class T>
+    static std::size_t mismatchLanes(const T* a, const T* b, std::size_t n,
+                                     void*);
+    template<class T, class L>
+    static std::size_t mismatchLanes(const T* a, const T* b, std::size_t n,
+                                     L*);
+
+    template<class T>
+    static std::size_t findLanes(const T* a, std::size_t n, const T& val,
+                                 void*);
+    template<class T, class L>
+    static std::size_t findLanes(const T* a, std::size_t n, const T& val, L*);
+
+    template<class T, class Op>
+    static T reduce(const T* a, std::size_t n, Op op, std::true_type);
+    template<class T, class Op>
+    static T reduce(const T* a, std::size_t n, Op op, std::false_type);
+
+    template<class T>
+    static T apply(const T& a, const T& b, Add) { return a + b; }
+    template<class T>
+    static T apply(const T& a, const T& b, Min) { return b < a ? b : a; }
+    template<class T>
+    static T apply(const T& a, const T& b, Max) { return a < b ? b : a; }
+
+#ifdef ARRAY_KERNELS_X86
+    // Vector loops, they process whole vectors only and leave the tail
+    template<class V, class L>
+    static std::size_t fillVec(void* dst, std::size_t n, L val);
+    template<class V, class L>
+    static bool mismatchVec(const void* a, const void* b, std::size_t n,
+                            std::size_t& i);
+    template<class V, class L>
+    static bool findVec(const void* a, std::size_t n, L val, std::size_t& i);
+    template<class V, class L, class Op>
+    static L reduceVec(const L* a, std::size_t n, Op op);
+    template<class V, class L>
+    ARRAY_KERNELS_AVX2
+    static std::size_t fillAvx2(void* dst, std::size_t n, L val);
+    template<class V, class L>
+    ARRAY_KERNELS_AVX2
+    static bool mismatchAvx2(const void* a, const void* b, std::size_t n,
+                             std::size_t& i);
+    template<class V, class L>
+    ARRAY_KERNELS_AVX2
+    static bool findAvx2(const void* a, std::size_t n, L val, std::size_t& i);
+    template<class V, class L, class Op>
+    ARRAY_KERNELS_AVX2
+    static L reduceAvx2(const L* a, std::size_t n, Op op);
+#endif
+};
+
+template<> struct Kernels::IntOf<1> { typedef std::int8_t type; };
+template<> struct Kernels::IntOf<2> { typedef std::int16_t type; };
+template<> struct Kernels::IntOf<4> { typedef std::int32_t type; };
+template<> struct Kernels::IntOf<8> { typedef std::int64_t type; };
+
+#ifdef ARRAY_KERNELS_X86
+
+/**
+ * SSE2 operations on a vector of L. eq() gives a mask with BITS bits per
+ * lane, all of them set where the lanes are equal. ALL is the mask of a
+ * fully equal vector.
+ */
+template<class L> struct Sse2Lanes;
+
+template<class L>
+struct Sse2IntLanes {
+    typedef __m128i V;
+    static const std::size_t LANES = 16 / sizeof(L);
+    static const unsigned BITS = sizeof(L);
+    static const unsigned ALL = 0xFFFF;
+
+    static V load(const void* p)
+    {
+        return _mm_loadu_si128(static_cast<const __m128i*>(p));
+    }
+    static void store(void* p, V v)
+    {
+        _mm_storeu_si128(static_cast<__m128i*>(p), v);
+    }
+};
+
+template<>
+struct Sse2Lanes<std::int8_t> : Sse2IntLanes<std::int8_t> {
+    static V splat(std::int8_t v) { return _mm_set1_epi8(v); }
+    static unsigned eq(V a, V b)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+    }
+};
+
+template<>
+struct Sse2Lanes<std::int16_t> : Sse2IntLanes<std::int16_t> {
+    static V splat(std::int16_t v) { return _mm_set1_epi16(v); }
+    static unsigned eq(V a, V b)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b));
+    }
+};
+
+template<>
+struct Sse2Lanes<std::int32_t> : Sse2IntLanes<std::int32_t> {
+    static V splat(std::int32_t v) { return _mm_set1_epi32(v); }
+    static unsigned eq(V a, V b)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi32(a, b));
+    }
+    static V op(V a, V b, Kernels::Add*) { return _mm_add_epi32(a, b); }
+    static V op(V a, V b, Kernels::Min*)
+    {
+        // No pminsd before SSE4.1, select through the comparison mask
+        V gt = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+    }
+    static V op(V a, V b, Kernels::Max*)
+    {
+        V gt = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+    }
+};
+
+template<>
+struct Sse2Lanes<std::int64_t> : Sse2IntLanes<std::int64_t> {
+    static V splat(std::int64_t v) { return _mm_set1_epi64x(v); }
+    static unsigned eq(V a, V b)
+    {
+        // No pcmpeqq before SSE4.1, both halves have to match
+        V e = _mm_cmpeq_epi32(a, b);
+        e = _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_movemask_epi8(e);
+    }
+};
+
+template<>
+struct Sse2Lanes<float> {
+    typedef __m128 V;
+    static const std::size_t LANES = 4;
+    static const unsigned BITS = 1;
+    static const unsigned ALL = 0xF;
+
+    static V load(const void* p)
+    {
+        return _mm_loadu_ps(static_cast<const float*>(p));
+    }
+    static void store(void* p, V v)
+    {
+        _mm_storeu_ps(static_cast<float*>(p), v);
+    }
+    static V splat(float v) { return _mm_set1_ps(v); }
+    static unsigned eq(V a, V b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+    static V op(V a, V b, Kernels::Add*) { return _mm_add_ps(a, b); }
+    static V op(V a, V b, Kernels::Min*) { return _mm_min_ps(a, b); }
+    static V op(V a, V b, Kernels::Max*) { return _mm_max_ps(a, b); }
+};
+
+template<>
+struct Sse2Lanes<double> {
+    typedef __m128d V;
+    static const std::size_t LANES = 2;
+    static const unsigned BITS = 1;
+    static const unsigned ALL = 0x3;
+
+    static V load(const void* p)
+    {
+        return _mm_loadu_pd(static_cast<const double*>(p));
+    }
+    static void store(void* p, V v)
+    {
+        _mm_storeu_pd(static_cast<double*>(p), v);
+    }
+    static V splat(double v) { return _mm_set1_pd(v); }
+    static unsigned eq(V a, V b) { return _mm_movemask_pd(_mm_cmpeq_pd(a, b)); }
+    static V op(V a, V b, Kernels::Add*) { return _mm_add_pd(a, b); }
+    static V op(V a, V b, Kernels::Min*) { return _mm_min_pd(a, b); }
+    static V op(V a, V b, Kernels::Max*) { return _mm_max_pd(a, b); }
+};
+
+/**
+ * AVX2 operations on a vector of L, same interface as Sse2Lanes.
+ */
+template<class L> struct Avx2Lanes;
+
+template<class L>
+struct Avx2IntLanes {
+    typedef __m256i V;
+    static const std::size_t LANES = 32 / sizeof(L);
+    static const unsigned BITS = sizeof(L);
+    static const unsigned ALL = 0xFFFFFFFF;
+
+    ARRAY_KERNELS_AVX2 static V load(const void* p)
+    {
+        return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+    }
+    ARRAY_KERNELS_AVX2 static void store(void* p, V v)
+    {
+        _mm256_storeu_si256(static_cast<__m256i*>(p), v);
+    }
+};
+
+template<>
+struct Avx2Lanes<std::int8_t> : Avx2IntLanes<std::int8_t> {
+    ARRAY_KERNELS_AVX2 static V splat(std::int8_t v)
+    {
+        return _mm256_set1_epi8(v);
+    }
+    ARRAY_KERNELS_AVX2 static unsigned eq(V a, V b)
+    {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+    }
+};
+
+template<>
+struct Avx2Lanes<std::int16_t> : Avx2IntLanes<std::int16_t> {
+    ARRAY_KERNELS_AVX2 static V splat(std::int16_t v)
+    {
+        return _mm256_set1_epi16(v);
+    }
+    ARRAY_KERNELS_AVX2 static unsigned eq(V a, V b)
+    {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b));
+    }
+};
+
+template<>
+struct Avx2Lanes<std::int32_t> : Avx2IntLanes<std::int32_t> {
+    ARRAY_KERNELS_AVX2 static V splat(std::int32_t v)
+    {
+        return _mm256_set1_epi32(v);
+    }
+    ARRAY_KERNELS_AVX2 static unsigned eq(V a, V b)
+    {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b));
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Add*)
+    {
+        return _mm256_add_epi32(a, b);
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Min*)
+    {
+        return _mm256_min_epi32(a, b);
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Max*)
+    {
+        return _mm256_max_epi32(a, b);
+    }
+};
+
+template<>
+struct Avx2Lanes<std::int64_t> : Avx2IntLanes<std::int64_t> {
+    ARRAY_KERNELS_AVX2 static V splat(std::int64_t v)
+    {
+        return _mm256_set1_epi64x(v);
+    }
+    ARRAY_KERNELS_AVX2 static unsigned eq(V a, V b)
+    {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b));
+    }
+};
+
+template<>
+struct Avx2Lanes<float> {
+    typedef __m256 V;
+    static const std::size_t LANES = 8;
+    static const unsigned BITS = 1;
+    static const unsigned ALL = 0xFF;
+
+    ARRAY_KERNELS_AVX2 static V load(const void* p)
+    {
+        return _mm256_loadu_ps(static_cast<const float*>(p));
+    }
+    ARRAY_KERNELS_AVX2 static void store(void* p, V v)
+    {
+        _mm256_storeu_ps(static_cast<float*>(p), v);
+    }
+    ARRAY_KERNELS_AVX2 static V splat(float v) { return _mm256_set1_ps(v); }
+    ARRAY_KERNELS_AVX2 static unsigned eq(V a, V b)
+    {
+        return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Add*)
+    {
+        return _mm256_add_ps(a, b);
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Min*)
+    {
+        return _mm256_min_ps(a, b);
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Max*)
+    {
+        return _mm256_max_ps(a, b);
+    }
+};
+
+template<>
+struct Avx2Lanes<double> {
+    typedef __m256d V;
+    static const std::size_t LANES = 4;
+    static const unsigned BITS = 1;
+    static const unsigned ALL = 0xF;
+
+    ARRAY_KERNELS_AVX2 static V load(const void* p)
+    {
+        return _mm256_loadu_pd(static_cast<const double*>(p));
+    }
+    ARRAY_KERNELS_AVX2 static void store(void* p, V v)
+    {
+        _mm256_storeu_pd(static_cast<double*>(p), v);
+    }
+    ARRAY_KERNELS_AVX2 static V splat(double v) { return _mm256_set1_pd(v); }
+    ARRAY_KERNELS_AVX2 static unsigned eq(V a, V b)
+    {
+        return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Add*)
+    {
+        return _mm256_add_pd(a, b);
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Min*)
+    {
+        return _mm256_min_pd(a, b);
+    }
+    ARRAY_KERNELS_AVX2 static V op(V a, V b, Kernels::Max*)
+    {
+        return _mm256_max_pd(a, b);
+    }
+};
+
+#endif // ARRAY_KERNELS_X86
+
+///////////////////////////// Dispatch /////////////////////////////////////////
+
+inline Kernels::Level& Kernels::level(void)
+{
+    static Level current = detect();
+    return current;
+}
+
+inline Kernels::Level Kernels::detect(void)
+{
+#ifdef ARRAY_KERNELS_X86
+    // SSE2 is part of x86-64
+    return __builtin_cpu_supports("avx2") ? AVX2 : SSE2;
+#else
+    return SCALAR;
+#endif
+}
+
+///////////////////////////// Operations ///////////////////////////////////////
+
+template<class T>
+void Kernels::fill(T* dst, std::size_t n, const T& val)
+{
+    if (uniformBytes(val, std::is_trivially_copyable<T>())) {
+        std::memset(static_cast<void*>(dst),
+                    *reinterpret_cast<const unsigned char*>(&val),
+                    n * sizeof(T));
+        return;
+    }
+
+    std::size_t i = fillLanes(dst, n, val, (typename LaneOf<T>::type*)0);
+    for (; i < n; i++)
+        dst[i] = val;
+}
+
+template<class T>
+void Kernels::copy(const T* src, std::size_t n, T* dst)
+{
+    copyTo(src, n, dst, std::is_trivially_copyable<T>());
+}
+
+template<class T>
+void Kernels::move(T* src, std::size_t n, T* dst)
+{
+    moveTo(src, n, dst, std::is_trivially_copyable<T>());
+}
+
+template<class T>
+std::size_t Kernels::mismatch(const T* a, const T* b, std::size_t n)
+{
+    return mismatchLanes(a, b, n, (typename LaneOf<T>::type*)0);
+}
+
+template<class T>
+bool Kernels::equal(const T* a, const T* b, std::size_t n)
+{
+    return a == b || mismatch(a, b, n) == n;
+}
+
+template<class T>
+int Kernels::compare(const T* a, const T* b, std::size_t n)
+{
+    std::size_t i = 0;
+    while ((i += mismatch(a + i, b + i, n - i)) < n) {
+        if (a[i] < b[i])
+            return -1;
+        if (b[i] < a[i])
+            return 1;
+        i++;    // unordered (NaN), neither is less
+    }
+
+    return 0;
+}
+
+template<class T>
+std::size_t Kernels::find(const T* a, std::size_t n, const T& val)
+{
+    return findLanes(a, n, val, (typename LaneOf<T>::type*)0);
+}
+
+template<class T>
+T Kernels::sum(const T* a, std::size_t n)
+{
+    if (n == 0)
+        return T();
+    return reduce(a, n, Add(), Reducible<T>());
+}
+
+template<class T>
+T Kernels::min(const T* a, std::size_t n)
+{
+    return reduce(a, n, Min(), Reducible<T>());
+}
+
+template<class T>
+T Kernels::max(const T* a, std::size_t n)
+{
+    return reduce(a, n, Max(), Reducible<T>());
+}
+
+///////////////////////////// Private //////////////////////////////////////////
+
+template<class T>
+bool Kernels::uniformBytes(const T& val, std::true_type)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&val);
+    for (std::size_t i = 1; i < sizeof(T); i++)
+        if (bytes[i] != bytes[0])
+            return false;
+    return true;
+}
+
+template<class T>
+std::size_t Kernels::fillLanes(T*, std::size_t, const T&, void*)
+{
+    return 0;
+}
+
+template<class T, class L>
+std::size_t Kernels::fillLanes(T* dst, std::size_t n, const T& val, L*)
+{
+#ifdef ARRAY_KERNELS_X86
+    L bits;
+    std::memcpy(&bits, &val, sizeof(L));
+
+    switch (level()) {
+    case AVX2:
+        return fillAvx2<Avx2Lanes<L> >(dst, n, bits);
+    case SSE2:
+        return fillVec<Sse2Lanes<L> >(dst, n, bits);
+    default:
+        break;
+    }
+#endif
+    return 0;
+}
+
+template<class T>
+void Kernels::copyTo(const T* src, std::size_t n, T* dst, std::true_type)
+{
+    if (n > 0)
+        std::memcpy(static_cast<void*>(dst), src, n * sizeof(T));
+}
+
+template<class T>
+void Kernels::copyTo(const T* src, std::size_t n, T* dst, std::false_type)
+{
+    for (std::size_t i = 0; i < n; i++)
+        dst[i] = src[i];
+}
+
+template<class T>
+void Kernels::moveTo(T* src, std::size_t n, T* dst, std::true_type)
+{
+    copyTo(src, n, dst, std::true_type());
+}
+
+template<class T>
+void Kernels::moveTo(T* src, std::size_t n, T* dst, std::false_type)
+{
+    for (std::size_t i = 0; i < n; i++)
+        dst[i] = std::move(src[i]);
+}
+
+template<class T>
+std::size_t Kernels::mismatchLanes(const T* a, const T* b, std::size_t n,
+                                   void*)
+{
+    std::size_t i = 0;
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+template<class T, class L>
+std::size_t Kernels::mismatchLanes(const T* a, const T* b, std::size_t n, L*)
+{
+    std::size_t i = 0;
+
+#ifdef ARRAY_KERNELS_X86
+    switch (level()) {
+    case AVX2:
+        if (mismatchAvx2<Avx2Lanes<L>, L>(a, b, n, i))
+            return i;
+        break;
+    case SSE2:
+        if (mismatchVec<Sse2Lanes<L>, L>(a, b, n, i))
+            return i;
+        break;
+    default:
+        break;
+    }
+#endif
+
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+template<class T>
+std::size_t Kernels::findLanes(const T* a, std::size_t n, const T& val, void*)
+{
+    std::size_t i = 0;
+    while (i < n && !(a[i] == val))
+        i++;
+    return i;
+}
+
+template<class T, class L>
+std::size_t Kernels::findLanes(const T* a, std::size_t n, const T& val, L*)
+{
+    std::size_t i = 0;
+
+#ifdef ARRAY_KERNELS_X86
+    L bits;
+    std::memcpy(&bits, &val, sizeof(L));
+
+    switch (level()) {
+    case AVX2:
+        if (findAvx2<Avx2Lanes<L> >(a, n, bits, i))
+            return i;
+        break;
+    case SSE2:
+        if (findVec<Sse2Lanes<L> >(a, n, bits, i))
+            return i;
+        break;
+    default:
+        break;
+    }
+#endif
+
+    while (i < n && !(a[i] == val))
+        i++;
+    return i;
+}
+
+template<class T, class Op>
+T Kernels::reduce(const T* a, std::size_t n, Op op, std::true_type)
+{
+#ifdef ARRAY_KERNELS_X86
+    switch (level()) {
+    case AVX2:
+        return reduceAvx2<Avx2Lanes<T> >(a, n, op);
+    case SSE2:
+        return reduceVec<Sse2Lanes<T> >(a, n, op);
+    default:
+        break;
+    }
+#endif
+    return reduce(a, n, op, std::false_type());
+}
+
+template<class T, class Op>
+T Kernels::reduce(const T* a, std::size_t n, Op op, std::false_type)
+{
+    T res = a[0];
+    for (std::size_t i = 1; i < n; i++)
+        res = apply(res, a[i], op);
+    return res;
+}
+
+#ifdef ARRAY_KERNELS_X86
+
+// The SSE2 and AVX2 loops are the same code, only the AVX2 one is compiled
+// for AVX2. The function attribute can't be a template parameter.
+
+template<class V, class L>
+std::size_t Kernels::fillVec(void* dst, std::size_t n, L val)
+{
+    typename V::V v = V::splat(val);
+    char* out = static_cast<char*>(dst);
+    std::size_t i = 0;
+    for (; i + V::LANES <= n; i += V::LANES)
+        V::store(out + i * sizeof(L), v);
+    return i;
+}
+
+template<class V, class L>
+std::size_t Kernels::fillAvx2(void* dst, std::size_t n, L val)
+{
+    typename V::V v = V::splat(val);
+    char* out = static_cast<char*>(dst);
+    std::size_t i = 0;
+    for (; i + V::LANES <= n; i += V::LANES)
+        V::store(out + i * sizeof(L), v);
+    return i;
+}
+
+template<class V, class L>
+bool Kernels::mismatchVec(const void* a, const void* b, std::size_t n,
+                          std::size_t& i)
+{
+    const char* x = static_cast<const char*>(a);
+    const char* y = static_cast<const char*>(b);
+    for (i = 0; i + V::LANES <= n; i += V::LANES) {
+        unsigned m = V::eq(V::load(x + i * sizeof(L)),
+                           V::load(y + i * sizeof(L)));
+        if (m != V::ALL) {
+            i += __builtin_ctz(~m) / V::BITS;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class V, class L>
+bool Kernels::mismatchAvx2(const void* a, const void* b, std::size_t n,
+                           std::size_t& i)
+{
+    const char* x = static_cast<const char*>(a);
+    const char* y = static_cast<const char*>(b);
+    for (i = 0; i + V::LANES <= n; i += V::LANES) {
+        unsigned m = V::eq(V::load(x + i * sizeof(L)),
+                           V::load(y + i * sizeof(L)));
+        if (m != V::ALL) {
+            i += __builtin_ctz(~m) / V::BITS;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class V, class L>
+bool Kernels::findVec(const void* a, std::size_t n, L val, std::size_t& i)
+{
+    typename V::V v = V::splat(val);
+    const char* x = static_cast<const char*>(a);
+    for (i = 0; i + V::LANES <= n; i += V::LANES) {
+        unsigned m = V::eq(V::load(x + i * sizeof(L)), v);
+        if (m != 0) {
+            i += __builtin_ctz(m) / V::BITS;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class V, class L>
+bool Kernels::findAvx2(const void* a, std::size_t n, L val, std::size_t& i)
+{
+    typename V::V v = V::splat(val);
+    const char* x = static_cast<const char*>(a);
+    for (i = 0; i + V::LANES <= n; i += V::LANES) {
+        unsigned m = V::eq(V::load(x + i * sizeof(L)), v);
+        if (m != 0) {
+            i += __builtin_ctz(m) / V::BITS;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class V, class L, class Op>
+L Kernels::reduceVec(const L* a, std::size_t n, Op op)
+{
+    if (n < V::LANES)
+        return reduce(a, n, op, std::false_type());
+
+    // Lane wise first, across the lanes at the end
+    typename V::V acc = V::load(a);
+    std::size_t whole = n - n % V::LANES, i = V::LANES;
+    for (; i < whole; i += V::LANES)
+        acc = V::op(acc, V::load(a + i), (Op*)0);
+
+    L lanes[V::LANES];
+    V::store(lanes, acc);
+    L res = lanes[0];
+    for (std::size_t j = 1; j < V::LANES; j++)
+        res = apply(res, lanes[j], op);
+    for (; i < n; i++)
+        res = apply(res, a[i], op);
+    return res;
+}
+
+template<class V, class L, class Op>
+L Kernels::reduceAvx2(const L* a, std::size_t n, Op op)
+{
+    if (n < V::LANES)
+        return reduce(a, n, op, std::false_type());
+
+    typename V::V acc = V::load(a);
+    std::size_t whole = n - n % V::LANES, i = V::LANES;
+    for (; i < whole; i += V::LANES)
+        acc = V::op(acc, V::load(a + i), (Op*)0);
+
+    L lanes[V::LANES];
+    V::store(lanes, acc);
+    L res = lanes[0];
+    for (std::size_t j = 1; j < V::LANES; j++)
+        res = apply(res, lanes[j], op);
+    for (; i < n; i++)
+        res = apply(res, a[i], op);
+    return res;
+}
+
+#endif // ARRAY_KERNELS_X86
+
+#undef ARRAY_KERNELS_AVX2
+
+#endif // ARRAY_KERNELS_H
@@ -0,0 +1,582 @@
+#ifndef ARRAY_PARALLEL_H
+#define ARRAY_PARALLEL_H
+
+// Libraries
+#include <algorithm>            // sort, merge, lower_bound, for_each
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>            // exception_ptr
+#include <functional>           // function, less
+#include <iterator>             // iterator_traits, make_move_iterator
+#include <memory>               // unique_ptr
+#include <mutex>
+#include <numeric>              // accumulate
+#include <thread>
+#include <utility>              // move, swap
+#include <vector>
+#include <unistd.h>             // sysconf
+
+/**
+ * My notes:
+ *  - ThreadPool keeps its threads for the life of the program (shared()) or
+ *    of the object. Every worker has its own task deque: it pushes and pops
+ *    at the back, idle workers steal from the front of the others. Tasks
+ *    pushed from outside the pool go to a separate deque anyone steals from.
+ *  - A thread waiting on a TaskGroup runs queued tasks meanwhile, so
+ *    algorithms may nest (a task may run a parallel algorithm) and a pool
+ *    of size 1 (no workers) runs everything on the waiting thread.
+ *  - The deques take a mutex, tasks are chunks of thousands of elements so
+ *    the lock is noise next to the work.
+ *  - Algorithms cut ranges into chunks of about half the L2 cache (CHUNK
+ *    if it can't be read), but at least 4 chunks per thread when the range
+ *    is large enough, so stealing can balance uneven work.
+ *  - parallel_reduce folds every chunk on its own and combines the partial
+ *    results in range order, so op has to be associative but not
+ *    commutative. Chunk bounds follow the pool's size unless it's asked to
+ *    be deterministic, floating point sums may then differ between pools.
+ *  - Elements are passed to user functions from several threads at once,
+ *    those must not touch shared state without synchronization. The first
+ *    exception thrown by a task is rethrown by the algorithm.
+ */
+class ThreadPool {
+public:
+    typedef std::function<void(void)> Task;
+
+    /** Chunk size in bytes if the cache size can't be read
+     */
+    static const std::size_t CHUNK = 128 << 10;
+
+    /** Smallest chunk in elements
+     */
+    static const std::size_t MIN_CHUNK = 1 << 10;
+
+// Life Cycle
+
+    /** Constructor
+     *
+     * @param threads   Threads working on tasks, the one waiting for them
+     *                  included. 0 means one per hardware thread.
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /** Copy constructor
+     *
+     * Tasks hold on to the pool itself, copying it makes no sense.
+     */
+    ThreadPool(const ThreadPool& from) = delete;
+
+    /** Destructor
+     *
+     * Stops and joins the workers, no tasks may be pending.
+     */
+    ~ThreadPool(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not assignable, see copy constructor.
+     */
+    ThreadPool& operator=(const ThreadPool& from) = delete;
+
+// Operations
+
+    /** Queue a task
+     *
+     * Workers push on their own deque, other threads on the shared one.
+     *
+     * @param task      Task to run on some thread of the pool.
+     */
+    void push(Task task);
+
+    /** Run one queued task on this thread, stealing if need be
+     *
+     * @return          false if there was nothing to run.
+     */
+    bool runOne(void);
+
+// Access
+
+    /** Number of threads working on tasks, the waiting one included
+     */
+    unsigned size(void) const
+    {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+
+    /** Chunk length for a range
+     *
+     * @param n         Elements in the range.
+     * @param elemBytes Size of one element.
+     * @param balance   Also cap the chunk so every thread gets 4 of them.
+     * @return          Elements per chunk.
+     */
+    std::size_t chunk(std::size_t n, std::size_t elemBytes, bool balance) const;
+
+    /** Pool used when an algorithm isn't given one, one thread per hardware
+     *  thread.
+     */
+    static ThreadPool& shared(void);
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    struct Self {
+        ThreadPool* pool;
+        unsigned index;
+    };
+
+    /** Queue 0 is fed by outside threads, queue i by worker i
+     */
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    /** Queued tasks not yet taken, sleeping workers wait for it
+     */
+    std::atomic<long> pending;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping;
+
+    // Helper functions
+    void work(unsigned index);
+    bool take(unsigned index, bool back, Task& task);
+    unsigned current(void) const;
+    static Self& self(void);
+    static std::size_t cacheBytes(void);
+};
+
+/**
+ * Tasks of one fork-join step. wait() returns when all of them are done.
+ */
+class TaskGroup {
+public:
+    /** Constructor
+     *
+     * @param Pool      Pool the tasks run on.
+     */
+    explicit TaskGroup(ThreadPool& Pool) : pool(Pool), left(0) {}
+
+    TaskGroup(const TaskGroup& from) = delete;
+    TaskGroup& operator=(const TaskGroup& from) = delete;
+
+    /** Destructor
+     *
+     * Waits for the tasks, an exception from them is dropped.
+     */
+    ~TaskGroup(void);
+
+    /** Queue a task
+     *
+     * @param f         Callable without arguments, copied into the task.
+     */
+    template<class F>
+    void run(F f);
+
+    /** Run tasks on this thread until every task of the group is done
+     *
+     * @exception       Rethrows the first exception a task threw.
+     */
+    void wait(void);
+
+private:
+    ThreadPool& pool;
+    std::atomic<std::size_t> left;
+    std::mutex errorLock;
+    std::exception_ptr error;
+};
+
+///////////////////////////// Life Cycle ///////////////////////////////////////
+
+inline ThreadPool::ThreadPool(unsigned threads)
+    : pending(0), stopping(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    for (unsigned i = 0; i < threads; i++)
+        queues.emplace_back(new Queue());
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+inline ThreadPool::~ThreadPool(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+inline TaskGroup::~TaskGroup(void)
+{
+    while (left > 0)
+        if (!pool.runOne())
+            std::this_thread::yield();
+}
+
+///////////////////////////// Operations ///////////////////////////////////////
+
+inline void ThreadPool::push(Task task)
+{
+    Queue& q = *queues[current()];
+    {
+        std::lock_guard<std::mutex> guard(q.lock);
+        q.tasks.push_back(std::move(task));
+    }
+    {
+        // Under the lock, a worker about to sleep sees it
+        std::lock_guard<std::mutex> guard(sleepLock);
+        pending++;
+    }
+    wake.notify_one();
+}
+
+inline bool ThreadPool::runOne(void)
+{
+    Task task;
+    unsigned me = current();
+
+    // Own deque newest first (still in cache), others oldest first
+    bool found = take(me, me != 0, task);
+    for (std::size_t k = 1; !found && k < queues.size(); k++)
+        found = take((me + k) % queues.size(), false, task);
+    if (!found)
+        return false;
+
+    pending--;
+    task();
+    return true;
+}
+
+template<class F>
+void TaskGroup::run(F f)
+{
+    left++;
+    pool.push([this, f]() {
+        try {
+            f();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (!error)
+                error = std::current_exception();
+        }
+        left--;
+    });
+}
+
+inline void TaskGroup::wait(void)
+{
+    while (left > 0)
+        if (!pool.runOne())
+            std::this_thread::yield();
+
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+///////////////////////////// Access ///////////////////////////////////////////
+
+inline std::size_t ThreadPool::chunk(std::size_t n, std::size_t elemBytes,
+                                     bool balance) const
+{
+    std::size_t len = cacheBytes() / 2 / elemBytes;
+    if (balance) {
+        std::size_t even = (n + size() * 4 - 1) / (size() * 4);
+        if (even < len)
+            len = even;
+    }
+    return len < MIN_CHUNK ? MIN_CHUNK : len;
+}
+
+inline ThreadPool& ThreadPool::shared(void)
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+///////////////////////////// Private //////////////////////////////////////////
+
+inline void ThreadPool::work(unsigned index)
+{
+    self().pool = this;
+    self().index = index;
+
+    for (;;) {
+        if (runOne())
+            continue;
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this] { return stopping || pending > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+inline bool ThreadPool::take(unsigned index, bool back, Task& task)
+{
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty())
+        return false;
+
+    if (back) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+    }
+    else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+    }
+    return true;
+}
+
+inline unsigned ThreadPool::current(void) const
+{
+    return self().pool == this ? self().index : 0;
+}
+
+inline ThreadPool::Self& ThreadPool::self(void)
+{
+    static thread_local Self s = { nullptr, 0 };
+    return s;
+}
+
+inline std::size_t ThreadPool::cacheBytes(void)
+{
+    static const std::size_t bytes = [] {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+        long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (l2 > 0)
+            return static_cast<std::size_t>(l2);
+#endif
+        return CHUNK * 2;
+    }();
+    return bytes;
+}
+
+///////////////////////////// Algorithms ///////////////////////////////////////
+
+/** Apply a function to every element of a range
+ *
+ * @param first     Start of the range (random access).
+ * @param last      End of the range.
+ * @param f         Called with a reference to each element.
+ * @param pool      Pool to run on.
+ */
+template<class It, class F>
+void parallel_for_each(It first, It last, F f,
+                       ThreadPool& pool = ThreadPool::shared())
+{
+    typedef typename std::iterator_traits<It>::value_type V;
+    std::size_t n = last - first;
+    std::size_t len = pool.chunk(n, sizeof(V), true);
+
+    TaskGroup group(pool);
+    for (std::size_t at = 0; at < n; at += len) {
+        It b = first + at, e = first + std::min(n, at + len);
+        group.run([b, e, &f] { std::for_each(b, e, f); });
+    }
+    group.wait();
+}
+
+/** Store a function of every element of a range
+ *
+ * @param first     Start of the range (random access).
+ * @param last      End of the range.
+ * @param out       Start of the output (random access), may be first.
+ * @param f         Called with each element, returns the output value.
+ * @param pool      Pool to run on.
+ * @return          End of the output.
+ */
+template<class It, class Out, class F>
+Out parallel_transform(It first, It last, Out out, F f,
+                       ThreadPool& pool = ThreadPool::shared())
+{
+    typedef typename std::iterator_traits<It>::value_type V;
+    std::size_t n = last - first;
+    std::size_t len = pool.chunk(n, sizeof(V), true);
+
+    TaskGroup group(pool);
+    for (std::size_t at = 0; at < n; at += len) {
+        It b = first + at, e = first + std::min(n, at + len);
+        Out o = out + at;
+        group.run([b, e, o, &f] { std::transform(b, e, o, f); });
+    }
+    group.wait();
+    return out + n;
+}
+
+/** Fold a range with an associative operation
+ *
+ * @param first     Start of the range (random access).
+ * @param last      End of the range.
+ * @param init      Value the fold starts from.
+ * @param op        Associative binary operation, op(T, element).
+ * @param deterministic Same result for every pool, else the grouping
+ *                  follows the pool's size.
+ * @param pool      Pool to run on.
+ * @return          init folded with every element.
+ */
+template<class It, class T, class Op>
+T parallel_reduce(It first, It last, T init, Op op, bool deterministic = false,
+                  ThreadPool& pool = ThreadPool::shared())
+{
+    typedef typename std::iterator_traits<It>::value_type V;
+    std::size_t n = last - first;
+    std::size_t len = pool.chunk(n, sizeof(V), !deterministic);
+    std::size_t chunks = (n + len - 1) / len;
+    if (chunks <= 1)
+        return std::accumulate(first, last, init, op);
+
+    // One partial result per chunk, whichever task takes it, combined in
+    // range order at the end
+    std::size_t tasks = std::min<std::size_t>(chunks, pool.size());
+    std::vector<T> partial(chunks, init);
+    std::atomic<std::size_t> next(0);
+
+    TaskGroup group(pool);
+    for (std::size_t t = 0; t < tasks; t++) {
+        group.run([&] {
+            for (std::size_t c = next++; c < chunks; c = next++) {
+                It b = first + c * len, e = first + std::min(n, c * len + len);
+                T acc = *b;
+                for (++b; b != e; ++b)
+                    acc = op(acc, *b);
+                partial[c] = std::move(acc);
+            }
+        });
+    }
+    group.wait();
+
+    for (std::size_t c = 0; c < chunks; c++)
+        init = op(init, partial[c]);
+    return init;
+}
+
+/** Merge two sorted runs into out, splitting into tasks while long
+ */
+template<class In, class Out, class Compare>
+void parallelMerge(TaskGroup& group, In a, In aEnd, In b, In bEnd, Out out,
+                   Compare comp, std::size_t len)
+{
+    while (static_cast<std::size_t>((aEnd - a) + (bEnd - b)) > len) {
+        if (aEnd - a < bEnd - b) {
+            std::swap(a, b);
+            std::swap(aEnd, bEnd);
+        }
+
+        // Elements before the middle of a (and what goes before it in b)
+        In am = a + (aEnd - a) / 2;
+        In bm = std::lower_bound(b, bEnd, *am, comp);
+        group.run([=, &group] {
+            parallelMerge(group, a, am, b, bm, out, comp, len);
+        });
+        out += (am - a) + (bm - b);
+        a = am;
+        b = bm;
+    }
+
+    std::merge(std::make_move_iterator(a), std::make_move_iterator(aEnd),
+               std::make_move_iterator(b), std::make_move_iterator(bEnd),
+               out, comp);
+}
+
+/** One merge pass, runs of width from src merged pairwise into dst
+ */
+template<class In, class Out, class Compare>
+void parallelMergePass(ThreadPool& pool, In src, Out dst, std::size_t n,
+                       std::size_t width, Compare comp, std::size_t len)
+{
+    TaskGroup group(pool);
+    for (std::size_t at = 0; at < n; at += 2 * width) {
+        std::size_t mid = std::min(n, at + width);
+        std::size_t end = std::min(n, at + 2 * width);
+        group.run([=, &group] {
+            parallelMerge(group, src + at, src + mid, src + mid, src + end,
+                          dst + at, comp, len);
+        });
+    }
+    group.wait();
+}
+
+/** Sort a range
+ *
+ * Each thread sorts a slice with std::sort, the slices are then merged in
+ * passes through a buffer, every merge split between tasks. Not stable.
+ * The value type must be default constructible and move assignable.
+ *
+ * @param first     Start of the range (random access).
+ * @param last      End of the range.
+ * @param comp      Strict weak ordering.
+ * @param pool      Pool to run on.
+ */
+template<class It, class Compare>
+void parallel_sort(It first, It last, Compare comp,
+                   ThreadPool& pool = ThreadPool::shared())
+{
+    typedef typename std::iterator_traits<It>::value_type V;
+    std::size_t n = last - first;
+    std::size_t len = pool.chunk(n, sizeof(V), true);
+    if (pool.size() == 1 || n <= len) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    // Slices, a power of two of them so that the passes pair up evenly
+    std::size_t slices = 1;
+    while (slices < pool.size())
+        slices *= 2;
+    std::size_t width = (n + slices - 1) / slices;
+    {
+        TaskGroup group(pool);
+        for (std::size_t at = 0; at < n; at += width) {
+            It b = first + at, e = first + std::min(n, at + width);
+            group.run([b, e, comp] { std::sort(b, e, comp); });
+        }
+        group.wait();
+    }
+
+    std::vector<V> buffer(n);
+    for (;;) {
+        parallelMergePass(pool, first, buffer.begin(), n, width, comp, len);
+        width *= 2;
+        if (width >= n) {
+            parallel_transform(buffer.begin(), buffer.end(), first,
+                               [](V& v) -> V&& { return std::move(v); },
+                               pool);
+            return;
+        }
+        parallelMergePass(pool, buffer.begin(), first, n, width, comp, len);
+        width *= 2;
+        if (width >= n)
+            return;
+    }
+}
+
+/** Sort a range in ascending order, see parallel_sort(first, last, comp)
+ */
+template<class It>
+void parallel_sort(It first, It last, ThreadPool& pool = ThreadPool::shared())
+{
+    typedef typename std::iterator_traits<It>::value_type V;
+    parallel_sort(first, last, std::less<V>(), pool);
+}
+
+
+#endif // ARRAY_PARALLEL_H
@@ -0,0 +1,898 @@
+#ifndef ARRAY_VECTOR_H
+#define ARRAY_VECTOR_H
+
+// Libraries
+#include <new>              // bad_alloc
+#include <stdexcept>        // out_of_range, invalid_argument
+#include <cstddef>          // max_align_t
+#include <cstdlib>          // malloc, realloc, free
+#include <cstring>          // memcpy
+#include <initializer_list>
+#include <memory>           // allocator, allocator_traits
+#include <type_traits>      // is_trivially_copyable, integral_constant
+#include <utility>          // move, forward, move_if_noexcept
+#include "array.h"          // RandomAccessIterator, Kernels
+
+/**
+ * My notes:
+ *  - Growable counterpart of array, same iterators. Capacity doubles when
+ *    full (starting at MIN_CAPACITY), so push_back and emplace_back are
+ *    amortized O(1).
+ *  - Growing relocates the elements. Trivially copyable ones are copied in
+ *    one memcpy. On the default allocator their storage comes from
+ *    malloc, so growing is a realloc that often extends the block in place.
+ *    Other types are move constructed (copied if the move may throw, so a
+ *    failed growth leaves the vector as it was).
+ *  - small_vector<T, K> keeps up to K elements inside the object and only
+ *    goes to the heap when it outgrows them. It is a vector, functions
+ *    taking vector<T>& take it as well.
+ *  - Allocators propagate like in array, swapping vectors with unequal
+ *    allocators that don't propagate throws.
+ */
+template<class T, class Alloc = std::allocator<T>>
+class vector {
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef RandomAccessIterator<T> iterator;
+    typedef RandomAccessIterator<const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** Capacity of the first heap block
+     */
+    static const size_type MIN_CAPACITY = 4;
+
+    iterator begin(void) { return iterator(first); }
+    iterator end(void) { return iterator(first + count); }
+    const_iterator begin(void) const { return cbegin(); }
+    const_iterator end(void) const { return cend(); }
+    const_iterator cbegin(void) const { return const_iterator(first); }
+    const_iterator cend(void) const { return const_iterator(first + count); }
+    reverse_iterator rbegin(void) { return reverse_iterator(end()); }
+    reverse_iterator rend(void) { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin(void) const { return crbegin(); }
+    const_reverse_iterator rend(void) const { return crend(); }
+    const_reverse_iterator crbegin(void) const
+    {
+        return const_reverse_iterator(cend());
+    }
+    const_reverse_iterator crend(void) const
+    {
+        return const_reverse_iterator(cbegin());
+    }
+
+// Life Cycle
+
+    /** Constructor
+     *
+     * Nothing is allocated until the first element is added.
+     */
+    vector(void);
+
+    /** Constructor (allocator version)
+     *
+     * @param Allocator Allocator the storage is taken from.
+     */
+    explicit vector(const Alloc& Allocator);
+
+    /** Constructor (fill version)
+     *
+     * @param n         Number of elements.
+     * @param val       Value of every element.
+     * @param Allocator Allocator the storage is taken from.
+     *
+     * @bad_alloc       Generated if the allocation failed.
+     */
+    explicit vector(size_type n, const T& val = T(),
+                    const Alloc& Allocator = Alloc());
+
+    /** Constructor (initializer list version)
+     *
+     * @param init      Elements in order.
+     * @param Allocator Allocator the storage is taken from.
+     *
+     * @bad_alloc       Generated if the allocation failed.
+     */
+    vector(std::initializer_list<T> init, const Alloc& Allocator = Alloc());
+
+    /** Copy constructor
+     *
+     * The allocator is obtained through select_on_container_copy_construction.
+     * Capacity is trimmed to the size.
+     *
+     * @param from      Constant reference to an object to copy.
+     */
+    vector(const vector<T, Alloc>& from);
+
+    /** Copy constructor (allocator version)
+     *
+     * @param from      Constant reference to an object to copy.
+     * @param Allocator Allocator the storage is taken from.
+     */
+    vector(const vector<T, Alloc>& from, const Alloc& Allocator);
+
+    /** Move constructor
+     *
+     * Steals the storage, from is left empty. Elements kept inline by a
+     * small_vector are moved one by one instead.
+     *
+     * @param from      Rvalue reference to an object to steal.
+     */
+    vector(vector<T, Alloc>&& from);
+
+    /** Destructor
+     */
+    ~vector(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * The allocator is taken over from from only if Alloc propagates on copy
+     * assignment. Existing capacity is reused when large enough.
+     *
+     * @param from      Constant reference to an object to copy.
+     * @return          Reference to this object.
+     */
+    vector<T, Alloc>& operator=(const vector<T, Alloc>& from);
+
+    /** Move assignment operator
+     *
+     * Storage is stolen if Alloc propagates on move assignment or the
+     * allocators are equal, and from's elements aren't inline. Otherwise
+     * elements are moved one by one. from is left empty.
+     *
+     * @param from      Rvalue reference to an object to steal.
+     * @return          Reference to this object.
+     */
+    vector<T, Alloc>& operator=(vector<T, Alloc>&& from);
+
+// Operations
+
+    /** Append a copy of an element
+     *
+     * @param val       Element to add, may be one of this vector's.
+     *
+     * @bad_alloc       Generated if growing failed.
+     */
+    void push_back(const T& val);
+
+    /** Append an element (move version)
+     *
+     * @param val       Element to move in.
+     *
+     * @bad_alloc       Generated if growing failed.
+     */
+    void push_back(T&& val);
+
+    /** Append an element constructed in place
+     *
+     * @param args      Constructor arguments, may refer to this vector's
+     *                  elements.
+     * @return          Reference to the new element.
+     *
+     * @bad_alloc       Generated if growing failed.
+     */
+    template<class... Args>
+    T& emplace_back(Args&&... args);
+
+    /** Remove the last element
+     *
+     * @out_of_range    Generated if the vector is empty.
+     */
+    void pop_back(void);
+
+    /** Change the size, new elements are value initialized
+     *
+     * @param n         New size.
+     */
+    void resize(size_type n);
+
+    /** Change the size, new elements are copies of val
+     *
+     * @param n         New size.
+     * @param val       Value of new elements.
+     */
+    void resize(size_type n, const T& val);
+
+    /** Make room for at least n elements without growing again
+     *
+     * @param n         Capacity wanted.
+     *
+     * @bad_alloc       Generated if the allocation failed.
+     */
+    void reserve(size_type n);
+
+    /** Release unused capacity
+     *
+     * A small_vector that fits its inline storage again moves back into it.
+     */
+    void shrink_to_fit(void);
+
+    /** Remove all elements, capacity is kept
+     */
+    void clear(void);
+
+    /** Swap contents with another vector
+     *
+     * Heap storage is exchanged, inline elements are moved.
+     *
+     * @param with      Vector to swap with.
+     *
+     * @invalid_argument Generated if the allocators don't propagate and
+     *                  differ.
+     */
+    void swap(vector<T, Alloc>& with);
+
+// Access
+
+    /** Access element by index
+     *
+     * @param i         Index of an element in the vector.
+     * @return          Reference to the specified element.
+     *
+     * @out_of_range    Generated if invalid index.
+     */
+    T& at(size_type i);
+
+    /** Constant version of 'at'
+     */
+    const T& at(size_type i) const;
+
+    /** Last element, the vector must not be empty
+     */
+    T& back(void) { return first[count - 1]; }
+    const T& back(void) const { return first[count - 1]; }
+
+    /** Get the storage
+     *
+     * @return          Pointer to the first element.
+     */
+    T* data(void) { return first; }
+    const T* data(void) const { return first; }
+
+    size_type size(void) const { return count; }
+    size_type capacity(void) const { return cap; }
+    bool empty(void) const { return count == 0; }
+
+    /** Get the allocator
+     *
+     * @return          Copy of the allocator the storage comes from.
+     */
+    Alloc get_allocator(void) const { return alloc; }
+
+protected:
+    /** Constructor for small_vector
+     *
+     * @param Local     Inline storage, capacity until the first growth.
+     * @param LocalCap  Number of elements it holds.
+     * @param Allocator Allocator heap storage is taken from.
+     */
+    vector(T* Local, size_type LocalCap, const Alloc& Allocator);
+
+    /** Tells if the elements are in the inline storage
+     */
+    bool isLocal(void) const { return local != nullptr && first == local; }
+
+private:
+    typedef std::allocator_traits<Alloc> AllocTraits;
+    typedef std::is_trivially_copyable<T> Trivial;
+
+    /** Storage of trivially copyable types on the default allocator comes
+     *  from malloc, so it can grow with realloc. Not for over-aligned types
+     *  (SIMD vectors, cache lines), malloc only aligns to max_align_t.
+     */
+    static const bool REALLOC =
+        Trivial::value && std::is_same<Alloc, std::allocator<T>>::value &&
+        alignof(T) <= alignof(std::max_align_t);
+
+    /** Allocator the storage comes from
+     */
+    Alloc alloc;
+
+    /** First element, count of them, room for cap
+     */
+    T* first;
+    size_type count;
+    size_type cap;
+
+    /** Inline storage of a small_vector, nullptr for a vector
+     */
+    T* local;
+    size_type localCap;
+
+    // Helper functions
+    T* allocate(size_type n);
+    void deallocate(T* p, size_type n);
+    void release(void);
+    void destroyAll(void);
+    size_type grown(size_type need) const;
+    void relocate(size_type newCap);
+    static void moveElements(Alloc& a, T* from, size_type n, T* to,
+                             std::true_type);
+    static void moveElements(Alloc& a, T* from, size_type n, T* to,
+                             std::false_type);
+    static void relocateElements(Alloc& a, T* from, size_type n, T* to);
+    void copyFrom(const T* from, size_type n);
+    template<class... Args>
+    void growAndEmplace(std::true_type, Args&&... args);
+    template<class... Args>
+    void growAndEmplace(std::false_type, Args&&... args);
+    static void swapAlloc(Alloc& a, Alloc& b, std::true_type);
+    static void swapAlloc(Alloc& a, Alloc& b, std::false_type);
+    static void assignAlloc(Alloc& a, const Alloc& b, std::true_type);
+    static void assignAlloc(Alloc& a, const Alloc& b, std::false_type);
+};
+
+template<class T, class Alloc>
+const typename vector<T, Alloc>::size_type vector<T, Alloc>::MIN_CAPACITY;
+
+/**
+ * Inline storage of a small_vector. A base class of its own so that it is
+ * constructed before, and destroyed after, the vector using it.
+ */
+template<class T, std::size_t K>
+struct SmallStorage {
+    T* buffer(void) { return reinterpret_cast<T*>(bytes); }
+
+    alignas(T) unsigned char bytes[K * sizeof(T)];
+};
+
+/**
+ * vector keeping its first K elements inline.
+ */
+template<class T, std::size_t K, class Alloc = std::allocator<T>>
+class small_vector : private SmallStorage<T, K>, public vector<T, Alloc> {
+    typedef vector<T, Alloc> Base;
+
+public:
+    static_assert(K > 0, "small_vector needs inline room, use vector");
+
+    small_vector(void)
+        : Base(this->buffer(), K, Alloc())
+    {
+    }
+
+    explicit small_vector(const Alloc& Allocator)
+        : Base(this->buffer(), K, Allocator)
+    {
+    }
+
+    small_vector(std::initializer_list<T> init,
+                 const Alloc& Allocator = Alloc())
+        : Base(this->buffer(), K, Allocator)
+    {
+        for (const T& val : init)
+            this->push_back(val);
+    }
+
+    small_vector(const small_vector& from)
+        : Base(this->buffer(), K,
+               std::allocator_traits<Alloc>::
+                   select_on_container_copy_construction(
+                       from.get_allocator()))
+    {
+        Base::operator=(from);
+    }
+
+    small_vector(small_vector&& from)
+        : Base(this->buffer(), K, from.get_allocator())
+    {
+        Base::operator=(std::move(from));
+    }
+
+    small_vector& operator=(const small_vector& from)
+    {
+        Base::operator=(from);
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& from)
+    {
+        Base::operator=(std::move(from));
+        return *this;
+    }
+
+    /** Tells if the elements are still in the inline storage
+     */
+    bool isInline(void) const { return this->isLocal(); }
+};
+
+///////////////////////////// Life Cycle ///////////////////////////////////////
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(void)
+    : vector(nullptr, 0, Alloc())
+{
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(const Alloc& Allocator)
+    : vector(nullptr, 0, Allocator)
+{
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(T* Local, size_type LocalCap, const Alloc& Allocator)
+    : alloc(Allocator), first(Local), count(0), cap(LocalCap), local(Local),
+      localCap(LocalCap)
+{
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(size_type n, const T& val, const Alloc& Allocator)
+    : vector(nullptr, 0, Allocator)
+{
+    resize(n, val);
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(std::initializer_list<T> init,
+                         const Alloc& Allocator)
+    : vector(nullptr, 0, Allocator)
+{
+    copyFrom(init.begin(), init.size());
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(const vector<T, Alloc>& from)
+    : vector(nullptr, 0,
+             AllocTraits::select_on_container_copy_construction(from.alloc))
+{
+    copyFrom(from.first, from.count);
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(const vector<T, Alloc>& from, const Alloc& Allocator)
+    : vector(nullptr, 0, Allocator)
+{
+    copyFrom(from.first, from.count);
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::vector(vector<T, Alloc>&& from)
+    : vector(nullptr, 0, from.alloc)
+{
+    *this = std::move(from);
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>::~vector(void)
+{
+    destroyAll();
+    release();
+}
+
+///////////////////////////// Operators ////////////////////////////////////////
+
+template<class T, class Alloc>
+vector<T, Alloc>& vector<T, Alloc>::operator=(const vector<T, Alloc>& from)
+{
+    typedef typename AllocTraits::propagate_on_container_copy_assignment
+        Propagate;
+
+    if (&from == this)
+        return *this;
+
+    destroyAll();
+    if (Propagate::value && !(alloc == from.alloc)) {
+        // Storage has to come from from's allocator
+        release();
+        assignAlloc(alloc, from.alloc, Propagate());
+    }
+    copyFrom(from.first, from.count);
+
+    return *this;
+}
+
+template<class T, class Alloc>
+vector<T, Alloc>& vector<T, Alloc>::operator=(vector<T, Alloc>&& from)
+{
+    typedef typename AllocTraits::propagate_on_container_move_assignment
+        Propagate;
+
+    if (&from == this)
+        return *this;
+
+    destroyAll();
+    if (Propagate::value && !(alloc == from.alloc)) {
+        release();
+        assignAlloc(alloc, from.alloc, Propagate());
+    }
+
+    if (from.first != nullptr && !from.isLocal() && alloc == from.alloc) {
+        // Take the block, from falls back to its inline storage (or none)
+        release();
+        first = from.first;
+        cap = from.cap;
+        count = from.count;
+        from.first = from.local;
+        from.cap = from.localCap;
+        from.count = 0;
+        return *this;
+    }
+
+    reserve(from.count);
+    moveElements(alloc, from.first, from.count, first, Trivial());
+    count = from.count;
+    from.clear();
+
+    return *this;
+}
+
+///////////////////////////// Operations ///////////////////////////////////////
+
+template<class T, class Alloc>
+void vector<T, Alloc>::push_back(const T& val)
+{
+    emplace_back(val);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::push_back(T&& val)
+{
+    emplace_back(std::move(val));
+}
+
+template<class T, class Alloc>
+template<class... Args>
+T& vector<T, Alloc>::emplace_back(Args&&... args)
+{
+    if (count == cap)
+        growAndEmplace(Trivial(), std::forward<Args>(args)...);
+    else
+        AllocTraits::construct(alloc, first + count,
+                               std::forward<Args>(args)...);
+
+    return first[count++];
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::pop_back(void)
+{
+    if (count == 0)
+        throw std::out_of_range("vector::pop_back");
+
+    AllocTraits::destroy(alloc, first + --count);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::resize(size_type n)
+{
+    if (n > cap)
+        relocate(grown(n));
+    for (; count < n; count++)
+        AllocTraits::construct(alloc, first + count);
+    while (count > n)
+        AllocTraits::destroy(alloc, first + --count);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::resize(size_type n, const T& val)
+{
+    if (n > cap) {
+        T copy(val);    // val may be one of ours
+        relocate(grown(n));
+        resize(n, copy);
+        return;
+    }
+
+    for (; count < n; count++)
+        AllocTraits::construct(alloc, first + count, val);
+    while (count > n)
+        AllocTraits::destroy(alloc, first + --count);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::reserve(size_type n)
+{
+    if (n > cap)
+        relocate(n);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::shrink_to_fit(void)
+{
+    if (count < cap && !isLocal())
+        relocate(count);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::clear(void)
+{
+    destroyAll();
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::swap(vector<T, Alloc>& with)
+{
+    typedef typename AllocTraits::propagate_on_container_swap Propagate;
+
+    if (!Propagate::value && !(alloc == with.alloc))
+        throw std::invalid_argument("vector::swap");
+
+    if (first != nullptr && with.first != nullptr && !isLocal() &&
+        !with.isLocal()) {
+        std::swap(first, with.first);
+        std::swap(count, with.count);
+        std::swap(cap, with.cap);
+        swapAlloc(alloc, with.alloc, Propagate());
+        return;
+    }
+
+    // Inline elements can't change hands, and a small_vector must not be
+    // left without storage, move through a third vector
+    vector<T, Alloc> tmp(std::move(with));
+    with = std::move(*this);
+    *this = std::move(tmp);
+}
+
+///////////////////////////// Access ///////////////////////////////////////////
+
+template<class T, class Alloc>
+T& vector<T, Alloc>::at(size_type i)
+{
+    if (i >= count)
+        throw std::out_of_range("vector::at");
+
+    return first[i];
+}
+
+template<class T, class Alloc>
+const T& vector<T, Alloc>::at(size_type i) const
+{
+    if (i >= count)
+        throw std::out_of_range("vector::at");
+
+    return first[i];
+}
+
+///////////////////////////// Comparison ///////////////////////////////////////
+
+template<class T, class Alloc>
+bool operator==(const vector<T, Alloc>& a, const vector<T, Alloc>& b)
+{
+    return a.size() == b.size() && Kernels::equal(a.data(), b.data(), a.size());
+}
+
+template<class T, class Alloc>
+bool operator!=(const vector<T, Alloc>& a, const vector<T, Alloc>& b)
+{
+    return !(a == b);
+}
+
+///////////////////////////// Private //////////////////////////////////////////
+
+template<class T, class Alloc>
+T* vector<T, Alloc>::allocate(size_type n)
+{
+    if (!REALLOC)
+        return AllocTraits::allocate(alloc, n);
+
+    T* p = static_cast<T*>(std::malloc(n * sizeof(T)));
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::deallocate(T* p, size_type n)
+{
+    if (REALLOC)
+        std::free(p);
+    else
+        AllocTraits::deallocate(alloc, p, n);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::release(void)
+{
+    // Elements must be gone, falls back to the inline storage (or none)
+    if (first != nullptr && !isLocal())
+        deallocate(first, cap);
+    first = local;
+    cap = localCap;
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::destroyAll(void)
+{
+    if (!std::is_trivially_destructible<T>::value)
+        for (size_type i = 0; i < count; i++)
+            AllocTraits::destroy(alloc, first + i);
+    count = 0;
+}
+
+template<class T, class Alloc>
+typename vector<T, Alloc>::size_type
+vector<T, Alloc>::grown(size_type need) const
+{
+    size_type next = cap < MIN_CAPACITY ? MIN_CAPACITY : cap * 2;
+    return next < need ? need : next;
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::relocate(size_type newCap)
+{
+    if (newCap < count)
+        newCap = count;
+
+    T* to;
+    if (newCap <= localCap) {
+        to = local;     // shrinking back inline
+        newCap = localCap;
+    }
+    else if (REALLOC && first != nullptr && !isLocal()) {
+        to = static_cast<T*>(std::realloc(static_cast<void*>(first),
+                                          newCap * sizeof(T)));
+        if (to == nullptr)
+            throw std::bad_alloc();
+        first = to;
+        cap = newCap;
+        return;
+    }
+    else {
+        to = newCap > 0 ? allocate(newCap) : nullptr;
+    }
+
+    if (to == first)
+        return;
+
+    try {
+        relocateElements(alloc, first, count, to);
+    }
+    catch (...) {
+        if (to != local)
+            deallocate(to, newCap);
+        throw;
+    }
+
+    size_type n = count;
+    count = 0;      // ended by relocateElements
+    release();
+    first = to;
+    cap = newCap;
+    count = n;
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::moveElements(Alloc&, T* from, size_type n, T* to,
+                                    std::true_type)
+{
+    if (n > 0)
+        std::memcpy(static_cast<void*>(to), from, n * sizeof(T));
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::moveElements(Alloc& a, T* from, size_type n, T* to,
+                                    std::false_type)
+{
+    // Copies if moving may throw, from stays intact until all are done
+    size_type i = 0;
+    try {
+        for (; i < n; i++)
+            AllocTraits::construct(a, to + i, std::move_if_noexcept(from[i]));
+    }
+    catch (...) {
+        while (i-- > 0)
+            AllocTraits::destroy(a, to + i);
+        throw;
+    }
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::relocateElements(Alloc& a, T* from, size_type n, T* to)
+{
+    if (Trivial::value || !std::is_nothrow_move_constructible<T>::value) {
+        // All or nothing, originals end once every copy is made
+        moveElements(a, from, n, to, Trivial());
+        if (!std::is_trivially_destructible<T>::value)
+            for (size_type i = 0; i < n; i++)
+                AllocTraits::destroy(a, from + i);
+        return;
+    }
+
+    // Can't fail, move and end each in one pass
+    for (size_type i = 0; i < n; i++) {
+        AllocTraits::construct(a, to + i, std::move(from[i]));
+        AllocTraits::destroy(a, from + i);
+    }
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::copyFrom(const T* from, size_type n)
+{
+    // Appends to an empty vector
+    reserve(n);
+    if (Trivial::value) {
+        Kernels::copy(from, n, first);
+        count = n;
+        return;
+    }
+    for (; count < n; count++)
+        AllocTraits::construct(alloc, first + count, from[count]);
+}
+
+template<class T, class Alloc>
+template<class... Args>
+void vector<T, Alloc>::growAndEmplace(std::true_type, Args&&... args)
+{
+    // Args may point into the old block, which realloc may free
+    T val(std::forward<Args>(args)...);
+    relocate(grown(count + 1));
+    AllocTraits::construct(alloc, first + count, val);
+}
+
+template<class T, class Alloc>
+template<class... Args>
+void vector<T, Alloc>::growAndEmplace(std::false_type, Args&&... args)
+{
+    // New element first, while args still refer to live elements
+    size_type newCap = grown(count + 1);
+    T* to = allocate(newCap);
+    try {
+        AllocTraits::construct(alloc, to + count, std::forward<Args>(args)...);
+    }
+    catch (...) {
+        deallocate(to, newCap);
+        throw;
+    }
+    try {
+        relocateElements(alloc, first, count, to);
+    }
+    catch (...) {
+        AllocTraits::destroy(alloc, to + count);
+        deallocate(to, newCap);
+        throw;
+    }
+
+    size_type n = count;
+    count = 0;      // ended by relocateElements
+    release();
+    first = to;
+    cap = newCap;
+    count = n;
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::swapAlloc(Alloc& a, Alloc& b, std::true_type)
+{
+    using std::swap;
+    swap(a, b);
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::swapAlloc(Alloc&, Alloc&, std::false_type)
+{
+    // Allocator doesn't propagate, each vector keeps its own
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::assignAlloc(Alloc& a, const Alloc& b, std::true_type)
+{
+    a = b;
+}
+
+template<class T, class Alloc>
+void vector<T, Alloc>::assignAlloc(Alloc&, const Alloc&, std::false_type)
+{
+}
+
+#if __cplusplus >= 201703L
+namespace pmr {
+    template<class T>
+    using vector = ::vector<T, std::pmr::polymorphic_allocator<T>>;
+    template<class T, std::size_t K>
+    using small_vector =
+        ::small_vector<T, K, std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
+
+#endif // ARRAY_VECTOR_H
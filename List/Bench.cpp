@@ -0,0 +1,427 @@
+#include "List.h"
+#include "UnrolledList.h"
+#include "IndexedList.h"
+#include "ConcurrentQueue.h"
+#include "MappedList.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Time a callable, in milliseconds
+template<class F>
+static double timeIt(F f)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	f();
+	std::chrono::duration<double, std::milli> took =
+		std::chrono::steady_clock::now() - start;
+	return took.count();
+}
+
+// Heap path vs slab pool: add/rm throughput and traversal of the result
+static void benchPool(int n)
+{
+	const char* name[2] = { "heap", "pool" };
+
+	for (int mode = 0; mode < 2; mode++) {
+		List<int> list = mode == 0
+			? List<int>()
+			: List<int>(std::make_shared<NodePool<int>>(4096));
+
+		// Other allocations interleaved with the list scatter heap nodes
+		std::vector<std::unique_ptr<char[]>> noise;
+		noise.reserve(n);
+
+		double add = timeIt([&] {
+			for (int i = 0; i < n; i++) {
+				list.add(0, i);
+				noise.emplace_back(new char[16 + i % 64]);
+			}
+		});
+		double scan = timeIt([&] {
+			for (int r = 0; r < 10; r++)
+				list.search(-1);
+		});
+		double churn = timeIt([&] {
+			for (int i = 0; i < n; i++)
+				list.add(0, list.rm(0));
+		});
+		double rm = timeIt([&] {
+			while (!list.isEmpty())
+				list.rm(0);
+		});
+
+		std::printf("%s  n=%d  add %.2f ms  10x scan %.2f ms  "
+		            "rm+add %.2f ms  rm %.2f ms\n",
+		            name[mode], n, add, scan, churn, rm);
+	}
+}
+
+// List vs unrolled list: search() over the whole list
+static void benchUnrolled(int n)
+{
+	List<int> list;
+	UnrolledList<int> ul;
+	for (int i = 0; i < n; i++) {
+		list.add(0, i);
+		ul.add(ul.size(), i);
+	}
+
+	double a = timeIt([&] {
+		for (int r = 0; r < 10; r++)
+			list.search(-1);
+	});
+	double b = timeIt([&] {
+		for (int r = 0; r < 10; r++)
+			ul.search(-1);
+	});
+
+	std::printf("search n=%d  List %.2f ms  UnrolledList %.2f ms  "
+	            "(%d per block, %d blocks)\n",
+	            n, a, b, UnrolledList<int>::CAP, ul.blocks());
+}
+
+// sortParallel() scaling from one thread to every hardware thread
+static void benchSortParallel(int n)
+{
+	unsigned cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		cores = 1;
+
+	std::shared_ptr<NodePool<int>> pool = std::make_shared<NodePool<int>>(1 << 16);
+	for (unsigned threads = 1; threads <= cores; threads *= 2) {
+		List<int> list(pool);
+		std::srand(7);
+		for (int i = 0; i < n; i++)
+			list.add(0, std::rand());
+
+		double took = timeIt([&] { list.sortParallel(threads); });
+		std::printf("sortParallel n=%d  threads=%u  %.2f ms\n", n, threads, took);
+
+		if (threads < cores && threads * 2 > cores)
+			threads = cores / 2;    // always end on every core
+	}
+}
+
+// Random positional access, List walks vs IndexedList lanes
+static void benchIndexed(int n)
+{
+	const int slow = 100, fast = 100000;
+	List<int> list;
+	IndexedList<int> il;
+	for (int i = 0; i < n; i++) {
+		list.push_back(i);
+		il.add(i, i);
+	}
+
+	long sink = 0;
+	std::srand(11);
+	double a = timeIt([&] {
+		for (int q = 0; q < slow; q++)
+			sink += list.peek(std::rand() % n);
+	});
+	double b = timeIt([&] {
+		for (int q = 0; q < fast; q++)
+			sink += il.peek(std::rand() % n);
+	});
+	double c = timeIt([&] {
+		for (int q = 0; q < fast; q++) {
+			int pos = std::rand() % n;
+			il.add(pos, il.rm(pos));
+		}
+	});
+
+	std::printf("random peek n=%d  List %.2f us  IndexedList %.3f us  "
+	            "rm+add %.3f us  (%d lanes)  [%ld]\n", n,
+	            a * 1000 / slow, b * 1000 / fast, c * 1000 / fast,
+	            il.lanes(), sink % 10);
+}
+
+// Every element a hit: search() materialization vs the lazy forms
+static void benchSearch(int n)
+{
+	List<int> list;
+	for (int i = 0; i < n; i++)
+		list.push_back(i % 4 == 0 ? 0 : 1);
+
+	long sink = 0;
+	double a = timeIt([&] { sink += list.search(0).size(); });
+	double b = timeIt([&] { sink += list.count(0); });
+	double c = timeIt([&] {
+		for (int pos : list.matches(0))
+			sink += pos;
+	});
+	double d = timeIt([&] { sink += list.find_first(1); });
+
+	std::printf("search n=%d  search %.2f ms  count %.2f ms  matches %.2f ms  "
+	            "find_first %.4f ms  [%ld]\n", n, a, b, c, d, sink % 10);
+}
+
+// Scan speed of a sorted list before and after compact()
+static void benchCompact(int n)
+{
+	List<int> list;
+	std::vector<std::unique_ptr<char[]>> noise;
+	noise.reserve(n);
+	std::srand(13);
+	for (int i = 0; i < n; i++) {
+		list.push_back(std::rand());
+		noise.emplace_back(new char[16 + i % 64]);
+	}
+	list.sort();
+
+	long sink = 0;
+	double frag = list.fragmentation();
+	double before = timeIt([&] {
+		for (int r = 0; r < 10; r++)
+			sink += list.count(-1);
+	});
+	double took = timeIt([&] { list.compact(); });
+	double after = timeIt([&] {
+		for (int r = 0; r < 10; r++)
+			sink += list.count(-1);
+	});
+
+	std::printf("compact n=%d  10x scan %.2f ms (fragmentation %.2f)  "
+	            "compact %.2f ms  10x scan %.2f ms  [%ld]\n",
+	            n, before, frag, took, after, sink);
+}
+
+// Producers pushing to one consumer, ConcurrentQueue vs List under a mutex
+static void benchMergeSorted(int n, int k)
+{
+	std::vector<List<int>> lists(k), again(k);
+	std::srand(17);
+	for (int i = 0; i < k; i++) {
+		for (int j = 0; j < n / k; j++) {
+			int x = std::rand();
+			lists[i].push_back(x);
+			again[i].push_back(x);
+		}
+		lists[i].sort();
+		again[i].sort();
+	}
+
+	// Concatenate and sort again versus a k-way merge of the sorted lists
+	List<int> cat, merged;
+	double a = timeIt([&] {
+		for (int i = 0; i < k; i++)
+			cat.append(lists[i]);
+		cat.sort();
+	});
+	std::vector<List<int>*> others;
+	for (int i = 0; i < k; i++)
+		others.push_back(&again[i]);
+	double b = timeIt([&] { merged.mergeSorted(others); });
+
+	std::printf("merge n=%d k=%d  append+sort %.2f ms  mergeSorted %.2f ms\n",
+	            n, k, a, b);
+}
+
+static void benchRadix(int n)
+{
+	for (int size = 1 << 6; size <= n; size <<= 3) {
+		double took[2];
+		for (int radix = 0; radix < 2; radix++) {
+			std::srand(19);
+			took[radix] = 0;
+			for (int r = 0; r < n / size; r++) {
+				List<int> list;
+				for (int i = 0; i < size; i++)
+					list.push_back(std::rand());
+				took[radix] += timeIt([&] {
+					if (radix)
+						list.radixSort();
+					else
+						list.sort(std::less<int>());
+				});
+			}
+		}
+		std::printf("radix n=%d x%d  merge sort %.2f ms  radixSort %.2f ms\n",
+		            size, n / size, took[0], took[1]);
+	}
+}
+
+static void benchPrint(int n)
+{
+	List<int> list;
+	std::srand(23);
+	for (int i = 0; i < n; i++)
+		list.push_back(std::rand());
+
+	// Old print(): one stream insertion per element
+	std::ofstream sink("/dev/null");
+	double a = timeIt([&] {
+		for (const int& x : list)
+			sink << x << " ";
+		sink << std::endl;
+	});
+	double b = timeIt([&] {
+		Writer out(sink);
+		list.print(out);
+		out.put('\n');
+	});
+	std::stringstream bin;
+	double c = timeIt([&] {
+		Writer out(bin);
+		list.save(out);
+	});
+	List<int> back;
+	double d = timeIt([&] {
+		Reader in(bin);
+		back.load(in);
+	});
+
+	std::printf("print n=%d  ostream %.2f ms  Writer %.2f ms  "
+	            "save %.2f ms  load %.2f ms\n", n, a, b, c, d);
+}
+
+static void benchMapped(int n)
+{
+	const char* path = "/tmp/benchMapped.lst";
+	std::remove(path);
+	std::stringstream dump;
+	{
+		MappedList<int> mapped(path, n);
+		Writer out(dump);
+		std::srand(29);
+		for (int i = 0; i < n; i++) {
+			int x = std::rand();
+			mapped.push_back(x);
+			out.print(x).put(' ');
+		}
+	}
+
+	// Startup: parse a text dump versus map the file and walk it
+	long sink = 0;
+	double a = timeIt([&] {
+		List<int> list;
+		int x;
+		while (dump >> x)
+			list.push_back(x);
+		sink += list.size();
+	});
+	double b = timeIt([&] {
+		MappedList<int> mapped(path);
+		for (int x : mapped)
+			sink += x & 1;
+	});
+	std::remove(path);
+
+	std::printf("mapped n=%d  parse text %.2f ms  open + walk %.2f ms  [%ld]\n",
+	            n, a, b, sink);
+}
+
+static void benchPrefetch(int n)
+{
+	// Sorting random keys scatters the nodes, every hop is a cache miss
+	// once the list outgrows the caches
+	for (int size = 1 << 10; size <= n; size <<= 2) {
+		List<long> list;
+		std::srand(31);
+		for (int i = 0; i < size; i++)
+			list.push_back(std::rand());
+		list.sort();
+
+		int reps = n / size > 4 ? n / size : 4;
+		long sink = 0;
+		double took[2];
+		for (int on = 0; on < 2; on++) {
+			list.prefetch(on ? 16 : 0);     // fills in the jump table
+			took[on] = timeIt([&] {
+				for (int r = 0; r < reps; r++)
+					sink += list.count(-1);
+			});
+		}
+		std::printf("prefetch n=%d  off %.2f ns/node  on %.2f ns/node  [%ld]\n",
+		            size, took[0] * 1e6 / reps / size,
+		            took[1] * 1e6 / reps / size, sink);
+	}
+}
+
+static void benchConcurrentQueue(int n)
+{
+	unsigned cores = std::thread::hardware_concurrency();
+	unsigned producers = cores > 1 ? cores - 1 : 1;
+	int each = n / producers;
+	long sink = 0;
+
+	ConcurrentQueue<int> q;
+	double a = timeIt([&] {
+		std::vector<std::thread> threads;
+		for (unsigned p = 0; p < producers; p++)
+			threads.emplace_back([&q, each] {
+				for (int i = 0; i < each; i++)
+					q.push(i);
+			});
+		int x;
+		for (long got = 0; got < (long)each * producers; )
+			if (q.pop(x)) {
+				sink += x;
+				got++;
+			}
+			else
+				std::this_thread::yield();
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+	});
+
+	std::mutex m;
+	List<int> list;
+	double b = timeIt([&] {
+		std::vector<std::thread> threads;
+		for (unsigned p = 0; p < producers; p++)
+			threads.emplace_back([&m, &list, each] {
+				for (int i = 0; i < each; i++) {
+					std::lock_guard<std::mutex> lock(m);
+					list.push_back(i);
+				}
+			});
+		for (long got = 0; got < (long)each * producers; ) {
+			bool popped = false;
+			int x = 0;
+			{
+				std::lock_guard<std::mutex> lock(m);
+				if (!list.isEmpty()) {
+					x = list.rm(0);
+					popped = true;
+				}
+			}
+			if (popped) {
+				sink += x;
+				got++;
+			}
+			else
+				std::this_thread::yield();
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+	});
+
+	std::printf("queue n=%d  producers=%u  ConcurrentQueue %.2f ms  "
+	            "List+mutex %.2f ms  [%ld]\n", n, producers, a, b, sink % 10);
+}
+
+int main(int argc, char *argv[])
+{
+	benchPool(1 << 20);
+	benchUnrolled(1 << 20);
+	benchSortParallel(1 << 22);
+	benchIndexed(1 << 20);
+	benchSearch(1 << 22);
+	benchCompact(1 << 22);
+	benchMergeSorted(1 << 22, 2);
+	benchMergeSorted(1 << 22, 64);
+	benchRadix(1 << 21);
+	benchPrint(1 << 22);
+	benchMapped(1 << 22);
+	benchPrefetch(1 << 24);
+	benchConcurrentQueue(1 << 22);
+	return 0;
+}
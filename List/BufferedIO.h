@@ -0,0 +1,519 @@
+#ifndef __BUFFERED_IO_H__
+#define __BUFFERED_IO_H__
+
+// Libraries
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <cstdio>       // FILE, fwrite, fread, snprintf
+#include <cstring>      // memcpy
+#include <iostream>
+#include <iterator>     // iterator_traits
+#include <memory>       // unique_ptr
+#include <sstream>
+#include <type_traits>  // is_trivially_copyable, integral_constant
+#if __cplusplus >= 201703L
+#include <charconv>     // to_chars
+#endif
+
+/**
+ * My notes:
+ *  - Writer collects output in one buffer and hands it to the sink in large
+ *    blocks, so dumping a big container costs a handful of write calls
+ *    instead of one stream insertion (and maybe a flush) per element.
+ *    Writes larger than the buffer go straight to the sink.
+ *  - A sink is std::ostream, FILE* or any function taking (context, data,
+ *    size). Keep a Writer around to reuse its buffer between dumps.
+ *  - Integers are formatted with std::to_chars (C++17). Floating point
+ *    numbers get the same text operator<< gives them by default (%g, 6
+ *    digits), so print() output didn't change. Other types go through
+ *    their operator<<.
+ *  - Binary format: "BLK1", element size (uint32_t), element count
+ *    (uint64_t), then the elements as raw bytes. Native byte order, only
+ *    for trivially copyable types, meant for dumps read back on the same
+ *    machine.
+ */
+class Writer {
+public:
+    typedef void (*Sink)(void* context, const char* data, std::size_t size);
+
+// Life cycle
+
+    /** Constructor (stream version)
+     *
+     * @param out           Stream to write to.
+     * @param Capacity      Buffer size in bytes.
+     */
+    explicit Writer(std::ostream& out, std::size_t Capacity = BUFFER_SIZE);
+
+    /** Constructor (C file version)
+     *
+     * @param out           File to write to.
+     * @param Capacity      Buffer size in bytes.
+     */
+    explicit Writer(std::FILE* out, std::size_t Capacity = BUFFER_SIZE);
+
+    /** Constructor (generic version)
+     *
+     * @param Out           Called with every full buffer (or a block too
+     *                      large to buffer).
+     * @param Context       First argument to Out.
+     * @param Capacity      Buffer size in bytes.
+     */
+    Writer(Sink Out, void* Context, std::size_t Capacity = BUFFER_SIZE);
+
+    /** Copy constructor
+     *
+     * Two writers on one sink would interleave their buffers.
+     */
+    Writer(const Writer& from) = delete;
+
+    /** Destructor
+     *
+     * Whatever is left in the buffer goes to the sink.
+     */
+    ~Writer(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not assignable, see copy constructor.
+     */
+    const Writer& operator=(const Writer& from) = delete;
+
+// Operations
+
+    /** Write one character
+     *
+     * @param c             Character to write.
+     * @return              Reference to this object.
+     */
+    Writer& put(char c);
+
+    /** Write raw bytes
+     *
+     * @param data          Bytes to write.
+     * @param size          Number of bytes.
+     * @return              Reference to this object.
+     */
+    Writer& write(const char* data, std::size_t size);
+
+    /** Write a value as text
+     *
+     * @param value         Number (formatted like operator<< would),
+     *                      character or anything with an operator<<.
+     * @return              Reference to this object.
+     */
+    template<class T>
+    Writer& print(const T& value);
+
+    /** Hand the buffer to the sink
+     *
+     * @return              Reference to this object.
+     */
+    Writer& flush(void);
+
+    /** Default buffer size in bytes
+     */
+    static const std::size_t BUFFER_SIZE = 1 << 16;
+
+private:
+    Sink sink;                      // Where full buffers go
+    void* context;                  // First argument to sink
+    std::unique_ptr<char[]> buf;    // Pending output
+    std::size_t capacity;           // Size of buf
+    std::size_t used;               // Bytes pending in buf
+    std::ostringstream fallback;    // Formats types without to_chars
+
+    // Helper functions
+    template<class T>
+    void number(const T& value, std::true_type);
+    template<class T>
+    void number(const T& value, std::false_type);
+    static void toStream(void* out, const char* data, std::size_t size);
+    static void toFile(void* out, const char* data, std::size_t size);
+};
+
+/**
+ * Buffered binary input, reads blocks from a source and hands them out in
+ * pieces. Reads larger than the buffer go straight to the destination.
+ */
+class Reader {
+public:
+    typedef std::size_t (*Source)(void* context, char* data,
+                                  std::size_t size);
+
+// Life cycle
+
+    /** Constructor (stream version)
+     *
+     * @param in            Stream to read from.
+     * @param Capacity      Buffer size in bytes.
+     */
+    explicit Reader(std::istream& in,
+                    std::size_t Capacity = Writer::BUFFER_SIZE);
+
+    /** Constructor (C file version)
+     *
+     * @param in            File to read from.
+     * @param Capacity      Buffer size in bytes.
+     */
+    explicit Reader(std::FILE* in, std::size_t Capacity = Writer::BUFFER_SIZE);
+
+    /** Constructor (generic version)
+     *
+     * @param In            Fills up to size bytes, returns how many it did,
+     *                      0 at the end of the input.
+     * @param Context       First argument to In.
+     * @param Capacity      Buffer size in bytes.
+     */
+    Reader(Source In, void* Context,
+           std::size_t Capacity = Writer::BUFFER_SIZE);
+
+    /** Copy constructor
+     *
+     * Two readers on one source would each skip what the other buffered.
+     */
+    Reader(const Reader& from) = delete;
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not assignable, see copy constructor.
+     */
+    const Reader& operator=(const Reader& from) = delete;
+
+// Operations
+
+    /** Read raw bytes
+     *
+     * @param data          Receives the bytes.
+     * @param size          Number of bytes to read.
+     * @return              false if the input ended first.
+     */
+    bool read(char* data, std::size_t size);
+
+private:
+    Source source;                  // Where the bytes come from
+    void* context;                  // First argument to source
+    std::unique_ptr<char[]> buf;    // Bytes read ahead
+    std::size_t capacity;           // Size of buf
+    std::size_t pos;                // Next unread byte in buf
+    std::size_t end;                // Bytes in buf
+
+    // Helper functions
+    static std::size_t fromStream(void* in, char* data, std::size_t size);
+    static std::size_t fromFile(void* in, char* data, std::size_t size);
+};
+
+// ****************************** Free functions *******************************
+
+/** Write a range as text
+ *
+ * @param out           Writer to write to.
+ * @param first         Iterator to the first element.
+ * @param last          Iterator past the last element.
+ * @param sep           Written after every element.
+ * @return              out.
+ */
+template<class Iterator>
+Writer& writeText(Writer& out, Iterator first, Iterator last, char sep = ' ');
+
+/** Write the binary header
+ *
+ * @param out           Writer to write to.
+ * @param count         Number of elements that follow.
+ * @return              out.
+ */
+template<class T>
+Writer& writeHeader(Writer& out, std::uint64_t count);
+
+/** Read and check the binary header
+ *
+ * @param in            Reader to read from.
+ * @param count         Receives the number of elements that follow.
+ * @return              false if there is no header for elements of type T.
+ */
+template<class T>
+bool readHeader(Reader& in, std::uint64_t& count);
+
+/** Write contiguous elements in binary, in one block
+ *
+ * @param out           Writer to write to.
+ * @param data          First element.
+ * @param count         Number of elements.
+ * @return              out.
+ */
+template<class T>
+Writer& writeBinary(Writer& out, const T* data, std::size_t count);
+
+/** Write a range in binary
+ *
+ * @param out           Writer to write to.
+ * @param first         Iterator to the first element.
+ * @param last          Iterator past the last element.
+ * @param count         Number of elements in the range.
+ * @return              out.
+ */
+template<class Iterator>
+Writer& writeBinary(Writer& out, Iterator first, Iterator last,
+                    std::uint64_t count);
+
+/** Read contiguous elements written by writeBinary()
+ *
+ * @param in            Reader to read from.
+ * @param data          Receives the elements.
+ * @param count         Number of elements expected.
+ * @return              false if the header is wrong, the count differs or
+ *                      the input ends early.
+ */
+template<class T>
+bool readBinary(Reader& in, T* data, std::size_t count);
+
+// ****************************** Life cycle ***********************************
+
+inline Writer::Writer(std::ostream& out, std::size_t Capacity)
+    : Writer(toStream, &out, Capacity)
+{
+}
+
+inline Writer::Writer(std::FILE* out, std::size_t Capacity)
+    : Writer(toFile, out, Capacity)
+{
+}
+
+inline Writer::Writer(Sink Out, void* Context, std::size_t Capacity)
+    : sink(Out), context(Context),
+      buf(new char[Capacity > 64 ? Capacity : 64]),
+      capacity(Capacity > 64 ? Capacity : 64), used(0)
+{
+}
+
+inline Writer::~Writer(void)
+{
+    flush();
+}
+
+inline Reader::Reader(std::istream& in, std::size_t Capacity)
+    : Reader(fromStream, &in, Capacity)
+{
+}
+
+inline Reader::Reader(std::FILE* in, std::size_t Capacity)
+    : Reader(fromFile, in, Capacity)
+{
+}
+
+inline Reader::Reader(Source In, void* Context, std::size_t Capacity)
+    : source(In), context(Context),
+      buf(new char[Capacity > 0 ? Capacity : 1]),
+      capacity(Capacity > 0 ? Capacity : 1), pos(0), end(0)
+{
+}
+
+// ****************************** Operations ***********************************
+
+inline Writer& Writer::put(char c)
+{
+    if (used == capacity)
+        flush();
+    buf[used++] = c;
+
+    return *this;
+}
+
+inline Writer& Writer::write(const char* data, std::size_t size)
+{
+    if (size > capacity - used) {
+        flush();
+        if (size >= capacity) {     // wouldn't fit anyway, skip the copy
+            sink(context, data, size);
+            return *this;
+        }
+    }
+    std::memcpy(buf.get() + used, data, size);
+    used += size;
+
+    return *this;
+}
+
+template<class T>
+Writer& Writer::print(const T& value)
+{
+    // Characters and bools read better through operator<<
+    number(value, std::integral_constant<bool,
+        std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+        !std::is_same<T, char>::value && !std::is_same<T, signed char>::value &&
+        !std::is_same<T, unsigned char>::value>());
+
+    return *this;
+}
+
+inline Writer& Writer::flush(void)
+{
+    if (used > 0)
+        sink(context, buf.get(), used);
+    used = 0;
+
+    return *this;
+}
+
+inline bool Reader::read(char* data, std::size_t size)
+{
+    // Drain the buffer first
+    std::size_t have = end - pos < size ? end - pos : size;
+    std::memcpy(data, buf.get() + pos, have);
+    pos  += have;
+    data += have;
+    size -= have;
+
+    // Large reads go straight into data, small ones through the buffer
+    while (size >= capacity) {
+        std::size_t got = source(context, data, size);
+        if (got == 0)
+            return false;
+        data += got;
+        size -= got;
+    }
+    while (size > 0) {
+        end = source(context, buf.get(), capacity);
+        pos = end < size ? end : size;
+        if (end == 0)
+            return false;
+        std::memcpy(data, buf.get(), pos);
+        data += pos;
+        size -= pos;
+    }
+
+    return true;
+}
+
+// ****************************** Free functions *******************************
+
+template<class Iterator>
+Writer& writeText(Writer& out, Iterator first, Iterator last, char sep)
+{
+    for (; first != last; ++first)
+        out.print(*first).put(sep);
+
+    return out;
+}
+
+template<class T>
+Writer& writeHeader(Writer& out, std::uint64_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "binary output needs a trivially copyable type");
+
+    std::uint32_t size = sizeof(T);
+    out.write("BLK1", 4);
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+    return out;
+}
+
+template<class T>
+bool readHeader(Reader& in, std::uint64_t& count)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "binary input needs a trivially copyable type");
+
+    char magic[4];
+    std::uint32_t size;
+    return in.read(magic, sizeof(magic)) &&
+           std::memcmp(magic, "BLK1", sizeof(magic)) == 0 &&
+           in.read(reinterpret_cast<char*>(&size), sizeof(size)) &&
+           size == sizeof(T) &&
+           in.read(reinterpret_cast<char*>(&count), sizeof(count));
+}
+
+template<class T>
+Writer& writeBinary(Writer& out, const T* data, std::size_t count)
+{
+    writeHeader<T>(out, count);
+    return out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+template<class Iterator>
+Writer& writeBinary(Writer& out, Iterator first, Iterator last,
+                    std::uint64_t count)
+{
+    typedef typename std::iterator_traits<Iterator>::value_type T;
+
+    writeHeader<T>(out, count);
+    for (; first != last; ++first) {
+        const T& data = *first;
+        out.write(reinterpret_cast<const char*>(&data), sizeof(T));
+    }
+
+    return out;
+}
+
+template<class T>
+bool readBinary(Reader& in, T* data, std::size_t count)
+{
+    std::uint64_t n;
+    return readHeader<T>(in, n) && n == count &&
+           in.read(reinterpret_cast<char*>(data), count * sizeof(T));
+}
+
+// ****************************** Private **************************************
+
+template<class T>
+void Writer::number(const T& value, std::true_type)
+{
+#if __cplusplus >= 201703L
+    if (capacity - used < 64)
+        flush();
+
+    // What operator<< writes with default flags, to_chars would give the
+    // shortest round trip form instead
+    if (std::is_floating_point<T>::value) {
+        used += std::snprintf(buf.get() + used, capacity - used, "%Lg",
+                              static_cast<long double>(value));
+        return;
+    }
+
+    std::to_chars_result res = std::to_chars(buf.get() + used,
+                                             buf.get() + capacity, value);
+    used = res.ptr - buf.get();
+#else
+    number(value, std::false_type());
+#endif
+}
+
+template<class T>
+void Writer::number(const T& value, std::false_type)
+{
+    fallback.str(std::string());
+    fallback.clear();
+    fallback << value;
+    const std::string& text = fallback.str();
+    write(text.data(), text.size());
+}
+
+inline void Writer::toStream(void* out, const char* data, std::size_t size)
+{
+    static_cast<std::ostream*>(out)->write(data, size);
+}
+
+inline void Writer::toFile(void* out, const char* data, std::size_t size)
+{
+    std::fwrite(data, 1, size, static_cast<std::FILE*>(out));
+}
+
+inline std::size_t Reader::fromStream(void* in, char* data, std::size_t size)
+{
+    std::istream* is = static_cast<std::istream*>(in);
+    is->read(data, size);
+    return static_cast<std::size_t>(is->gcount());
+}
+
+inline std::size_t Reader::fromFile(void* in, char* data, std::size_t size)
+{
+    return std::fread(data, 1, size, static_cast<std::FILE*>(in));
+}
+
+#endif // __BUFFERED_IO_H__
@@ -0,0 +1,222 @@
+#ifndef __CONCURRENT_QUEUE_H__
+#define __CONCURRENT_QUEUE_H__
+
+// Libraries
+#include <atomic>
+#include <new>          // placement new
+#include <type_traits>  // aligned_storage
+#include <utility>      // forward, move
+
+// My headers
+#include "List.h"
+
+/**
+ * My notes:
+ *  - Unbounded multi-producer / single-consumer FIFO queue. Any number of
+ *    threads may push() at the same time, only one thread at a time may
+ *    pop(). Neither side takes a lock.
+ *  - A push is one atomic exchange on the back of the queue plus a store
+ *    that links the old back to the new node, it never retries.
+ *  - The consumer always keeps one node whose payload was already taken
+ *    (a stub), the front of the queue is the node after it.
+ *  - Memory reclamation is safe without hazard pointers or epochs: only the
+ *    consumer frees nodes, and it frees a node only after moving past it,
+ *    which needs the producer that appended after it to have linked it
+ *    already. A producer never touches a node after that link.
+ *  - A producer that stalls between its exchange and its link hides the
+ *    nodes pushed after it until it resumes, pop() reports the queue empty
+ *    in that window.
+ */
+template<class T>
+class ConcurrentQueue {
+public:
+// Life cycle
+
+    /** Default constructor
+     */
+    ConcurrentQueue(void);
+
+    /** Copy constructor
+     *
+     * Producers hold on to the queue itself, copying it makes no sense.
+     */
+    ConcurrentQueue(const ConcurrentQueue<T>& from) = delete;
+
+    /** Destructor
+     *
+     * Must not run while any thread still pushes or pops.
+     */
+    ~ConcurrentQueue(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not assignable, see copy constructor.
+     */
+    const ConcurrentQueue<T>& operator=(const ConcurrentQueue<T>& from)
+        = delete;
+
+// Operations
+
+    /** Add element at the back, from any thread
+     *
+     * @param data          Data to store.
+     */
+    void push(const T& data);
+    void push(T&& data);
+
+    /** Construct element at the back in place, from any thread
+     *
+     * @param args          Arguments forwarded to the T constructor.
+     */
+    template<class... Args>
+    void emplace(Args&&... args);
+
+    /** Remove the front element, consumer thread only
+     *
+     * @param data          Receives the front element if there is one.
+     * @return              false if the queue was empty.
+     */
+    bool pop(T& data);
+
+    /** Move everything available to the back of a list, consumer only
+     *
+     * @param into          List the elements are appended to.
+     * @return              Number of elements moved.
+     */
+    template<class Alloc>
+    int popAll(List<T, Alloc>& into);
+
+// Access
+
+    /** Is queue empty? Consumer thread only
+     *
+     * @return              true or false, producers may add at any moment.
+     */
+    bool isEmpty(void) const;
+
+private:
+    // Queue node, data is only constructed while the node is in the queue
+    struct Cell {
+        std::atomic<Cell*> next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+
+        T* data(void) { return reinterpret_cast<T*>(&raw); }
+    };
+
+    std::atomic<Cell*> back;    // Last node, producers swap themselves in
+    char pad[64];               // Keep producers off the consumer's line
+    Cell* stub;                 // Consumed node in front of the queue
+
+    // Helper functions
+    void link(Cell* cell);
+};
+
+// ****************************** Life cycle ***********************************
+
+template<class T>
+ConcurrentQueue<T>::ConcurrentQueue(void)
+    : stub(new Cell)
+{
+    stub->next.store(nullptr, std::memory_order_relaxed);
+    back.store(stub, std::memory_order_relaxed);
+}
+
+template<class T>
+ConcurrentQueue<T>::~ConcurrentQueue(void)
+{
+    Cell* next;
+    while ((next = stub->next.load(std::memory_order_acquire)) != nullptr) {
+        delete stub;
+        next->data()->~T();
+        stub = next;
+    }
+    delete stub;
+}
+
+// ****************************** Operations ***********************************
+
+template<class T>
+void ConcurrentQueue<T>::push(const T& data)
+{
+    emplace(data);
+}
+
+template<class T>
+void ConcurrentQueue<T>::push(T&& data)
+{
+    emplace(std::move(data));
+}
+
+template<class T>
+template<class... Args>
+void ConcurrentQueue<T>::emplace(Args&&... args)
+{
+    Cell* cell = new Cell;
+    try {
+        new (&cell->raw) T(std::forward<Args>(args)...);
+    }
+    catch (...) {
+        delete cell;
+        throw;
+    }
+    cell->next.store(nullptr, std::memory_order_relaxed);
+    link(cell);
+}
+
+template<class T>
+bool ConcurrentQueue<T>::pop(T& data)
+{
+    Cell* next = stub->next.load(std::memory_order_acquire);
+    if (next == nullptr)
+        return false;
+
+    // The front node becomes the new stub once its payload is taken
+    T* front = next->data();
+    data = std::move(*front);
+    front->~T();
+    delete stub;
+    stub = next;
+
+    return true;
+}
+
+template<class T>
+template<class Alloc>
+int ConcurrentQueue<T>::popAll(List<T, Alloc>& into)
+{
+    int moved = 0;
+    Cell* next;
+    while ((next = stub->next.load(std::memory_order_acquire)) != nullptr) {
+        T* front = next->data();
+        into.push_back(std::move(*front));
+        front->~T();
+        delete stub;
+        stub = next;
+        moved++;
+    }
+
+    return moved;
+}
+
+// ****************************** Access ***************************************
+
+template<class T>
+bool ConcurrentQueue<T>::isEmpty(void) const
+{
+    return stub->next.load(std::memory_order_acquire) == nullptr;
+}
+
+// ****************************** Private **************************************
+
+template<class T>
+void ConcurrentQueue<T>::link(Cell* cell)
+{
+    // Claim the back, then hook the old back up to us. The release store
+    // publishes the payload to the consumer.
+    Cell* prev = back.exchange(cell, std::memory_order_acq_rel);
+    prev->next.store(cell, std::memory_order_release);
+}
+
+#endif // __CONCURRENT_QUEUE_H__
@@ -0,0 +1,567 @@
+#ifndef __INDEXED_LIST_H__
+#define __INDEXED_LIST_H__
+
+// Libraries
+#include <cstdint>      // uint32_t
+#include <memory>       // shared_ptr
+#include <new>          // placement new
+#include <stdexcept>    // invalid_argument
+#include <utility>      // forward, move, swap
+
+// My headers
+#include "List.h"
+
+/**
+ * My notes:
+ *  - A List<T> with skip list express lanes on top of the node chain. Every
+ *    lane link knows how many nodes it skips (its span), so add / rm / peek
+ *    by position are O(log n) expected instead of O(pos).
+ *  - The node chain itself is untouched, forward iteration, search and print
+ *    cost exactly what they cost on a plain List<T>.
+ *  - About one node in four gets a tower of lanes, one in sixteen reaches the
+ *    second lane and so on.
+ */
+template<class T>
+class IndexedList : protected List<T> {
+public:
+    typedef typename List<T>::iterator iterator;
+    typedef typename List<T>::const_iterator const_iterator;
+
+// Life cycle
+
+    /** Default constructor
+     */
+    IndexedList(void);
+
+    /** Constructor (pooled version)
+     *
+     * @param Pool          Pool to allocate nodes from, see List<T>.
+     */
+    explicit IndexedList(std::shared_ptr<NodePool<T>> Pool);
+
+    /** Copy constructor
+     *
+     * @param from          This object is copied to this list (deep).
+     */
+    IndexedList(const IndexedList<T>& from);
+
+    /** Move constructor
+     *
+     * @param from          This object is copied to this list (stolen).
+     */
+    IndexedList(IndexedList<T>&& from);
+
+    /** Destructor
+     */
+    ~IndexedList(void);
+
+// Operators
+
+    /** Assignment operator (copy and move)
+     *
+     * @param from          This object is assigned to this list.
+     * @return              This object.
+     */
+    IndexedList<T>& operator=(IndexedList<T> from);
+
+// Operations
+
+    /** Add new node by position (O(log n))
+     *
+     * @param pos           List position to insert the new node.
+     * @param data          Data to store in the new node.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid.
+     */
+    IndexedList<T>& add(const int& pos, const T& data);
+
+    /** Add new node by position (O(log n), move version)
+     */
+    IndexedList<T>& add(const int& pos, T&& data);
+
+    /** Construct new node by position (O(log n))
+     *
+     * @param pos           List position to insert the new node.
+     * @param args          Arguments forwarded to the constructor of T.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid.
+     */
+    template<class... Args>
+    IndexedList<T>& emplace(const int& pos, Args&&... args);
+
+    /** Remove node by position (O(log n))
+     *
+     * @param pos           List position of the node to remove.
+     * @return              Data stored in the removed node (moved out).
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    T rm(const int& pos);
+
+    /** Remove all nodes in the list
+     *
+     * @return              Reference to this object.
+     */
+    IndexedList<T>& clear(void);
+
+    /** Reverse the list, rebuilds the lanes (O(n))
+     *
+     * @return              Reference to this object.
+     */
+    IndexedList<T>& reverse(void);
+
+    /** Sort the list, rebuilds the lanes afterwards
+     *
+     * @return              Reference to this object.
+     */
+    IndexedList<T>& sort(void);
+
+    /** Swap contents with another list
+     *
+     * @param with          List to swap with.
+     */
+    void swap(IndexedList<T>& with);
+
+// Access
+
+    /** Peek at position (O(log n))
+     *
+     * @param pos           Possition to peek at.
+     * @return              Data stored in the specified position.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    const T& peek(const int& pos) const;
+
+    /** Get number of lanes in use
+     *
+     * @return              Height of the tallest tower.
+     */
+    int lanes(void) const;
+
+    // Read only operations behave exactly like on List<T>
+    using List<T>::size;
+    using List<T>::isEmpty;
+    using List<T>::search;
+    using List<T>::find_first;
+    using List<T>::find_first_if;
+    using List<T>::count;
+    using List<T>::count_if;
+    using List<T>::visit;
+    using List<T>::visit_if;
+    using List<T>::matches;
+    using List<T>::matches_if;
+    using List<T>::print;
+    using List<T>::begin;
+    using List<T>::end;
+    using List<T>::cbegin;
+    using List<T>::cend;
+
+    /** Maximum number of lanes
+     */
+    static const int MAX_LANES = 16;
+
+private:
+
+    struct Tower;
+
+    // One lane of a tower, span counts nodes from this tower to next
+    struct Link {
+        Tower* next;
+        int span;
+    };
+
+    // Express lanes of a node, links are stored right after the tower
+    struct Tower {
+        Node<T>* node;
+        Link* lane;
+    };
+
+    Tower* header;      // Lanes in front of the first node
+    int levels;         // Lanes in use
+    std::uint32_t seed; // Tower height generator state
+
+    // Helper functions
+    static Tower* newTower(Node<T>* node, int height);
+    static void freeTower(Tower* tower);
+    int randomHeight(void);
+    int findBefore(int rank, Tower** update, int* ranks) const;
+    Node<T>** linkAt(const Tower* from, int fromRank, int rank,
+                     Node<T>** prev);
+    void rebuild(void);
+    void dropTowers(void);
+};
+
+template<class T>
+const int IndexedList<T>::MAX_LANES;
+
+// ****************************** Life cycle ***********************************
+
+template<class T>
+IndexedList<T>::IndexedList(void)
+    : List<T>(), header(newTower(nullptr, MAX_LANES)), levels(0),
+      seed(2463534242u)
+{
+}
+
+template<class T>
+IndexedList<T>::IndexedList(std::shared_ptr<NodePool<T>> Pool)
+    : List<T>(Pool), header(newTower(nullptr, MAX_LANES)), levels(0),
+      seed(2463534242u)
+{
+}
+
+template<class T>
+IndexedList<T>::IndexedList(const IndexedList<T>& from)
+    : List<T>(from), header(newTower(nullptr, MAX_LANES)), levels(0),
+      seed(from.seed)
+{
+    try {
+        rebuild();
+    }
+    catch (...) {
+        dropTowers();
+        freeTower(header);
+        throw;
+    }
+}
+
+template<class T>
+IndexedList<T>::IndexedList(IndexedList<T>&& from)
+    : List<T>(std::move(from)), header(newTower(nullptr, MAX_LANES)),
+      levels(from.levels), seed(from.seed)
+{
+    std::swap(header, from.header);
+    from.levels = 0;
+}
+
+template<class T>
+IndexedList<T>::~IndexedList(void)
+{
+    dropTowers();
+    freeTower(header);
+}
+
+// ****************************** Operators  ***********************************
+
+template<class T>
+IndexedList<T>& IndexedList<T>::operator=(IndexedList<T> from)
+{
+    swap(from);
+    return *this;
+}
+
+// ****************************** Operations ***********************************
+
+template<class T>
+IndexedList<T>& IndexedList<T>::add(const int& pos, const T& data)
+{
+    return emplace(pos, data);
+}
+
+template<class T>
+IndexedList<T>& IndexedList<T>::add(const int& pos, T&& data)
+{
+    return emplace(pos, std::move(data));
+}
+
+template<class T>
+template<class... Args>
+IndexedList<T>& IndexedList<T>::emplace(const int& pos, Args&&... args)
+{
+    if (pos < 0 || pos > this->n)
+        throw std::invalid_argument("IndexedList<T>::emplace");
+
+    // Ranks are 1-based, the header sits at rank 0. The new node gets rank
+    // pos + 1, find the last tower on every lane with rank <= pos.
+    Tower* update[MAX_LANES];
+    int ranks[MAX_LANES];
+    findBefore(pos, update, ranks);
+
+    // Link the node into the chain
+    Node<T>* prev;
+    Node<T>** link = linkAt(update[0], ranks[0], pos + 1, &prev);
+    Node<T>* node  = this->newNode(*link, std::forward<Args>(args)...);
+    *link = node;
+    if (node->getNext() == nullptr)
+        this->tail = node;
+
+    // Raise a tower for it, new lanes start at the header spanning everything
+    int height = randomHeight();
+    Tower* tower = nullptr;
+    if (height > 0) {
+        try {
+            tower = newTower(node, height);
+        }
+        catch (...) {
+            *link = node->getNext();    // keep the list as it was
+            if (this->tail == node)
+                this->tail = prev;
+            this->freeNode(node);
+            throw;
+        }
+    }
+    for (; levels < height; levels++) {
+        ranks[levels]                 = 0;
+        update[levels]                = header;
+        header->lane[levels].span     = this->n;
+    }
+
+    for (int i = 0; i < height; i++) {
+        Link& before         = update[i]->lane[i];
+        tower->lane[i].next  = before.next;
+        tower->lane[i].span  = before.span - (pos - ranks[i]);
+        before.next          = tower;
+        before.span          = pos - ranks[i] + 1;
+    }
+    for (int i = height; i < levels; i++)
+        update[i]->lane[i].span++;
+    this->n++;
+    this->invalidate();     // List<T>'s finger doesn't know about lanes
+
+    return *this;
+}
+
+template<class T>
+T IndexedList<T>::rm(const int& pos)
+{
+    if (pos < 0 || pos >= this->n)
+        throw std::invalid_argument("IndexedList<T>::rm");
+
+    // The victim has rank pos + 1, find the towers just before it
+    Tower* update[MAX_LANES];
+    int ranks[MAX_LANES];
+    findBefore(pos, update, ranks);
+
+    Node<T>* prev;
+    Node<T>** link = linkAt(update[0], ranks[0], pos + 1, &prev);
+    Node<T>* node  = *link;
+
+    // Unhook its tower, lanes that pass over it just get shorter
+    Tower* tower = nullptr;
+    for (int i = 0; i < levels; i++) {
+        Link& before = update[i]->lane[i];
+        if (before.next != nullptr && before.next->node == node) {
+            tower        = before.next;
+            before.span += tower->lane[i].span - 1;
+            before.next  = tower->lane[i].next;
+        }
+        else {
+            before.span--;
+        }
+    }
+    if (tower != nullptr)
+        freeTower(tower);
+    while (levels > 0 && header->lane[levels - 1].next == nullptr)
+        levels--;
+
+    // Unlink the node
+    T rmData(std::move(node->getData()));
+    *link = node->getNext();
+    if (node == this->tail)
+        this->tail = prev;
+    this->freeNode(node); this->n--;
+    this->invalidate();
+
+    return rmData;
+}
+
+template<class T>
+IndexedList<T>& IndexedList<T>::clear(void)
+{
+    dropTowers();
+    List<T>::clear();
+    return *this;
+}
+
+template<class T>
+IndexedList<T>& IndexedList<T>::reverse(void)
+{
+    List<T>::reverse();
+    rebuild();
+    return *this;
+}
+
+template<class T>
+IndexedList<T>& IndexedList<T>::sort(void)
+{
+    List<T>::sort();
+    rebuild();
+    return *this;
+}
+
+template<class T>
+void IndexedList<T>::swap(IndexedList<T>& with)
+{
+    List<T>::swap(with);
+    std::swap(header, with.header);
+    std::swap(levels, with.levels);
+    std::swap(seed, with.seed);
+}
+
+// ****************************** Access ***************************************
+
+template<class T>
+const T& IndexedList<T>::peek(const int& pos) const
+{
+    if (pos < 0 || pos >= this->n)
+        throw std::invalid_argument("IndexedList<T>::peek");
+
+    // Ride the lanes as far as rank pos + 1, then walk the rest of the chain
+    const Tower* x = header;
+    int rank       = 0;
+    for (int i = levels - 1; i >= 0; i--)
+        while (x->lane[i].next != nullptr && rank + x->lane[i].span <= pos + 1) {
+            rank += x->lane[i].span;
+            x     = x->lane[i].next;
+        }
+
+    Node<T>* curr = rank == 0 ? this->head : x->node;
+    for (rank = rank == 0 ? 1 : rank; rank <= pos; rank++)
+        curr = curr->getNext();
+
+    return curr->getData();
+}
+
+template<class T>
+int IndexedList<T>::lanes(void) const
+{
+    return levels;
+}
+
+// ****************************** Private **************************************
+
+template<class T>
+typename IndexedList<T>::Tower* IndexedList<T>::newTower(Node<T>* node,
+                                                         int height)
+{
+    // Tower and links in one allocation
+    char* raw    = new char[sizeof(Tower) + height * sizeof(Link)];
+    Tower* tower = new (raw) Tower;
+    tower->node  = node;
+    tower->lane  = reinterpret_cast<Link*>(raw + sizeof(Tower));
+    for (int i = 0; i < height; i++)
+        new (&tower->lane[i]) Link{ nullptr, 0 };
+
+    return tower;
+}
+
+template<class T>
+void IndexedList<T>::freeTower(Tower* tower)
+{
+    delete[] reinterpret_cast<char*>(tower);
+}
+
+template<class T>
+int IndexedList<T>::randomHeight(void)
+{
+    // xorshift32, two bits per lane gives the 1/4 promotion rate
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    int height = 0;
+    for (std::uint32_t bits = seed; (bits & 3) == 0 && height < MAX_LANES;
+         bits >>= 2)
+        height++;
+
+    return height;
+}
+
+template<class T>
+int IndexedList<T>::findBefore(int rank, Tower** update, int* ranks) const
+{
+    // Last tower on every lane whose rank is <= rank
+    Tower* x = header;
+    int r    = 0;
+    for (int i = levels - 1; i >= 0; i--) {
+        while (x->lane[i].next != nullptr && r + x->lane[i].span <= rank) {
+            r += x->lane[i].span;
+            x  = x->lane[i].next;
+        }
+        update[i] = x;
+        ranks[i]  = r;
+    }
+
+    // No lanes yet, the chain is walked from the header
+    if (levels == 0) {
+        update[0] = header;
+        ranks[0]  = 0;
+    }
+
+    return r;
+}
+
+template<class T>
+Node<T>** IndexedList<T>::linkAt(const Tower* from, int fromRank, int rank,
+                                 Node<T>** prev)
+{
+    // Address of the link that points at the node with the given rank
+    Node<T>** link = &this->head;
+    *prev          = nullptr;
+    if (fromRank > 0) {
+        *prev = from->node;
+        link  = from->node->nextAdr();
+    }
+    for (int r = fromRank + 1; r < rank; r++) {
+        *prev = *link;
+        link  = (*link)->nextAdr();
+    }
+
+    return link;
+}
+
+template<class T>
+void IndexedList<T>::rebuild(void)
+{
+    dropTowers();
+
+    // Raise towers front to back, remembering the last tower on every lane
+    Tower* last[MAX_LANES];
+    int lastRank[MAX_LANES];
+    for (int i = 0; i < MAX_LANES; i++) {
+        last[i]     = header;
+        lastRank[i] = 0;
+    }
+
+    int rank = 1;
+    for (Node<T>* curr = this->head; curr != nullptr;
+         curr = curr->getNext(), rank++) {
+        int height = randomHeight();
+        if (height == 0)
+            continue;
+
+        Tower* tower = newTower(curr, height);
+        for (int i = 0; i < height; i++) {
+            last[i]->lane[i].next = tower;
+            last[i]->lane[i].span = rank - lastRank[i];
+            last[i]               = tower;
+            lastRank[i]           = rank;
+        }
+        if (height > levels)
+            levels = height;
+    }
+
+    // Last towers span to the end of the list
+    for (int i = 0; i < levels; i++)
+        last[i]->lane[i].span = this->n - lastRank[i];
+}
+
+template<class T>
+void IndexedList<T>::dropTowers(void)
+{
+    // Every tower is on the lowest lane
+    if (levels > 0)
+        for (Tower* t = header->lane[0].next, *next; t != nullptr; t = next) {
+            next = t->lane[0].next;
+            freeTower(t);
+        }
+
+    for (int i = 0; i < MAX_LANES; i++)
+        header->lane[i] = Link{ nullptr, 0 };
+    levels = 0;
+}
+
+#endif // __INDEXED_LIST_H__
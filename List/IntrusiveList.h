@@ -0,0 +1,712 @@
+#ifndef __INTRUSIVE_LIST_H__
+#define __INTRUSIVE_LIST_H__
+
+// Libraries
+#include <cstddef>      // ptrdiff_t
+#include <functional>   // less
+#include <iterator>     // forward_iterator_tag
+#include <stdexcept>    // invalid_argument
+#include <type_traits>  // integral_constant
+#include <utility>      // swap
+
+/**
+ * Link embedded in objects that go into an IntrusiveList.
+ *
+ * Inherit from it or hold it as a member. Tag tells several base hooks of
+ * the same class apart, one hook per list an object is in at the same time.
+ */
+template<class T, class Tag = void>
+struct ListHook {
+    ListHook(void) : next(nullptr) {}
+
+    T* next;    // Next object in the list the hook is linked into
+};
+
+/**
+ * My notes:
+ *  - Same operations as List<T>, but the list links objects the caller
+ *    owns through a ListHook inside them, nothing is allocated or copied.
+ *    The list never creates or destroys objects, clear() only unlinks them.
+ *  - Member is the hook to use, nullptr means T inherits ListHook<T, Tag>.
+ *  - An object can be in one list per hook, objects must stay put (not be
+ *    moved or destroyed) while linked.
+ */
+template<class T, class Tag = void, ListHook<T, Tag> T::*Member = nullptr>
+class IntrusiveList {
+private:
+    template<bool Const> class Iterator;
+
+public:
+    typedef Iterator<false> iterator;
+    typedef Iterator<true>  const_iterator;
+
+// Life cycle
+
+    /** Default constructor
+     */
+    IntrusiveList(void);
+
+    /** Copy constructor
+     *
+     * An object can only be linked into one list per hook.
+     */
+    IntrusiveList(const IntrusiveList<T, Tag, Member>& from) = delete;
+
+    /** Move constructor
+     *
+     * @param from          This object is copied to this list (stolen).
+     */
+    IntrusiveList(IntrusiveList<T, Tag, Member>&& from);
+
+    /** Destructor
+     *
+     * Objects are unlinked, not destroyed.
+     */
+    ~IntrusiveList(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not copyable, see copy constructor.
+     */
+    const IntrusiveList<T, Tag, Member>& operator=(
+        const IntrusiveList<T, Tag, Member>& from) = delete;
+
+    /** Move assignment operator
+     *
+     * @param from          This object is assigned to this list (stolen).
+     * @return              This object.
+     */
+    IntrusiveList<T, Tag, Member>& operator=(
+        IntrusiveList<T, Tag, Member>&& from);
+
+// Operations
+
+    /** Link object at position
+     *
+     * @param pos           Position to link the object at.
+     * @param obj           Object to link, must not be in a list by this hook.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    IntrusiveList<T, Tag, Member>& add(const int& pos, T& obj);
+
+    /** Link object at the front (O(1))
+     *
+     * @param obj           Object to link.
+     * @return              Reference to this object.
+     */
+    IntrusiveList<T, Tag, Member>& push_front(T& obj);
+
+    /** Link object at the end (O(1))
+     *
+     * @param obj           Object to link.
+     * @return              Reference to this object.
+     */
+    IntrusiveList<T, Tag, Member>& push_back(T& obj);
+
+    /** Unlink object at position
+     *
+     * @param pos           Position to unlink.
+     * @return              The unlinked object.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    T& rm(const int& pos);
+
+    /** Unlink an object by identity
+     *
+     * @param obj           Object to unlink.
+     * @return              false if obj isn't in this list.
+     */
+    bool remove(T& obj);
+
+    /** Unlink every object
+     *
+     * @return              Reference to this object.
+     */
+    IntrusiveList<T, Tag, Member>& clear(void);
+
+    /** Swap contents with another list
+     *
+     * @param with          List to swap with.
+     */
+    void swap(IntrusiveList<T, Tag, Member>& with);
+
+    /** Reverse the list
+     *
+     * @return              Reference to this object.
+     */
+    IntrusiveList<T, Tag, Member>& reverse(void);
+
+    /** Merge lists
+     *
+     * @param pos           List position to do the merge.
+     * @param with          List whose objects are moved in, left empty.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid
+     *                      or if with is a reference to this object.
+     */
+    IntrusiveList<T, Tag, Member>& merge(const int& pos,
+                                         IntrusiveList<T, Tag, Member>& with);
+
+    /** Sort the list (merge sort)
+     *
+     * @return              Reference to this object.
+     */
+    IntrusiveList<T, Tag, Member>& sort(void);
+
+    /** Sort the list with a custom comparator (merge sort)
+     *
+     * Iterative, stable and in place, objects are only relinked. If comp
+     * throws, every object is still in the list, in no particular order.
+     *
+     * @param comp          Strict weak ordering, comp(a, b) is true if a goes
+     *                      before b.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    IntrusiveList<T, Tag, Member>& sort(Compare comp);
+
+// Access
+
+    /** Get size
+     *
+     * @return              Current size of the list.
+     */
+    const int& size(void) const;
+
+    /** Is list empty?
+     *
+     * @return              true or false.
+     */
+    bool isEmpty(void) const;
+
+    /** Peek at position
+     *
+     * @param pos           Possition to peek at.
+     * @return              Object at the specified position.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    T& peek(const int& pos) const;
+
+// Iterators
+
+    /** Iterator to the first object
+     */
+    iterator begin(void);
+    const_iterator begin(void) const;
+
+    /** Iterator past the last object
+     */
+    iterator end(void);
+    const_iterator end(void) const;
+
+private:
+    typedef ListHook<T, Tag> Hook;
+    typedef std::integral_constant<bool, Member == nullptr> IsBase;
+
+    T* head;    // First object, nullptr if empty
+    T* tail;    // Last object, nullptr if empty
+    int n;      // List size
+
+    // Helper functions
+    static T*& next(T* obj);
+    static Hook& hook(T& obj, std::true_type);
+    static Hook& hook(T& obj, std::false_type);
+    T** linkTo(int pos, T** prev);
+    template<class Compare>
+    static void merge(T*& left, T*& right, T** tail, Compare comp);
+};
+
+/**
+ * Forward iterator over an IntrusiveList.
+ */
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+template<bool Const>
+class IntrusiveList<T, Tag, Member>::Iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename std::conditional<Const, const T*, T*>::type pointer;
+    typedef typename std::conditional<Const, const T&, T&>::type reference;
+
+    /** Default constructor
+     */
+    Iterator(void)
+        : obj(nullptr)
+    {
+    }
+
+    /** Copy constructor, also converts iterator to const_iterator
+     *
+     * @param from      Iterator that is to be copied.
+     */
+    Iterator(const Iterator<false>& from)
+        : obj(from.obj)
+    {
+    }
+
+    /** Equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    template<bool C>
+    bool operator==(const Iterator<C>& that) const
+    {
+        return this->obj == that.obj;
+    }
+
+    /** Not equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    template<bool C>
+    bool operator!=(const Iterator<C>& that) const
+    {
+        return this->obj != that.obj;
+    }
+
+    /** Prefix increment operator
+     *
+     * @return          Reference to this object.
+     */
+    Iterator& operator++(void)
+    {
+        obj = IntrusiveList<T, Tag, Member>::next(obj);
+        return *this;
+    }
+
+    /** Postfix increment operator
+     *
+     * @return          Rvalue object with pre increment position.
+     */
+    Iterator operator++(int)
+    {
+        Iterator tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    /** Dereference operator
+     *
+     * @return          Reference to the iterators current object.
+     */
+    reference operator*(void) const
+    {
+        return *obj;
+    }
+
+    /** Member access operator
+     *
+     * @return          Pointer to the iterators current object.
+     */
+    pointer operator->(void) const
+    {
+        return obj;
+    }
+
+private:
+    friend class IntrusiveList<T, Tag, Member>;
+    friend class Iterator<!Const>;
+
+    /** Constructor
+     *
+     * @param Obj       Current object, nullptr for end().
+     */
+    explicit Iterator(T* Obj)
+        : obj(Obj)
+    {
+    }
+
+    T* obj;     // Current object, nullptr at end
+};
+
+// ****************************** Life cycle ***********************************
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>::IntrusiveList(void)
+    : head(nullptr), tail(nullptr), n(0)
+{
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>::IntrusiveList(
+    IntrusiveList<T, Tag, Member>&& from)
+    : head(from.head), tail(from.tail), n(from.n)
+{
+    from.head = from.tail = nullptr;
+    from.n    = 0;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>::~IntrusiveList(void)
+{
+    clear();
+}
+
+// ****************************** Operators  ***********************************
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::operator=(
+    IntrusiveList<T, Tag, Member>&& from)
+{
+    if (&from != this) {
+        clear();
+        swap(from);
+    }
+    return *this;
+}
+
+// ****************************** Operations ***********************************
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::add(
+    const int& pos, T& obj)
+{
+    if (pos < 0 || pos > n)
+        throw std::invalid_argument("IntrusiveList<T>::add");
+
+    if (pos == n)
+        return push_back(obj);
+
+    T*  prev;
+    T** curr  = linkTo(pos, &prev);
+    next(&obj) = *curr;
+    *curr      = &obj;
+    this->n++;
+
+    return *this;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::push_front(
+    T& obj)
+{
+    next(&obj) = head;
+    head       = &obj;
+    if (tail == nullptr)
+        tail = &obj;
+    this->n++;
+
+    return *this;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::push_back(
+    T& obj)
+{
+    next(&obj) = nullptr;
+    if (tail != nullptr)
+        next(tail) = &obj;
+    else
+        head = &obj;
+    tail = &obj;
+    this->n++;
+
+    return *this;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+T& IntrusiveList<T, Tag, Member>::rm(const int& pos)
+{
+    if (pos < 0 || pos >= n)
+        throw std::invalid_argument("IntrusiveList<T>::rm");
+
+    T*  prev;
+    T** curr = linkTo(pos, &prev);
+    T*  obj  = *curr;
+    *curr    = next(obj);
+    if (obj == tail)
+        tail = prev;
+    next(obj) = nullptr;
+    this->n--;
+
+    return *obj;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+bool IntrusiveList<T, Tag, Member>::remove(T& obj)
+{
+    T* prev = nullptr;
+    for (T** curr = &head; *curr != nullptr; curr = &next(*curr)) {
+        if (*curr == &obj) {
+            *curr = next(&obj);
+            if (tail == &obj)
+                tail = prev;
+            next(&obj) = nullptr;
+            this->n--;
+            return true;
+        }
+        prev = *curr;
+    }
+
+    return false;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::clear(void)
+{
+    for (T* curr = head, *nextObj; curr != nullptr; curr = nextObj) {
+        nextObj    = next(curr);
+        next(curr) = nullptr;
+    }
+    head = tail = nullptr;
+    this->n     = 0;
+
+    return *this;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+void IntrusiveList<T, Tag, Member>::swap(IntrusiveList<T, Tag, Member>& with)
+{
+    std::swap(this->head, with.head);
+    std::swap(this->tail, with.tail);
+    std::swap(this->n, with.n);
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::reverse(void)
+{
+    T* newHead = nullptr;
+    tail       = head;
+    for (T* curr = head, *nextObj; curr != nullptr; curr = nextObj) {
+        nextObj    = next(curr);
+        next(curr) = newHead;
+        newHead    = curr;
+    }
+    head = newHead;
+
+    return *this;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::merge(
+    const int& pos, IntrusiveList<T, Tag, Member>& with)
+{
+    if (pos < 0 || pos > n || &with == this)
+        throw std::invalid_argument("IntrusiveList<T>::merge");
+
+    if (with.head == nullptr)
+        return *this;
+
+    T*  prev;
+    T** curr = pos == n && tail != nullptr ? &next(tail) : linkTo(pos, &prev);
+    next(with.tail) = *curr;
+    if (*curr == nullptr)
+        tail = with.tail;
+    *curr    = with.head;
+    this->n += with.n;
+
+    with.head = with.tail = nullptr;
+    with.n    = 0;
+
+    return *this;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::sort(void)
+{
+    return sort(std::less<T>());
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+template<class Compare>
+IntrusiveList<T, Tag, Member>& IntrusiveList<T, Tag, Member>::sort(
+    Compare comp)
+{
+    // pending[k] is empty or holds a sorted run of 2^k objects, adding an
+    // object works like incrementing a binary counter. Older runs are always
+    // on the left, so equal objects keep their order.
+    T* pending[8 * sizeof(int)] = { nullptr };
+    T* run    = nullptr;
+    T* sorted = nullptr;
+    T* rest   = head;
+    T* last   = nullptr;
+    int top   = 0;
+
+    try {
+        while (rest != nullptr) {
+            run       = rest;
+            rest      = next(run);
+            next(run) = nullptr;
+
+            int k = 0;
+            for (; k < top && pending[k] != nullptr; k++) {
+                merge(pending[k], run, &last, comp);
+                std::swap(pending[k], run);
+            }
+            if (k == top)
+                top++;
+            std::swap(pending[k], run);
+        }
+
+        last = nullptr;
+        for (int k = 0; k < top; k++)
+            if (pending[k] != nullptr) {
+                merge(pending[k], sorted, &last, comp);
+                std::swap(pending[k], sorted);
+            }
+    }
+    catch (...) {
+        // A comparison threw. merge() keeps its objects linked, chain the
+        // pieces back together so that no hook is lost.
+        T** link    = &head;
+        auto gather = [this, &link](T* chain) {
+            for (*link = chain; *link != nullptr; link = &next(*link))
+                tail = *link;
+        };
+        for (int k = 0; k < top; k++)
+            gather(pending[k]);
+        gather(run);
+        gather(sorted);
+        gather(rest);
+        throw;
+    }
+
+    head = sorted;
+    tail = last;
+
+    return *this;
+}
+
+// ****************************** Access ***************************************
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+const int& IntrusiveList<T, Tag, Member>::size(void) const
+{
+    return this->n;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+bool IntrusiveList<T, Tag, Member>::isEmpty(void) const
+{
+    return this->n <= 0;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+T& IntrusiveList<T, Tag, Member>::peek(const int& pos) const
+{
+    if (pos < 0 || pos >= n)
+        throw std::invalid_argument("IntrusiveList<T>::peek");
+
+    if (pos == n - 1)
+        return *tail;
+
+    T* curr = head;
+    for (int i = 0; i < pos; i++)
+        curr = next(curr);
+
+    return *curr;
+}
+
+// ****************************** Iterators ************************************
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+typename IntrusiveList<T, Tag, Member>::iterator
+IntrusiveList<T, Tag, Member>::begin(void)
+{
+    return iterator(head);
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+typename IntrusiveList<T, Tag, Member>::const_iterator
+IntrusiveList<T, Tag, Member>::begin(void) const
+{
+    return const_iterator(head);
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+typename IntrusiveList<T, Tag, Member>::iterator
+IntrusiveList<T, Tag, Member>::end(void)
+{
+    return iterator(nullptr);
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+typename IntrusiveList<T, Tag, Member>::const_iterator
+IntrusiveList<T, Tag, Member>::end(void) const
+{
+    return const_iterator(nullptr);
+}
+
+// ****************************** Private **************************************
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+T*& IntrusiveList<T, Tag, Member>::next(T* obj)
+{
+    return hook(*obj, IsBase()).next;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+ListHook<T, Tag>& IntrusiveList<T, Tag, Member>::hook(T& obj, std::true_type)
+{
+    return obj;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+ListHook<T, Tag>& IntrusiveList<T, Tag, Member>::hook(T& obj, std::false_type)
+{
+    return obj.*Member;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+T** IntrusiveList<T, Tag, Member>::linkTo(int pos, T** prev)
+{
+    T** curr = &head;
+    *prev    = nullptr;
+    for (int i = 0; i < pos; i++) {
+        *prev = *curr;
+        curr  = &next(*curr);
+    }
+
+    return curr;
+}
+
+template<class T, class Tag, ListHook<T, Tag> T::*Member>
+template<class Compare>
+void IntrusiveList<T, Tag, Member>::merge(T*& left, T*& right, T** tail,
+                                          Compare comp)
+{
+    T*  l    = left;
+    T*  r    = right;
+    T** link = &left;
+    right    = nullptr;
+
+    // Take from the right only if strictly smaller, keeps equal keys in order.
+    // If comp throws, what's left is linked after the merged part so that
+    // left still holds every object.
+    try {
+        while (l != nullptr && r != nullptr) {
+            if (comp(*r, *l)) {
+                *link = r;
+                r     = next(r);
+            }
+            else {
+                *link = l;
+                l     = next(l);
+            }
+            *tail = *link;
+            link  = &next(*link);
+        }
+    }
+    catch (...) {
+        *link = l;
+        while (*link != nullptr)
+            link = &next(*link);
+        *link = r;
+        throw;
+    }
+
+    // Whichever side is left over ends the merged chain
+    *link = l != nullptr ? l : r;
+    for (; *link != nullptr; link = &next(*link))
+        *tail = *link;
+}
+
+#endif // __INTRUSIVE_LIST_H__
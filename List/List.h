@@ -3,31 +3,98 @@
 
 // Libraries
 #include <stdexcept>    // invalid_argument
+#include <algorithm>    // push_heap, pop_heap
+#include <cstddef>      // ptrdiff_t
+#include <cstdint>      // int32_t, int64_t
+#include <cstring>      // memcpy
+#include <exception>    // exception_ptr
+#include <functional>   // less, equal_to
 #include <iostream>
+#include <iterator>     // forward_iterator_tag
+#include <locale>       // locale::classic
+#include <memory>       // shared_ptr, allocator_traits
+#include <system_error>
+#include <thread>
+#include <type_traits>  // conditional, is_trivially_destructible
+#include <utility>      // forward, move, swap
+#include <vector>
 
 // My headers
+#include "BufferedIO.h"
 #include "Node.h"
+#include "NodePool.h"
 
-template<class T>
+template<class T, class Alloc = std::allocator<T>>
 class List {
+private:
+    template<bool Const> class Iterator;
+
 public:
+    typedef Iterator<false> iterator;
+    typedef Iterator<true>  const_iterator;
+
+    // Lazy range of matches, see matches()
+    template<class Pred> class Matches;
+
+    // Predicate comparing against its own copy of a key, see matches()
+    struct KeyEqual {
+        T key;
+        bool operator()(const T& data) const { return data == key; }
+    };
+
 // Life cycle
     
     /** Default constructor
+     *
+     * Nodes are allocated with a default constructed Alloc.
      */
     List(void);
 
+    /** Constructor (allocator version)
+     *
+     * @param Allocator     Allocator nodes are taken from, rebound to Node<T>.
+     */
+    explicit List(const Alloc& Allocator);
+
+    /** Constructor (pooled version)
+     *
+     * @param Pool          Pool to allocate nodes from. The pool may be shared
+     *                      with other lists, nullptr means use the allocator.
+     * @param Allocator     Allocator for nodes when Pool is nullptr.
+     */
+    explicit List(std::shared_ptr<NodePool<T, Alloc>> Pool,
+                  const Alloc& Allocator = Alloc());
+
     /** Copy constructor
-     * 
+     *
+     * The allocator is obtained through select_on_container_copy_construction.
+     *
+     * @param from          This object is copied to this list (deep).
+     */
+    List(const List<T, Alloc>& from);
+
+    /** Copy constructor (allocator version)
+     *
      * @param from          This object is copied to this list (deep).
+     * @param Allocator     Allocator for the copy.
      */
-    List(const List<T>& from);
+    List(const List<T, Alloc>& from, const Alloc& Allocator);
 
     /** Move constructor
      *
      * @param from          This object is copied to this list (stolen).
      */
-    List(List<T>&& from);
+    List(List<T, Alloc>&& from);
+
+    /** Move constructor (allocator version)
+     *
+     * Nodes are stolen if they came from a pool or the allocators are equal,
+     * otherwise every element is moved into a node from Allocator.
+     *
+     * @param from          This object is moved to this list.
+     * @param Allocator     Allocator for the new list.
+     */
+    List(List<T, Alloc>&& from, const Alloc& Allocator);
 
     /** Destructor
      */
@@ -36,60 +103,67 @@ public:
 // Operators
 
     /** Assignment operator
-     * 
+     *
+     * The allocator is taken over from from only if Alloc propagates on copy
+     * assignment.
+     *
      * @param from          This object is assigned to this list (deep).
      * @return              This object.
      */
-    const List<T>& operator=(const List<T>& from);
+    const List<T, Alloc>& operator=(const List<T, Alloc>& from);
 
     /** Move assignment operator
+     *
+     * Nodes are stolen if Alloc propagates on move assignment, if they came
+     * from a pool or if the allocators are equal. Otherwise every element is
+     * moved into a node from this list's allocator.
      *
      * @param from          This object is assigned to this list (stolen).
      * @return              This object.
      */
-    const List<T>& operator=(const List<T>&& from);
+    const List<T, Alloc>& operator=(List<T, Alloc>&& from);
 
     /** Equal to operator
      * 
      * @param obj           List to compare with this object.
      * @return              true / false.
      */
-    bool operator==(const List<T>& obj);
+    bool operator==(const List<T, Alloc>& obj);
 
     /** Not equal to operator
      * 
      * @param obj           List to compare with this object.
      * @return              true / false.
      */
-    bool operator!=(const List<T>& obj);
+    bool operator!=(const List<T, Alloc>& obj);
 
     /** Greater than operator
      * 
      * @param obj           List to compare with this object.
      * @return              true / false.
      */
-    bool operator>(const List<T>& obj);
+    bool operator>(const List<T, Alloc>& obj);
 
     /** Greater than or equal operator
      * 
      * @param obj           List to compare with this object.
      * @return              true / false.
      */
-    bool operator>=(const List<T>& obj);
+    bool operator>=(const List<T, Alloc>& obj);
 
     /** Less than operator
      * 
      * @param obj           List to compare with this object.
      * @return              true / false.
      */
-    bool operator<(const List<T>& obj);
+    bool operator<(const List<T, Alloc>& obj);
 
     /** Less than or equal operator
      * 
      * @param obj           List to compare with this object.
      * @return              true / false.
      */
-    bool operator<=(const List<T>& obj);
+    bool operator<=(const List<T, Alloc>& obj);
 
 // Operations
 
@@ -101,12 +175,33 @@ public:
      *
      * @invalid_argument    An exception is generated if position is invalid.
      */
-    List<T>& add(const int& pos, const T& data);
+    List<T, Alloc>& add(const int& pos, const T& data);
+
+    /** Add new node by position (move version)
+     *
+     * @param pos           List position to insert the new node.
+     * @param data          Data to move into the new node.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid.
+     */
+    List<T, Alloc>& add(const int& pos, T&& data);
+
+    /** Construct new node by position
+     *
+     * @param pos           List position to insert the new node.
+     * @param args          Arguments forwarded to the constructor of T.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid.
+     */
+    template<class... Args>
+    List<T, Alloc>& emplace(const int& pos, Args&&... args);
 
     /** Remove node by position
      * 
      * @param pos           List position to insert the new node.
-     * @return              Data stored in the removed node.
+     * @return              Data stored in the removed node (moved out).
      *
      * @invalid_argument    An exception is generated if invalid position.
      */
@@ -116,13 +211,26 @@ public:
      *
      * @return              Reference to this object.
      */
-    List<T>& clear(void);
+    List<T, Alloc>& clear(void);
+
+    /** Swap contents with another list
+     *
+     * Nodes and pools are exchanged, no element is touched. Allocators are
+     * exchanged if Alloc propagates on swap.
+     *
+     * @param with          List to swap with.
+     *
+     * @invalid_argument    An exception is generated if nodes would end up
+     *                      with a list that can't free them, ie. allocators
+     *                      that don't propagate and differ.
+     */
+    void swap(List<T, Alloc>& with);
 
     /** Reverse the list
      *
      * @return              Reference to this object.
      */
-    List<T>& reverse(void);
+    List<T, Alloc>& reverse(void);
 
     /** Merge lists
      *
@@ -130,382 +238,2662 @@ public:
      * @param pos           List position to do the merge.
      * @return              Reference to this object.
      *
-     * @invalid_argument    An exception is generated if position is invalid or
-     *                      if with is a reference to this object.
+     * @invalid_argument    An exception is generated if position is invalid,
+     *                      if with is a reference to this object or if the two
+     *                      lists don't allocate nodes from the same pool or
+     *                      from equal allocators.
      */
-    List<T>& merge(const int& pos, List<T>& with);
+    List<T, Alloc>& merge(const int& pos, List<T, Alloc>& with);
 
     /** Sort the list (merge sort)
+     *
+     * Stable under operator<. Lists of integers of RADIX_SORT_MIN elements
+     * or more are radix sorted instead, which gives the same order. Floating
+     * point lists are not: radixSort() would put -0.0 before 0.0 and move
+     * NaNs, call it explicitly where that's fine.
      *
      * @return              Reference to this object.
      */
-    List<T>& sort(void);
+    List<T, Alloc>& sort(void);
 
-// Access
+    /** Sort the list with a custom comparator (merge sort)
+     *
+     * Iterative, stable and in place. Ascending and descending runs already
+     * present in the list are picked up as they are, so nearly sorted input
+     * sorts in close to linear time.
+     *
+     * @param comp          Strict weak ordering, comp(a, b) is true if a goes
+     *                      before b.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    List<T, Alloc>& sort(Compare comp);
 
-    /** Get size
+    /** Sort the list by a numeric key (LSD radix sort)
      *
-     * @return              Current size of the list.
+     * Nodes are distributed into bucket chains by one 8 bit digit of the key
+     * (11 bit from RADIX_WIDE_MIN elements on) and the chains concatenated
+     * again, O(n) per pass and no comparisons or element copies. Digits every
+     * key agrees on are skipped. Stable.
+     *
+     * Floating point keys sort by value, except that -0.0 goes before 0.0
+     * and NaNs go to the end (or the front if their sign bit is set).
+     *
+     * @return              Reference to this object.
      */
-    const int& size(void) const;
+    List<T, Alloc>& radixSort(void);
 
-    /** Is list empty?
+    /** Sort the list by a key taken from every element (LSD radix sort)
      *
-     * @return              true or false.
+     * @param key           key(data) gives an integral or floating point
+     *                      value, called once per element and pass.
+     * @return              Reference to this object.
      */
-    bool isEmpty(void) const;
+    template<class Key>
+    List<T, Alloc>& radixSort(Key key);
 
-    /** Search node (traverses the list for matches)
-     * 
-     * @param key           Node to be searched for.
-     * @return              List with all positions containing a match.
+    /** Sort the list on several threads (merge sort)
+     *
+     * The list is cut into one segment per thread in a single pass, every
+     * segment is sorted on its own thread and the sorted segments are merged
+     * back pairwise. Nodes are relinked, elements are never copied. Lists
+     * shorter than PARALLEL_SORT_MIN are sorted on the calling thread, so
+     * are segments no thread could be started for.
+     *
+     * @param threads       Number of threads, 0 means one per hardware thread.
+     * @return              Reference to this object.
      */
-    List<int> search(const T& key) const;
+    List<T, Alloc>& sortParallel(unsigned threads = 0);
 
-    /** Peek at position
+    /** Sort the list on several threads with a custom comparator
      *
-     * @param pos           Possition to peek at.
-     * @return              Data stored in the specified position.
+     * @param threads       Number of threads, 0 means one per hardware thread.
+     * If comp throws, the first exception is rethrown once every thread is
+     * done. The list then keeps all its elements, in no particular order.
      *
-     * @invalid_argument    An exception is generated.
+     * @param comp          Strict weak ordering, called concurrently from
+     *                      several threads.
+     * @return              Reference to this object.
      */
-    const T& peek(const int& pos) const;    
+    template<class Compare>
+    List<T, Alloc>& sortParallel(unsigned threads, Compare comp);
 
-    /** Prints the list
+    /** Merge a sorted list into this sorted list (O(n + m))
      *
-     * @param start         Specifies position to start printing.
-     * @param end           Specifies position (inclusive) to stop printing.
+     * Nodes of with are relinked in between the nodes of this list, nothing
+     * is copied. Stable, among equal elements those of this list go first.
+     *
+     * @param with          Sorted list to merge in (steal), left empty.
      * @return              Reference to this object.
      *
-     * @invalid_argument    An exception is generated if start < end or if
-     *                      start, end out of position.
+     * @invalid_argument    An exception is generated if with is a reference to
+     *                      this object or if the two lists don't allocate
+     *                      nodes from the same pool or from equal allocators.
      */
-    const List<T>& print(void) const;
+    List<T, Alloc>& mergeSorted(List<T, Alloc>& with);
 
-protected:
+    /** Merge a sorted list into this sorted list with a custom comparator
+     *
+     * @param with          List sorted by comp to merge in (steal).
+     * @param comp          Strict weak ordering both lists are sorted by.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    List<T, Alloc>& mergeSorted(List<T, Alloc>& with, Compare comp);
 
-    Node<T>* head;      // List head
-    int n;              // List size
+    /** Merge many sorted lists into this sorted list (O(n log k))
+     *
+     * The front nodes of the k lists are kept in a heap, so every node is
+     * relinked once after log k comparisons. Stable, among equal elements
+     * those of this list go first, then those of lists[0], lists[1], ...
+     *
+     * @param lists         Sorted lists to merge in (steal), left empty.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if a list is null, this
+     *                      object or doesn't share the node source of this
+     *                      list. Nothing is merged then.
+     */
+    List<T, Alloc>& mergeSorted(const std::vector<List<T, Alloc>*>& lists);
 
-private:
-    // Helper functions
-    void sort_r(Node<T>** head);
-    void split(Node<T>* head, Node<T>** left, Node<T>** right);
-    Node<T>* merge(Node<T>* left, Node<T>* right);
+    /** Merge many sorted lists into this sorted list with a custom comparator
+     *
+     * @param lists         Lists sorted by comp to merge in (steal).
+     * @param comp          Strict weak ordering all lists are sorted by.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    List<T, Alloc>& mergeSorted(const std::vector<List<T, Alloc>*>& lists,
+                                Compare comp);
 
-};
+    /** Sorted union (O(n + m))
+     *
+     * Like std::set_union: an element found k times in this list and m times
+     * in with is kept max(k, m) times. Nodes of with are relinked into this
+     * list, the ones matching an element of this list are destroyed.
+     *
+     * @param with          Sorted list to unite with (steal), left empty.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    Same as mergeSorted().
+     */
+    List<T, Alloc>& unite(List<T, Alloc>& with);
 
-// ****************************** Life cycle ***********************************
+    /** Sorted union with a custom comparator
+     *
+     * @param with          List sorted by comp to unite with (steal).
+     * @param comp          Strict weak ordering both lists are sorted by.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    List<T, Alloc>& unite(List<T, Alloc>& with, Compare comp);
 
-template<class T>
-List<T>::List(void)
-    : head(nullptr), n(0)
-{
-}
+    /** Sorted intersection (O(n + m))
+     *
+     * Like std::set_intersection: an element found k times in this list and
+     * m times in with is kept min(k, m) times. Nodes of this list without a
+     * match are destroyed, with is left alone.
+     *
+     * @param with          Sorted list to intersect with.
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& intersect(const List<T, Alloc>& with);
 
-template<class T>
-List<T>::List(const List<T>& from)
-    : n(from.n)
-{
-    head->setData(from->getData());
-    for (Node<T>* to = head, fr = from.head; fr->getNext() != nullptr;
-         to = to->getNext(), fr = fr->getNext())
-        to->setNext(new Node<T>(fr->getNext()->getData()));
-}
+    /** Sorted intersection with a custom comparator
+     *
+     * @param with          List sorted by comp to intersect with.
+     * @param comp          Strict weak ordering both lists are sorted by.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    List<T, Alloc>& intersect(const List<T, Alloc>& with, Compare comp);
 
-template<class T>
-List<T>::List( List<T>&& from)
-    : head(from.head), n(from.n)
-{
-    from.head = nullptr;
-    from.n    = 0;
-}
+    /** Sorted difference (O(n + m))
+     *
+     * Like std::set_difference: every element of with removes one equal
+     * element of this list. Removed nodes are destroyed, with is left alone.
+     *
+     * @param with          Sorted list of elements to remove.
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& subtract(const List<T, Alloc>& with);
 
-template<class T>
-List<T>::~List(void)
-{
-    for (Node<T>* curr = head, *nextNode; curr != nullptr; curr = nextNode) {
-        nextNode = curr->getNext();
-        delete curr;
-    }
-    this->head = nullptr;
-    this->n    = 0;
-}
+    /** Sorted difference with a custom comparator
+     *
+     * @param with          List sorted by comp of elements to remove.
+     * @param comp          Strict weak ordering both lists are sorted by.
+     * @return              Reference to this object.
+     */
+    template<class Compare>
+    List<T, Alloc>& subtract(const List<T, Alloc>& with, Compare comp);
 
-// ****************************** Operators  ***********************************
+    /** Remove consecutive duplicates (O(n))
+     *
+     * Only the first of a run of equal elements is kept, a sorted list ends
+     * up with distinct elements.
+     *
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& unique(void);
 
-template<class T>
-const List<T>& List<T>::operator=(const List<T>& from)
-{
-    List::List(from); // call copy constructor
-    return *this;
-}
+    /** Remove consecutive duplicates with a custom predicate
+     *
+     * @param same          same(a, b) is true if b, right after a, is a
+     *                      duplicate of a.
+     * @return              Reference to this object.
+     */
+    template<class BinaryPred>
+    List<T, Alloc>& unique(BinaryPred same);
 
-template<class T>
-const List<T>& List<T>::operator=(const List<T>&& from)
-{
-    List::List(from); // call move constructor
-    return *this;
-}
+    /** Move the nodes into consecutive memory in list order
+     *
+     * Nodes are rebuilt in a single run of pool slots so every next points to
+     * the neighbouring slot and a traversal streams through memory. Elements
+     * are moved (copied if their move may throw). References, pointers and
+     * iterators to elements are invalidated.
+     *
+     * A list without a pool moves to a pool of its own, with slabs from its
+     * allocator. From then on it can only merge / splice with lists sharing
+     * that pool. A list sharing its pool with other lists that hold nodes is
+     * left as it is.
+     *
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& compact(void);
 
-template<class T>
-bool List<T>::operator==(const List<T>& obj)
-{
-    if (this->n != obj.n)
-        return false;
+    /** Compact automatically after sorting
+     *
+     * After sort() and sortParallel() the list is compacted if its
+     * fragmentation() exceeds threshold. Off by default, sorting keeps
+     * elements in place unless this is switched on.
+     *
+     * @param threshold     Fragmentation in [0, 1] above which to compact,
+     *                      1 or more switches it off again.
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& autoCompact(double threshold);
 
-    // sizes match, compare element by element
-    for (Node<T>* curr_this = head, *curr_obj = obj.head; curr_this != nullptr;
-         curr_this = curr_this->getNext(), curr_obj = curr_obj->getNext())
-        if (curr_this->getData() != curr_obj->getData())
-            return false;
-    return true;
-}
+    /** Prefetch ahead during scans (jump pointers)
+     *
+     * Walking a list is a chain of dependent loads, one cache miss at a
+     * time. With this on, the list keeps the node at each position in a side
+     * table, and every scan (search, find_first, count, visit, == and the
+     * positional walks of peek, add, rm, ...) prefetches the node the
+     * table has distance positions further on. Repeated scans then have
+     * distance misses in flight instead of one.
+     *
+     * The table is filled in here and refreshed by the walks of non-const
+     * operations. Const scans only read it, so they may still run
+     * concurrently. Mutations leave it stale, which only makes some
+     * prefetches miss, call prefetch() again to refresh it after reordering
+     * the list. Costs a pointer per element while on.
+     *
+     * @param distance      Nodes to prefetch ahead, 0 switches it off (the
+     *                      default).
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& prefetch(int distance);
 
-template<class T>
-bool List<T>::operator!=(const List<T>& obj)
-{
-    return !(*this == obj);
-}
+    /** Add new node at the end (O(1))
+     *
+     * @param data          Data to store in the new node.
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& push_back(const T& data);
 
-template<class T>
-bool List<T>::operator>(const List<T>& obj)
-{
-    Node<T>* curr_this = head;
-    Node<T>* curr_obj  = obj.head;
+    /** Add new node at the end (O(1), move version)
+     *
+     * @param data          Data to move into the new node.
+     * @return              Reference to this object.
+     */
+    List<T, Alloc>& push_back(T&& data);
 
-    // compare element by element
-    for (int n = this->n > obj.n ? this->n : obj.n, i = 0; i < n; i++,
-         curr_this = curr_this->getNext(), curr_obj = curr_obj->getNext())
-        if (curr_this->getData() <= curr_obj->getData())
-            return false;
-    return this->n > obj.n;
-}
+    /** Construct new node at the end (O(1))
+     *
+     * @param args          Arguments forwarded to the constructor of T.
+     * @return              Reference to this object.
+     */
+    template<class... Args>
+    List<T, Alloc>& emplace_back(Args&&... args);
 
-template<class T>
-bool List<T>::operator>=(const List<T>& obj)
-{
-    return *this == obj || *this > obj;
-}
+    /** Append a list at the end (O(1))
+     *
+     * Same as merge(size(), with).
+     *
+     * @param with          List to append to this object (steal).
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if with is a reference to
+     *                      this object or if the two lists don't allocate
+     *                      nodes from the same pool.
+     */
+    List<T, Alloc>& append(List<T, Alloc>& with);
 
-template<class T>
-bool List<T>::operator<(const List<T>& obj)
-{
-    return !(*this >= obj); 
-}
+    /** Smallest list that sortParallel() splits between threads
+     */
+    static const int PARALLEL_SORT_MIN = 1 << 15;
 
-template<class T>
-bool List<T>::operator<=(const List<T>& obj)
-{
-    return *this == obj || *this < obj;
-}
+    /** Smallest list of numbers that sort() radix sorts
+     */
+    static const int RADIX_SORT_MIN = 1 << 8;
 
-// ****************************** Operations ***********************************
+    /** Smallest list that radixSort() sorts by 11 bit instead of 8 bit digits
+     */
+    static const int RADIX_WIDE_MIN = 1 << 16;
 
-template<class T>
-List<T>& List<T>::add(const int& pos, const T& data)
-{
-    if (pos < 0 || pos > n)
-        throw std::invalid_argument("List<T>::add");
+// Access
 
-    // Get in position to insert node
-    Node<T>** curr = &head;
-    for (int i = 0; i < pos; i++)
-        curr = (*curr)->nextAdr();
+    /** Get size
+     *
+     * @return              Current size of the list.
+     */
+    const int& size(void) const;
 
-    // Insert node
-    *curr = new Node<T>(data, *curr); this->n++;
+    /** Get the allocator
+     *
+     * @return              Copy of the allocator nodes are taken from.
+     */
+    Alloc get_allocator(void) const;
 
-    return *this;
-}
+    /** Is list empty?
+     *
+     * @return              true or false.
+     */
+    bool isEmpty(void) const;
 
-template<class T>
-T List<T>::rm(const int& pos)
-{
-    if (pos < 0 || pos >= this->n)
-        throw std::invalid_argument("List<T>::rm"); 
+    /** Search node (traverses the list for matches)
+     *
+     * Allocates a node per match, prefer find_first(), count(), visit() or
+     * matches() when the positions aren't needed as a list.
+     *
+     * @param key           Node to be searched for.
+     * @return              List with all positions containing a match, in
+     *                      ascending order.
+     */
+    List<int> search(const T& key) const;
 
-    // Get in position to remove node
-    Node<T>** curr = &this->head;
-    for (int i = 0; i < pos; i++)
-        curr = (*curr)->nextAdr();
+    /** Find the first match
+     *
+     * @param key           Element to be searched for.
+     * @return              Position of the first match, -1 if none.
+     */
+    int find_first(const T& key) const;
 
-    // Remove node
-    Node<T>* tmp    = *curr;                // don't lose node, need clean
-    T        rmData = tmp->getData();       // don't lose data, need return
-    *curr           = (*curr)->getNext();
-    delete tmp;
+    /** Find the first element satisfying a predicate
+     *
+     * @param pred          Called as pred(data), returns bool.
+     * @return              Position of the first match, -1 if none.
+     */
+    template<class Pred>
+    int find_first_if(Pred pred) const;
 
-    return rmData;
-}
+    /** Count matches
+     *
+     * @param key           Element to be counted.
+     * @return              Number of elements equal to key.
+     */
+    int count(const T& key) const;
 
-template<class T>
-List<T>& List<T>::clear(void)
-{
-    List::~List();
-    return *this;
-}
+    /** Count elements satisfying a predicate
+     *
+     * @param pred          Called as pred(data), returns bool.
+     * @return              Number of elements pred accepted.
+     */
+    template<class Pred>
+    int count_if(Pred pred) const;
 
-template<class T>
-List<T>& List<T>::reverse(void)
-{
-    // reverse list
-    Node<T>* newHead = nullptr;
-    for (Node<T>* curr = this->head, *next; curr != nullptr; curr = next) {
-        next = curr->getNext();             // dont lose next node
-        newHead = &curr->setNext(newHead);  // place latest node in the front
-    }
+    /** Visit every match in order
+     *
+     * @param key           Element to be searched for.
+     * @param visit         Called as visit(pos, data), returns false to stop.
+     * @return              Number of matches visited.
+     */
+    template<class Visit>
+    int visit(const T& key, Visit visit) const;
+
+    /** Visit every element satisfying a predicate in order
+     *
+     * @param pred          Called as pred(data), returns bool.
+     * @param visit         Called as visit(pos, data), returns false to stop.
+     * @return              Number of matches visited.
+     */
+    template<class Pred, class Visit>
+    int visit_if(Pred pred, Visit visit) const;
+
+    /** Lazy range of matches
+     *
+     * Nothing is scanned up front, each increment walks to the next match,
+     * so breaking out of a loop early stops the scan. The list must not be
+     * changed while the range is in use.
+     *
+     * @param key           Element to be searched for, the range keeps a
+     *                      copy.
+     * @return              Range whose iterators yield the match positions.
+     */
+    Matches<KeyEqual> matches(const T& key) const;
+
+    /** Lazy range of elements satisfying a predicate
+     *
+     * @param pred          Called as pred(data), returns bool.
+     * @return              Range whose iterators yield the match positions.
+     */
+    template<class Pred>
+    Matches<Pred> matches_if(Pred pred) const;
+
+    /** Peek at position
+     *
+     * Positional access (peek, add, emplace, rm, merge) remembers the node in
+     * front of the position it ended on. An access at the same or a later
+     * position resumes from there instead of from head, so a loop over
+     * peek(i) is linear.
+     *
+     * @param pos           Possition to peek at.
+     * @return              Data stored in the specified position.
+     *
+     * @invalid_argument    An exception is generated.
+     */
+    const T& peek(const int& pos);
+
+    /** Peek at position, const version
+     *
+     * Walks from head and leaves the finger alone, so it is safe to call
+     * from several threads on a list nobody changes, but a loop over
+     * peek(i) is quadratic.
+     *
+     * @param pos           Possition to peek at.
+     * @return              Data stored in the specified position.
+     *
+     * @invalid_argument    An exception is generated.
+     */
+    const T& peek(const int& pos) const;
+
+    /** Get number of hops walked by positional access
+     *
+     * @return              Nodes stepped over since the list was created.
+     */
+    long hops(void) const;
+
+    /** Get number of hops saved by resuming from the finger
+     *
+     * @return              Nodes not stepped over thanks to the finger.
+     */
+    long hopsSaved(void) const;
+
+    /** Get fragmentation
+     *
+     * @return              Share of links that don't point to the next slot
+     *                      in memory, 0 right after compact().
+     */
+    double fragmentation(void) const;
+
+    /** Prints the list to std::cout
+     *
+     * Output is buffered and std::cout flushed once at the end. If std::cout
+     * isn't in its default format (flags, precision, width or locale were
+     * changed), elements go through its operator<< instead, so they come
+     * out as they would from std::cout << x.
+     *
+     * @return              Reference to this object.
+     */
+    const List<T, Alloc>& print(void) const;
+
+    /** Prints the list to a writer
+     *
+     * @param out           Writer to print to, not flushed.
+     * @param sep           Written after every element.
+     * @return              Reference to this object.
+     */
+    const List<T, Alloc>& print(Writer& out, char sep = ' ') const;
+
+    /** Write the list in binary (trivially copyable T only)
+     *
+     * @param out           Writer to write to, see BufferedIO.h for the
+     *                      format.
+     * @return              Reference to this object.
+     */
+    const List<T, Alloc>& save(Writer& out) const;
+
+    /** Replace the contents with a list written by save()
+     *
+     * Nodes are carved out of runs of consecutive pool slots, each run as
+     * long as all before it, reserved as the elements arrive: from the
+     * list's own pool, or a new pool with slabs from its allocator if it
+     * has none (see compact()). The list is left as it was if reading fails.
+     *
+     * @param in            Reader to read from.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if the input doesn't
+     *                      hold a list of T or ends early.
+     */
+    List<T, Alloc>& load(Reader& in);
+
+// Iterators
+
+    /** Iterator to the first element
+     */
+    iterator begin(void);
+    const_iterator begin(void) const;
+    const_iterator cbegin(void) const;
+
+    /** Iterator past the last element
+     */
+    iterator end(void);
+    const_iterator end(void) const;
+    const_iterator cend(void) const;
+
+    /** Iterator before the first element
+     *
+     * Not dereferenceable, used with the *_after operations to work on the
+     * front of the list.
+     */
+    iterator before_begin(void);
+    const_iterator before_begin(void) const;
+    const_iterator cbefore_begin(void) const;
+
+    /** Insert after iterator (O(1))
+     *
+     * @param pos           Iterator to the element to insert after.
+     * @param data          Data to store in the new node.
+     * @return              Iterator to the new element.
+     *
+     * @invalid_argument    An exception is generated if pos is end().
+     */
+    iterator insert_after(const_iterator pos, const T& data);
+
+    /** Insert after iterator (O(1), move version)
+     *
+     * @param pos           Iterator to the element to insert after.
+     * @param data          Data to move into the new node.
+     * @return              Iterator to the new element.
+     *
+     * @invalid_argument    An exception is generated if pos is end().
+     */
+    iterator insert_after(const_iterator pos, T&& data);
+
+    /** Construct after iterator (O(1))
+     *
+     * @param pos           Iterator to the element to insert after.
+     * @param args          Arguments forwarded to the constructor of T.
+     * @return              Iterator to the new element.
+     *
+     * @invalid_argument    An exception is generated if pos is end().
+     */
+    template<class... Args>
+    iterator emplace_after(const_iterator pos, Args&&... args);
+
+    /** Erase after iterator (O(1))
+     *
+     * @param pos           Iterator to the element before the one to erase.
+     * @return              Iterator to the element after the erased one.
+     *
+     * @invalid_argument    An exception is generated if there is no element
+     *                      after pos.
+     */
+    iterator erase_after(const_iterator pos);
+
+    /** Move all elements of a list in after iterator (O(1))
+     *
+     * @param pos           Iterator to the element to splice after.
+     * @param from          List to steal all nodes from.
+     *
+     * @invalid_argument    An exception is generated if pos is end(), if from
+     *                      is this list or if the two lists don't allocate
+     *                      nodes from the same pool or from equal allocators.
+     */
+    void splice_after(const_iterator pos, List<T, Alloc>& from);
+
+    /** Move one element of a list in after iterator (O(1))
+     *
+     * @param pos           Iterator to the element to splice after.
+     * @param from          List to steal the node from, may be this list.
+     * @param it            Iterator into from, the element after it is moved.
+     *
+     * @invalid_argument    An exception is generated if pos is end(), if there
+     *                      is no element after it or if the two lists don't
+     *                      allocate nodes from the same pool or from equal
+     *                      allocators.
+     */
+    void splice_after(const_iterator pos, List<T, Alloc>& from,
+                      const_iterator it);
+
+protected:
+
+    Node<T>* head;      // List head
+    Node<T>* tail;      // Last node, nullptr if empty
+    int n;              // List size
+
+    Alloc alloc;        // Node allocator, when there's no pool
+    std::shared_ptr<NodePool<T, Alloc>> pool;  // Node pool, may be nullptr
+
+    Node<T>* finger;            // Node before the last positional access
+    int fingerPos;              // Position of finger
+    long nHops;                 // Nodes walked by positional access
+    long nSaved;                // Nodes skipped thanks to the finger
+
+    double compactAt;           // Fragmentation that triggers autoCompact
+    int prefetchAt;             // Prefetch distance, 0 if off
+    std::vector<Node<T>*> jumps;    // Node at every position
+
+    // Drop the finger, call after any mutation that shifts positions
+    void invalidate(void);
+
+    // Record node at pos and prefetch ahead of it, see prefetch()
+    void jump(int pos, Node<T>* node);
+
+    // Prefetch ahead of pos without touching the table. Only prefetches,
+    // which GCC counts as no side effect at all, so a call that isn't
+    // inlined first is dropped as dead.
+#if defined(__GNUC__)
+    __attribute__((always_inline))
+#endif
+    void ahead(int pos) const;
+
+    // Node allocation
+    template<class... Args>
+    Node<T>* newNode(Args&&... args);
+    void freeNode(Node<T>* node);
+
+    // Can this list free the nodes of with?
+    bool sameSource(const List<T, Alloc>& with) const;
+
+private:
+    // Predicate comparing against a key without copying it
+    struct KeyRef {
+        const T* key;
+        bool operator()(const T& data) const { return data == *key; }
+    };
+
+    // Null terminated run of nodes
+    struct Chain {
+        Node<T>* head;
+        Node<T>* tail;
+    };
+
+    // Identity key, see radixSort()
+    struct Self {
+        const T& operator()(const T& data) const { return data; }
+    };
+
+    // Maps a numeric key onto unsigned bits that sort the same way
+    template<class K>
+    struct Radix {
+        static_assert(std::is_arithmetic<K>::value && sizeof(K) <= 8,
+                      "radixSort() needs an integral or floating point key");
+
+        typedef typename std::conditional<
+            std::is_floating_point<K>::value,
+            typename std::conditional<sizeof(K) == 4, std::int32_t,
+                                      std::int64_t>::type,
+            typename std::conditional<std::is_same<K, bool>::value,
+                                      unsigned char, K>::type>::type Int;
+        typedef typename std::make_unsigned<Int>::type Bits;
+
+        static const Bits SIGN = Bits(1) << (8 * sizeof(Bits) - 1);
+
+        static Bits get(K key)
+        {
+            return get(key, std::is_floating_point<K>(), std::is_signed<K>());
+        }
+
+        // Negative floats count down, flip them all. Positive ones go above.
+        static Bits get(K key, std::true_type, std::true_type)
+        {
+            static_assert(sizeof(K) == sizeof(Bits), "unsupported float");
+            Bits bits;
+            std::memcpy(&bits, &key, sizeof(bits));
+            return (bits & SIGN) != 0 ? ~bits : bits | SIGN;
+        }
+
+        // Two's complement, moving the sign bit puts negatives first
+        static Bits get(K key, std::false_type, std::true_type)
+        {
+            return static_cast<Bits>(key) ^ SIGN;
+        }
+
+        static Bits get(K key, std::false_type, std::false_type)
+        {
+            return static_cast<Bits>(key);
+        }
+    };
+
+    // Front node of one of the lists in a k-way merge
+    struct Front {
+        Node<T>* node;
+        std::size_t src;    // Index of the list, breaks ties (stability)
+    };
+
+    typedef std::allocator_traits<Alloc> AllocTraits;
+    typedef typename AllocTraits::template rebind_alloc<Node<T>> NodeAlloc;
+    typedef std::allocator_traits<NodeAlloc> NodeTraits;
+
+    // Helper functions
+    void swapNodes(List<T, Alloc>& with);
+    static void swapAlloc(Alloc& a, Alloc& b, std::true_type);
+    static void swapAlloc(Alloc& a, Alloc& b, std::false_type);
+    Node<T>** linkTo(int pos, Node<T>** prev);
+    template<class Compare>
+    static void sortChain(Chain& chain, Compare comp);
+    template<class Compare>
+    static Chain nextRun(Node<T>** rest, Compare comp);
+    template<class Compare>
+    static void merge(Chain& left, Chain& right, Compare comp);
+    template<class Compare>
+    static void mergeSegments(std::vector<Chain>& seg, Compare comp);
+    static void append(Chain& to, Chain& from);
+    template<class Job>
+    static void runThreads(std::size_t count, Job job);
+    List<T, Alloc>& sortDefault(std::true_type);
+    List<T, Alloc>& sortDefault(std::false_type);
+
+};
+
+template<class T, class Alloc>
+const int List<T, Alloc>::PARALLEL_SORT_MIN;
+
+template<class T, class Alloc>
+const int List<T, Alloc>::RADIX_SORT_MIN;
+
+template<class T, class Alloc>
+const int List<T, Alloc>::RADIX_WIDE_MIN;
+
+/**
+ * Forward iterator over a List<T, Alloc>.
+ *
+ * Besides the current node it keeps the address of the link after it, so
+ * the *_after operations can relink in O(1), also from before_begin().
+ */
+template<class T, class Alloc>
+template<bool Const>
+class List<T, Alloc>::Iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename std::conditional<Const, const T*, T*>::type pointer;
+    typedef typename std::conditional<Const, const T&, T&>::type reference;
+
+// Life Cycle
+
+    /** Default constructor
+     */
+    Iterator(void)
+        : node(nullptr), link(nullptr)
+    {
+    }
+
+    /** Copy constructor, also converts iterator to const_iterator
+     *
+     * @param from      Iterator that is to be copied.
+     */
+    Iterator(const Iterator<false>& from)
+        : node(from.node), link(from.link)
+    {
+    }
+
+// Operators
+
+    /** Equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    template<bool C>
+    bool operator==(const Iterator<C>& that) const
+    {
+        return this->link == that.link;
+    }
+
+    /** Not equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    template<bool C>
+    bool operator!=(const Iterator<C>& that) const
+    {
+        return this->link != that.link;
+    }
+
+// Operations
+
+    /** Prefix increment operator
+     *
+     * @return          Reference to this object.
+     */
+    Iterator& operator++(void)
+    {
+        node = *link;
+        link = node != nullptr ? node->nextAdr() : nullptr;
+        return *this;
+    }
+
+    /** Postfix increment operator
+     *
+     * @return          Rvalue object with pre increment position.
+     */
+    Iterator operator++(int)
+    {
+        Iterator tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+// Access
+
+    /** Dereference operator
+     *
+     * @return          Reference to the iterators current element.
+     */
+    reference operator*(void) const
+    {
+        return node->getData();
+    }
+
+    /** Member access operator
+     *
+     * @return          Pointer to the iterators current element.
+     */
+    pointer operator->(void) const
+    {
+        return &node->getData();
+    }
+
+private:
+    friend class List<T, Alloc>;
+    friend class Iterator<!Const>;
+
+    /** Constructor
+     *
+     * @param Node      Current node, nullptr for end().
+     */
+    explicit Iterator(Node<T>* Node)
+        : node(Node), link(Node != nullptr ? Node->nextAdr() : nullptr)
+    {
+    }
+
+    /** Constructor (before_begin version)
+     *
+     * @param Head      Address of the list head.
+     */
+    explicit Iterator(Node<T>** Head)
+        : node(nullptr), link(Head)
+    {
+    }
+
+    Node<T>* node;      // Current node, nullptr before begin and at end
+    Node<T>** link;     // Link after node, nullptr at end
+};
+
+/**
+ * Lazy range over the positions of the elements satisfying Pred.
+ *
+ * Iterators walk to the next match on increment and keep a pointer to the
+ * predicate held by the range, so the range must outlive them.
+ */
+template<class T, class Alloc>
+template<class Pred>
+class List<T, Alloc>::Matches {
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int* pointer;
+        typedef const int& reference;
+
+        /** Default constructor
+         */
+        iterator(void)
+            : node(nullptr), pos(0), pred(nullptr)
+        {
+        }
+
+        /** Equal to operator
+         *
+         * @param that      Iterator to compare this object with.
+         */
+        bool operator==(const iterator& that) const
+        {
+            return this->node == that.node;
+        }
+
+        /** Not equal to operator
+         *
+         * @param that      Iterator to compare this object with.
+         */
+        bool operator!=(const iterator& that) const
+        {
+            return this->node != that.node;
+        }
+
+        /** Prefix increment operator, walks to the next match
+         *
+         * @return          Reference to this object.
+         */
+        iterator& operator++(void)
+        {
+            node = node->getNext(); pos++;
+            seek();
+            return *this;
+        }
+
+        /** Postfix increment operator
+         *
+         * @return          Rvalue object with pre increment position.
+         */
+        iterator operator++(int)
+        {
+            iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+
+        /** Dereference operator
+         *
+         * @return          Position of the current match.
+         */
+        reference operator*(void) const
+        {
+            return pos;
+        }
+
+        /** Get the matching element
+         *
+         * @return          Data stored at the current match.
+         */
+        const T& value(void) const
+        {
+            return node->getData();
+        }
+
+    private:
+        friend class Matches;
+
+        /** Constructor, stops at the first match from Node on
+         *
+         * @param Node      Node to start from, nullptr for end().
+         * @param Select    Predicate owned by the range.
+         */
+        iterator(const Node<T>* Node, const Pred* Select)
+            : node(Node), pos(0), pred(Select)
+        {
+            seek();
+        }
+
+        // Skip nodes pred rejects
+        void seek(void)
+        {
+            while (node != nullptr && !(*pred)(node->getData())) {
+                node = node->getNext(); pos++;
+            }
+        }
+
+        const Node<T>* node;    // Current match, nullptr at end
+        int pos;                // Position of node
+        const Pred* pred;       // Predicate owned by the range
+    };
+
+    /** Iterator to the first match
+     */
+    iterator begin(void) const
+    {
+        return iterator(head, &pred);
+    }
+
+    /** Iterator past the last match
+     */
+    iterator end(void) const
+    {
+        return iterator(nullptr, &pred);
+    }
+
+private:
+    friend class List<T, Alloc>;
+
+    /** Constructor
+     *
+     * @param Head      First node of the list.
+     * @param Select    Predicate selecting the matches.
+     */
+    Matches(const Node<T>* Head, Pred Select)
+        : head(Head), pred(Select)
+    {
+    }
+
+    const Node<T>* head;    // First node of the list
+    Pred pred;              // Predicate selecting the matches
+};
+
+// ****************************** Life cycle ***********************************
+
+template<class T, class Alloc>
+List<T, Alloc>::List(void)
+    : head(nullptr), tail(nullptr), n(0), alloc(), finger(nullptr),
+      fingerPos(0), nHops(0), nSaved(0), compactAt(1), prefetchAt(0)
+{
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::List(const Alloc& Allocator)
+    : head(nullptr), tail(nullptr), n(0), alloc(Allocator), finger(nullptr),
+      fingerPos(0), nHops(0), nSaved(0), compactAt(1), prefetchAt(0)
+{
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::List(std::shared_ptr<NodePool<T, Alloc>> Pool,
+                     const Alloc& Allocator)
+    : head(nullptr), tail(nullptr), n(0), alloc(Allocator), pool(Pool),
+      finger(nullptr), fingerPos(0), nHops(0), nSaved(0), compactAt(1),
+      prefetchAt(0)
+{
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::List(const List<T, Alloc>& from)
+    : head(nullptr), tail(nullptr), n(0),
+      alloc(AllocTraits::select_on_container_copy_construction(from.alloc)),
+      pool(from.pool), finger(nullptr), fingerPos(0), nHops(0), nSaved(0),
+      compactAt(from.compactAt), prefetchAt(from.prefetchAt)
+{
+    try {
+        for (Node<T>* fr = from.head; fr != nullptr; fr = fr->getNext())
+            push_back(fr->getData());
+    }
+    catch (...) {
+        clear();    // destructor won't run, don't leak the partial copy
+        throw;
+    }
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::List(const List<T, Alloc>& from, const Alloc& Allocator)
+    : head(nullptr), tail(nullptr), n(0), alloc(Allocator), pool(from.pool),
+      finger(nullptr), fingerPos(0), nHops(0), nSaved(0),
+      compactAt(from.compactAt), prefetchAt(from.prefetchAt)
+{
+    try {
+        for (Node<T>* fr = from.head; fr != nullptr; fr = fr->getNext())
+            push_back(fr->getData());
+    }
+    catch (...) {
+        clear();
+        throw;
+    }
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::List( List<T, Alloc>&& from)
+    : head(from.head), tail(from.tail), n(from.n), alloc(from.alloc),
+      pool(from.pool), finger(from.finger), fingerPos(from.fingerPos),
+      nHops(0), nSaved(0), compactAt(from.compactAt),
+      prefetchAt(from.prefetchAt)
+{
+    from.head = from.tail = nullptr;
+    from.n    = 0;
+    from.invalidate();
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::List(List<T, Alloc>&& from, const Alloc& Allocator)
+    : head(nullptr), tail(nullptr), n(0), alloc(Allocator), pool(from.pool),
+      finger(nullptr), fingerPos(0), nHops(0), nSaved(0),
+      compactAt(from.compactAt), prefetchAt(from.prefetchAt)
+{
+    if (sameSource(from)) {
+        swapNodes(from);
+        return;
+    }
+
+    // Nodes can't change allocator, move the elements one by one
+    try {
+        for (Node<T>* fr = from.head; fr != nullptr; fr = fr->getNext())
+            push_back(std::move_if_noexcept(fr->getData()));
+    }
+    catch (...) {
+        clear();
+        throw;
+    }
+    from.clear();
+}
+
+template<class T, class Alloc>
+List<T, Alloc>::~List(void)
+{
+    clear();
+}
+
+// ****************************** Operators  ***********************************
+
+template<class T, class Alloc>
+const List<T, Alloc>& List<T, Alloc>::operator=(const List<T, Alloc>& from)
+{
+    typedef typename AllocTraits::propagate_on_container_copy_assignment
+        Propagate;
+
+    if (&from != this) {
+        // Copy first, leaves *this intact if it throws
+        List<T, Alloc> tmp(from, Propagate::value ? from.alloc : this->alloc);
+        swapNodes(tmp);
+        // Old nodes go with tmp, so does the old allocator if it propagates
+        swapAlloc(this->alloc, tmp.alloc, Propagate());
+    }
+    return *this;
+}
+
+template<class T, class Alloc>
+const List<T, Alloc>& List<T, Alloc>::operator=(List<T, Alloc>&& from)
+{
+    typedef typename AllocTraits::propagate_on_container_move_assignment
+        Propagate;
+
+    if (&from != this) {
+        if (Propagate::value) {
+            List<T, Alloc> tmp(std::move(from));
+            swapNodes(tmp);     // old nodes go with tmp
+            swapAlloc(this->alloc, tmp.alloc, Propagate());
+        }
+        else {
+            List<T, Alloc> tmp(std::move(from), this->alloc);
+            swapNodes(tmp);
+        }
+    }
+    return *this;
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::operator==(const List<T, Alloc>& obj)
+{
+    if (this->n != obj.n)
+        return false;
+
+    // sizes match, compare element by element
+    int pos = 0;
+    for (Node<T>* curr_this = head, *curr_obj = obj.head; curr_this != nullptr;
+         curr_this = curr_this->getNext(), curr_obj = curr_obj->getNext()) {
+        jump(pos, curr_this);
+        obj.ahead(pos++);
+        if (curr_this->getData() != curr_obj->getData())
+            return false;
+    }
+    return true;
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::operator!=(const List<T, Alloc>& obj)
+{
+    return !(*this == obj);
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::operator>(const List<T, Alloc>& obj)
+{
+    Node<T>* curr_this = head;
+    Node<T>* curr_obj  = obj.head;
+
+    // compare element by element
+    for (int n = this->n > obj.n ? this->n : obj.n, i = 0; i < n; i++,
+         curr_this = curr_this->getNext(), curr_obj = curr_obj->getNext())
+        if (curr_this->getData() <= curr_obj->getData())
+            return false;
+    return this->n > obj.n;
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::operator>=(const List<T, Alloc>& obj)
+{
+    return *this == obj || *this > obj;
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::operator<(const List<T, Alloc>& obj)
+{
+    return !(*this >= obj); 
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::operator<=(const List<T, Alloc>& obj)
+{
+    return *this == obj || *this < obj;
+}
+
+// ****************************** Operations ***********************************
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::add(const int& pos, const T& data)
+{
+    return emplace(pos, data);
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::add(const int& pos, T&& data)
+{
+    return emplace(pos, std::move(data));
+}
+
+template<class T, class Alloc>
+template<class... Args>
+List<T, Alloc>& List<T, Alloc>::emplace(const int& pos, Args&&... args)
+{
+    if (pos < 0 || pos > n)
+        throw std::invalid_argument("List<T>::emplace");
+
+    // Get in position to insert node, appending needs no walk
+    Node<T>*  prev;
+    Node<T>** curr = pos == n && tail != nullptr ? tail->nextAdr()
+                                                 : linkTo(pos, &prev);
+
+    // Insert node, nodes before pos keep their positions
+    *curr = newNode(*curr, std::forward<Args>(args)...); this->n++;
+    if ((*curr)->getNext() == nullptr)
+        tail = *curr;
+    if (pos == 0)
+        invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+T List<T, Alloc>::rm(const int& pos)
+{
+    if (pos < 0 || pos >= this->n)
+        throw std::invalid_argument("List<T>::rm"); 
+
+    // Get in position to remove node
+    Node<T>*  prev;
+    Node<T>** curr = linkTo(pos, &prev);
+
+    // Remove node
+    Node<T>* tmp    = *curr;                // don't lose node, need clean
+    T        rmData(std::move(tmp->getData())); // need return, node dies
+    *curr           = (*curr)->getNext();
+    if (tmp == tail)
+        tail = prev;
+    freeNode(tmp); this->n--;
+
+    if (pos == 0)
+        invalidate();
+
+    return rmData;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::clear(void)
+{
+    if (pool && pool->live() == static_cast<std::size_t>(this->n)) {
+        // Sole user of the pool, hand back all slabs in one shot
+        if (!std::is_trivially_destructible<T>::value)
+            for (Node<T>* curr = head, *nextNode; curr != nullptr;
+                 curr = nextNode) {
+                nextNode = curr->getNext();
+                curr->~Node<T>();
+            }
+        pool->release();
+    }
+    else {
+        for (Node<T>* curr = head, *nextNode; curr != nullptr;
+             curr = nextNode) {
+            nextNode = curr->getNext();
+            freeNode(curr);
+        }
+    }
+    jumps.clear();
+    this->head = this->tail = nullptr;
+    this->n    = 0;
+    invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::swap(List<T, Alloc>& with)
+{
+    typedef typename AllocTraits::propagate_on_container_swap Propagate;
+
+    // Nodes not from a pool must end up with an allocator that can free them
+    if (!Propagate::value && !(this->alloc == with.alloc) &&
+        (!this->pool || !with.pool))
+        throw std::invalid_argument("List<T>::swap");
+
+    swapNodes(with);
+    swapAlloc(this->alloc, with.alloc, Propagate());
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::swapNodes(List<T, Alloc>& with)
+{
+    std::swap(this->head, with.head);
+    std::swap(this->tail, with.tail);
+    std::swap(this->n, with.n);
+    this->pool.swap(with.pool);
+    std::swap(this->finger, with.finger);
+    std::swap(this->fingerPos, with.fingerPos);
+    std::swap(this->compactAt, with.compactAt);
+    std::swap(this->prefetchAt, with.prefetchAt);
+    this->jumps.swap(with.jumps);
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::reverse(void)
+{
+    // reverse list
+    Node<T>* newHead = nullptr;
+    this->tail = this->head;
+    invalidate();
+    for (Node<T>* curr = this->head, *next; curr != nullptr; curr = next) {
+        next = curr->getNext();             // dont lose next node
+        newHead = &curr->setNext(newHead);  // place latest node in the front
+    }
     this->head = newHead;   // complete the switch
 
     return *this;
 }
 
-template<class T>
-List<T>& List<T>::merge(const int& pos, List<T>& with)
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::merge(const int& pos, List<T, Alloc>& with)
+{
+    if (pos < 0 || pos > n || &with == this || !sameSource(with))
+        throw std::invalid_argument("List<T>::merge");
+
+    if (with.head == nullptr)
+        return *this;
+
+    // Get in position to do the merge, appending needs no walk
+    Node<T>*  prev;
+    Node<T>** curr = pos == n && tail != nullptr ? tail->nextAdr()
+                                                 : linkTo(pos, &prev);
+
+    // Merge lists
+    with.tail->setNext(*curr);  // rest of *this goes after the end of 'with'
+    if (*curr == nullptr)
+        tail = with.tail;
+    *curr = with.head;          // complete the merge
+    this->n += with.n;          // uppdate size
+    if (pos == 0)
+        invalidate();
+
+    // Clean up 'with'
+    with.head = with.tail = nullptr;
+    with.n    = 0;
+    with.invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::sort(void)
+{
+    // Integers don't need comparing, long lists of them are radix sorted.
+    // Floating point keys would leave operator<'s order (-0.0, NaN).
+    return sortDefault(std::integral_constant<bool,
+                           std::is_integral<T>::value && sizeof(T) <= 8>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>& List<T, Alloc>::sort(Compare comp)
+{
+    Chain sorted = { this->head, this->tail };
+    try {
+        sortChain(sorted, comp);
+    }
+    catch (...) {
+        // Unsorted, but every node is still linked in
+        this->head = sorted.head;
+        this->tail = sorted.tail;
+        invalidate();
+        throw;
+    }
+    this->head = sorted.head;
+    this->tail = sorted.tail;
+    invalidate();
+
+    if (compactAt < 1 && fragmentation() > compactAt)
+        compact();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::radixSort(void)
+{
+    return radixSort(Self());
+}
+
+template<class T, class Alloc>
+template<class Key>
+List<T, Alloc>& List<T, Alloc>::radixSort(Key key)
+{
+    typedef typename std::decay<
+        decltype(key(std::declval<const T&>()))>::type K;
+    typedef typename Radix<K>::Bits Bits;
+
+    if (this->n < 2)
+        return *this;
+
+    // Every pass walks the whole list, long lists are worth wider digits
+    // (fewer passes) even though every pass then goes over more buckets
+    const unsigned width   = this->n >= RADIX_WIDE_MIN ? 11 : 8;
+    const unsigned buckets = 1u << width;
+    Node<T>* first[1 << 11];
+    Node<T>* last[1 << 11];
+
+    // One stable distribution pass per digit, least significant first.
+    // Digits where all keys agree would leave the order as it is, the first
+    // pass finds out which those are.
+    Bits all = ~Bits(0), any = 0;
+    for (unsigned shift = 0; shift < 8 * sizeof(Bits); shift += width) {
+        if (shift > 0 && (((all ^ any) >> shift) & (buckets - 1)) == 0)
+            continue;
+
+        for (unsigned d = 0; d < buckets; d++)
+            last[d] = nullptr;
+        for (Node<T>* curr = this->head; curr != nullptr;
+             curr = curr->getNext()) {
+            Bits bits = Radix<K>::get(key(curr->getData()));
+            if (shift == 0) {
+                all &= bits;
+                any |= bits;
+            }
+            unsigned d = (bits >> shift) & (buckets - 1);
+            if (last[d] != nullptr)
+                last[d]->setNext(curr);
+            else
+                first[d] = curr;
+            last[d] = curr;
+        }
+
+        // Chain the buckets back up in order
+        Node<T>** link = &this->head;
+        for (unsigned d = 0; d < buckets; d++)
+            if (last[d] != nullptr) {
+                *link      = first[d];
+                link       = last[d]->nextAdr();
+                this->tail = last[d];
+            }
+        *link = nullptr;
+    }
+    invalidate();
+
+    if (compactAt < 1 && fragmentation() > compactAt)
+        compact();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::sortParallel(unsigned threads)
+{
+    return sortParallel(threads, std::less<T>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>& List<T, Alloc>::sortParallel(unsigned threads, Compare comp)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads > static_cast<unsigned>(this->n / (PARALLEL_SORT_MIN / 2)))
+        threads = this->n / (PARALLEL_SORT_MIN / 2);
+    if (threads <= 1 || this->n < PARALLEL_SORT_MIN)
+        return sort(comp);
+
+    // Cut the list into one segment per thread
+    std::vector<Chain> seg(threads);
+    Node<T>* curr = this->head;
+    for (unsigned t = 0; t < threads; t++) {
+        int len     = this->n / threads + (t < this->n % threads ? 1 : 0);
+        seg[t].head = curr;
+        for (int i = 1; i < len; i++)
+            curr = curr->getNext();
+        Node<T>* next = curr->getNext();
+        curr->setNext(nullptr);
+        seg[t].tail = curr;
+        curr        = next;
+    }
+
+    // Sort every segment on its own thread, then merge them
+    try {
+        runThreads(threads, [&seg, comp](std::size_t t) {
+            sortChain(seg[t], comp);
+        });
+        mergeSegments(seg, comp);
+    }
+    catch (...) {
+        // Every node is still in some segment, link them back up unsorted
+        for (std::size_t t = 1; t < seg.size(); t++)
+            append(seg[0], seg[t]);
+        this->head = seg[0].head;
+        this->tail = seg[0].tail;
+        invalidate();
+        throw;
+    }
+    this->head = seg[0].head;
+    this->tail = seg[0].tail;
+    invalidate();
+
+    if (compactAt < 1 && fragmentation() > compactAt)
+        compact();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::mergeSorted(List<T, Alloc>& with)
+{
+    return mergeSorted(with, std::less<T>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>& List<T, Alloc>::mergeSorted(List<T, Alloc>& with, Compare comp)
+{
+    if (&with == this || !sameSource(with))
+        throw std::invalid_argument("List<T>::mergeSorted");
+
+    Chain ours   = { this->head, this->tail };
+    Chain theirs = { with.head, with.tail };
+    merge(ours, theirs, comp);
+    this->head   = ours.head;
+    this->tail   = ours.tail;
+    this->n     += with.n;
+    invalidate();
+
+    // Clean up 'with'
+    with.head = with.tail = nullptr;
+    with.n    = 0;
+    with.invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>&
+List<T, Alloc>::mergeSorted(const std::vector<List<T, Alloc>*>& lists)
+{
+    return mergeSorted(lists, std::less<T>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>&
+List<T, Alloc>::mergeSorted(const std::vector<List<T, Alloc>*>& lists,
+                            Compare comp)
+{
+    for (std::size_t i = 0; i < lists.size(); i++)
+        if (lists[i] == nullptr || lists[i] == this || !sameSource(*lists[i]))
+            throw std::invalid_argument("List<T>::mergeSorted");
+
+    // Take the chains over, source 0 is this list. A list given twice is
+    // empty the second time round.
+    std::vector<Node<T>*> tails(lists.size() + 1);
+    std::vector<Front> heap;
+    heap.reserve(lists.size() + 1);
+    if (this->head != nullptr) {
+        Front f = { this->head, 0 };
+        heap.push_back(f);
+        tails[0] = this->tail;
+    }
+    for (std::size_t i = 0; i < lists.size(); i++) {
+        List<T, Alloc>& with = *lists[i];
+        if (with.head == nullptr)
+            continue;
+        Front f = { with.head, i + 1 };
+        heap.push_back(f);
+        tails[i + 1] = with.tail;
+        this->n     += with.n;
+        with.head    = with.tail = nullptr;
+        with.n       = 0;
+        with.invalidate();
+    }
+    invalidate();
+
+    // Max-heap on "goes later", so the front of the heap goes first
+    auto later = [&comp](const Front& a, const Front& b) {
+        if (comp(b.node->getData(), a.node->getData()))
+            return true;
+        if (comp(a.node->getData(), b.node->getData()))
+            return false;
+        return a.src > b.src;
+    };
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    Node<T>** link = &this->head;
+    while (heap.size() > 1) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Front& first = heap.back();
+        *link        = first.node;
+        link         = first.node->nextAdr();
+        first.node   = first.node->getNext();
+        if (first.node != nullptr)
+            std::push_heap(heap.begin(), heap.end(), later);
+        else
+            heap.pop_back();
+    }
+
+    // The last list standing goes on as it is
+    if (!heap.empty()) {
+        *link      = heap[0].node;
+        this->tail = tails[heap[0].src];
+    }
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::unite(List<T, Alloc>& with)
+{
+    return unite(with, std::less<T>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>& List<T, Alloc>::unite(List<T, Alloc>& with, Compare comp)
+{
+    if (&with == this || !sameSource(with))
+        throw std::invalid_argument("List<T>::unite");
+
+    Node<T>** link = &this->head;
+    Node<T>*  ours = this->head, *theirs = with.head, *last = nullptr;
+    while (ours != nullptr && theirs != nullptr) {
+        if (comp(theirs->getData(), ours->getData())) {
+            last   = theirs;
+            theirs = theirs->getNext();
+            this->n++;
+        }
+        else {
+            // An equal element of 'with' is covered by ours, drop it
+            if (!comp(ours->getData(), theirs->getData())) {
+                Node<T>* dup = theirs;
+                theirs       = theirs->getNext();
+                freeNode(dup);
+            }
+            last = ours;
+            ours = ours->getNext();
+        }
+        *link = last;
+        link  = last->nextAdr();
+    }
+
+    // Whichever side is left over ends the list
+    if (ours != nullptr)
+        *link = ours;
+    else if (theirs != nullptr) {
+        *link      = theirs;
+        this->tail = with.tail;
+        for (; theirs != nullptr; theirs = theirs->getNext())
+            this->n++;
+    }
+    else {
+        *link      = nullptr;
+        this->tail = last;
+    }
+    invalidate();
+
+    // Clean up 'with'
+    with.head = with.tail = nullptr;
+    with.n    = 0;
+    with.invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::intersect(const List<T, Alloc>& with)
+{
+    return intersect(with, std::less<T>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>& List<T, Alloc>::intersect(const List<T, Alloc>& with,
+                                          Compare comp)
+{
+    if (&with == this)
+        return *this;
+
+    Node<T>**      link   = &this->head;
+    Node<T>*       ours   = this->head, *last = nullptr;
+    const Node<T>* theirs = with.head;
+    while (ours != nullptr) {
+        while (theirs != nullptr && comp(theirs->getData(), ours->getData()))
+            theirs = theirs->getNext();
+
+        if (theirs != nullptr && !comp(ours->getData(), theirs->getData())) {
+            last   = ours;      // matched, keep it
+            link   = ours->nextAdr();
+            ours   = ours->getNext();
+            theirs = theirs->getNext();
+        }
+        else {
+            Node<T>* tmp = ours;
+            ours         = ours->getNext();
+            *link        = ours;
+            freeNode(tmp); this->n--;
+        }
+    }
+    this->tail = last;
+    invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::subtract(const List<T, Alloc>& with)
+{
+    return subtract(with, std::less<T>());
+}
+
+template<class T, class Alloc>
+template<class Compare>
+List<T, Alloc>& List<T, Alloc>::subtract(const List<T, Alloc>& with,
+                                         Compare comp)
+{
+    if (&with == this)
+        return clear();
+
+    Node<T>**      link   = &this->head;
+    Node<T>*       ours   = this->head, *last = nullptr;
+    const Node<T>* theirs = with.head;
+    while (ours != nullptr && theirs != nullptr) {
+        while (theirs != nullptr && comp(theirs->getData(), ours->getData()))
+            theirs = theirs->getNext();
+
+        if (theirs != nullptr && !comp(ours->getData(), theirs->getData())) {
+            Node<T>* tmp = ours;
+            ours         = ours->getNext();
+            *link        = ours;
+            freeNode(tmp); this->n--;
+            theirs = theirs->getNext();
+        }
+        else {
+            last = ours;
+            link = ours->nextAdr();
+            ours = ours->getNext();
+        }
+    }
+    if (ours == nullptr)    // otherwise the old tail is still the tail
+        this->tail = last;
+    invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::unique(void)
+{
+    return unique(std::equal_to<T>());
+}
+
+template<class T, class Alloc>
+template<class BinaryPred>
+List<T, Alloc>& List<T, Alloc>::unique(BinaryPred same)
+{
+    if (this->head == nullptr)
+        return *this;
+
+    Node<T>* curr = this->head;
+    Node<T>* next;
+    while ((next = curr->getNext()) != nullptr) {
+        if (same(curr->getData(), next->getData())) {
+            curr->setNext(next->getNext());
+            freeNode(next); this->n--;
+        }
+        else
+            curr = next;
+    }
+    this->tail = curr;
+    invalidate();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::compact(void)
 {
-    if (pos < 0 || pos > n || *this == with)
-        throw std::invalid_argument("List<T>::merge");
+    if (this->n == 0 ||
+        (pool && pool->live() != static_cast<std::size_t>(this->n)))
+        return *this;   // other lists have nodes in the pool
+
+    // Rebuild the nodes in order, in one run of slots of a fresh pool. The
+    // pool may stay with the list, so it grows by normal slabs afterwards.
+    std::shared_ptr<NodePool<T, Alloc>> fresh =
+        std::allocate_shared<NodePool<T, Alloc>>(
+            alloc, NodePool<T, Alloc>::SLAB_SIZE,
+            pool ? pool->get_allocator() : alloc);
+    fresh->reserve(this->n);
+    Node<T>*  first = nullptr;
+    Node<T>** link  = &first;
+    Node<T>*  last  = nullptr;
+    try {
+        for (Node<T>* curr = this->head; curr != nullptr;
+             curr = curr->getNext()) {
+            last  = fresh->create(nullptr,
+                                  std::move_if_noexcept(curr->getData()));
+            *link = last;
+            link  = last->nextAdr();
+        }
+    }
+    catch (...) {
+        // Old nodes are intact, elements were only moved if that can't throw
+        for (Node<T>* curr = first, *nextNode; curr != nullptr;
+             curr = nextNode) {
+            nextNode = curr->getNext();
+            fresh->destroy(curr);
+        }
+        throw;
+    }
 
-    // Get in position to do the merge
-    Node<T>** curr = &this->head;
-    for (int i = 0; i < pos; i++)
-        curr = (*curr)->nextAdr();
+    // Get rid of the old nodes
+    if (pool) {
+        // Sole user of the pool, the pool object stays so lists sharing it
+        // can still merge with this one, only its slabs are swapped
+        if (!std::is_trivially_destructible<T>::value)
+            for (Node<T>* curr = this->head, *nextNode; curr != nullptr;
+                 curr = nextNode) {
+                nextNode = curr->getNext();
+                curr->~Node<T>();
+            }
+        pool->swap(*fresh);     // old slabs go with fresh
+    }
+    else {
+        for (Node<T>* curr = this->head, *nextNode; curr != nullptr;
+             curr = nextNode) {
+            nextNode = curr->getNext();
+            freeNode(curr);
+        }
+        pool = fresh;
+    }
+    this->head = first;
+    this->tail = last;
+    invalidate();
 
-    // Merge lists
-    Node<T>* tmp = *curr;   // this node has to be appened to end of 'with'
-    *curr = with.head;      // append 'with' to current position in *this
-    while (*curr != nullptr)
-        curr = (*curr)->nextAdr();
-    (*curr) = tmp;          // complete the merge
-    this->n += with.n;      // uppdate size
+    return *this;
+}
 
-    // Clean up 'with'
-    with.head = nullptr;
-    with.n    = 0;
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::autoCompact(double threshold)
+{
+    compactAt = threshold;
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::prefetch(int distance)
+{
+    prefetchAt = distance > 0 ? distance : 0;
+    if (prefetchAt == 0) {
+        std::vector<Node<T>*>().swap(jumps);
+        return *this;
+    }
+
+    // Fill in the table from the list as it is now
+    jumps.resize(this->n);
+    int pos = 0;
+    for (Node<T>* curr = this->head; curr != nullptr; curr = curr->getNext())
+        jumps[pos++] = curr;
 
     return *this;
 }
 
-template<class T>
-List<T>& List<T>::sort(void)
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::push_back(const T& data)
 {
-    sort_r(&this->head);
+    return emplace_back(data);
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::push_back(T&& data)
+{
+    return emplace_back(std::move(data));
+}
+
+template<class T, class Alloc>
+template<class... Args>
+List<T, Alloc>& List<T, Alloc>::emplace_back(Args&&... args)
+{
+    Node<T>* node = newNode(nullptr, std::forward<Args>(args)...);
+    (tail != nullptr ? *tail->nextAdr() : head) = node;
+    tail = node; this->n++;
+
     return *this;
 }
 
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::append(List<T, Alloc>& with)
+{
+    if (&with == this)
+        throw std::invalid_argument("List<T>::append");
+    return merge(this->n, with);
+}
+
 // ****************************** Access ***************************************
 
-template<class T>
-const int& List<T>::size(void) const
+template<class T, class Alloc>
+const int& List<T, Alloc>::size(void) const
 {
     return this->n;
 }
 
-template<class T>
-bool List<T>::isEmpty(void) const
+template<class T, class Alloc>
+Alloc List<T, Alloc>::get_allocator(void) const
+{
+    return alloc;
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::isEmpty(void) const
 {
     return this->n <= 0;
 }
 
-template<class T>
-List<int> List<T>::search(const T& data) const
+template<class T, class Alloc>
+List<int> List<T, Alloc>::search(const T& data) const
 {
     List<int> matches;
-    Node<T>* curr = this->head;
 
     // Find all matches
-    for (int i = 0; i < this->n; i++) {
-        if (curr->getData() == data)
-            matches.add(0, i);
-        curr = curr->getNext();
-    }
+    visit(data, [&matches](int pos, const T&) {
+        matches.push_back(pos);
+        return true;
+    });
 
     return matches;
 }
 
-template<class T>
-const T& List<T>::peek(const int& pos) const
+template<class T, class Alloc>
+int List<T, Alloc>::find_first(const T& key) const
+{
+    KeyRef equal = { &key };
+    return find_first_if(equal);
+}
+
+template<class T, class Alloc>
+template<class Pred>
+int List<T, Alloc>::find_first_if(Pred pred) const
+{
+    int pos = 0;
+    for (const Node<T>* curr = this->head; curr != nullptr;
+         curr = curr->getNext(), pos++) {
+        ahead(pos);
+        if (pred(curr->getData()))
+            return pos;
+    }
+
+    return -1;
+}
+
+template<class T, class Alloc>
+int List<T, Alloc>::count(const T& key) const
+{
+    KeyRef equal = { &key };
+    return count_if(equal);
+}
+
+template<class T, class Alloc>
+template<class Pred>
+int List<T, Alloc>::count_if(Pred pred) const
+{
+    int hits = 0, pos = 0;
+    for (const Node<T>* curr = this->head; curr != nullptr;
+         curr = curr->getNext()) {
+        ahead(pos++);
+        if (pred(curr->getData()))
+            hits++;
+    }
+
+    return hits;
+}
+
+template<class T, class Alloc>
+template<class Visit>
+int List<T, Alloc>::visit(const T& key, Visit visit) const
+{
+    KeyRef equal = { &key };
+    return visit_if(equal, visit);
+}
+
+template<class T, class Alloc>
+template<class Pred, class Visit>
+int List<T, Alloc>::visit_if(Pred pred, Visit visit) const
+{
+    int hits = 0, pos = 0;
+    for (const Node<T>* curr = this->head; curr != nullptr;
+         curr = curr->getNext(), pos++) {
+        ahead(pos);
+        if (pred(curr->getData())) {
+            hits++;
+            if (!visit(pos, curr->getData()))
+                break;
+        }
+    }
+
+    return hits;
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::template Matches<typename List<T, Alloc>::KeyEqual>
+List<T, Alloc>::matches(const T& key) const
+{
+    KeyEqual equal = { key };
+    return Matches<KeyEqual>(this->head, equal);
+}
+
+template<class T, class Alloc>
+template<class Pred>
+typename List<T, Alloc>::template Matches<Pred>
+List<T, Alloc>::matches_if(Pred pred) const
+{
+    return Matches<Pred>(this->head, pred);
+}
+
+template<class T, class Alloc>
+const T& List<T, Alloc>::peek(const int& pos)
 {
     if (pos < 0 || pos >= this->n)
         throw std::invalid_argument("List<T>::peek");
 
-    Node<T>* curr = this->head;
-    for (int i = 0; i < pos; i++)
-        curr = curr->getNext();
+    if (pos == this->n - 1)
+        return this->tail->getData();
+
+    Node<T>* prev;
+    return (*linkTo(pos, &prev))->getData();
+}
+
+template<class T, class Alloc>
+const T& List<T, Alloc>::peek(const int& pos) const
+{
+    if (pos < 0 || pos >= this->n)
+        throw std::invalid_argument("List<T>::peek");
+
+    if (pos == this->n - 1)
+        return this->tail->getData();
 
+    const Node<T>* curr = this->head;
+    for (int i = 0; i < pos; i++) {
+        ahead(i);
+        curr = curr->getNext();
+    }
     return curr->getData();
 }
 
-template<class T>
-const List<T>& List<T>::print(void) const
+template<class T, class Alloc>
+long List<T, Alloc>::hops(void) const
 {
-    for (Node<T>* curr = this->head; curr != nullptr; curr = curr->getNext())
-        std::cout << curr->getData() << " ";
-    std::cout << std::endl;
+    return nHops;
+}
+
+template<class T, class Alloc>
+long List<T, Alloc>::hopsSaved(void) const
+{
+    return nSaved;
+}
+
+template<class T, class Alloc>
+double List<T, Alloc>::fragmentation(void) const
+{
+    if (this->n <= 1)
+        return 0;
+
+    int jumps = 0;
+    for (Node<T>* curr = this->head; curr != this->tail; curr = curr->getNext())
+        if (reinterpret_cast<char*>(curr->getNext()) !=
+            reinterpret_cast<char*>(curr) + NodePool<T, Alloc>::STRIDE)
+            jumps++;
+
+    return static_cast<double>(jumps) / (this->n - 1);
+}
+
+template<class T, class Alloc>
+const List<T, Alloc>& List<T, Alloc>::print(void) const
+{
+    // The writer only knows the default format
+    const std::ios_base::fmtflags plain = std::ios_base::dec |
+                                          std::ios_base::skipws;
+    if (std::cout.flags() != plain || std::cout.precision() != 6 ||
+        std::cout.width() != 0 ||
+        !(std::cout.getloc() == std::locale::classic())) {
+        for (Node<T>* curr = head; curr != nullptr; curr = curr->getNext())
+            std::cout << curr->getData() << ' ';
+        std::cout << std::endl;
+        return *this;
+    }
+
+    Writer out(std::cout);
+    print(out);
+    out.put('\n').flush();
+    std::cout.flush();
+
+    return *this;
+}
+
+template<class T, class Alloc>
+const List<T, Alloc>& List<T, Alloc>::print(Writer& out, char sep) const
+{
+    writeText(out, begin(), end(), sep);
+
+    return *this;
+}
+
+template<class T, class Alloc>
+const List<T, Alloc>& List<T, Alloc>::save(Writer& out) const
+{
+    writeBinary(out, begin(), end(), this->n);
+
+    return *this;
+}
+
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::load(Reader& in)
+{
+    std::uint64_t count;
+    if (!readHeader<T>(in, count) || count > 0x7fffffff)
+        throw std::invalid_argument("List<T>::load");
+
+    // Nodes go in runs of consecutive slots, filled in order. The count
+    // isn't trusted: a run is only reserved once the one before is full and
+    // is at most as long as all before it, so what's reserved stays within
+    // twice what was really read.
+    const std::uint64_t FIRST_RUN = 1 << 16;
+    std::shared_ptr<NodePool<T, Alloc>> slots = pool;
+    if (!slots)
+        slots = std::allocate_shared<NodePool<T, Alloc>>(
+            alloc, NodePool<T, Alloc>::SLAB_SIZE, alloc);
+
+    List<T, Alloc> tmp(slots, alloc);
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type raw;
+    for (std::uint64_t i = 0, reserved = 0; i < count; i++) {
+        if (i == reserved) {
+            std::uint64_t run = std::min(count - i, std::max(i, FIRST_RUN));
+            slots->reserve(static_cast<std::size_t>(run));
+            reserved += run;
+        }
+        if (!in.read(reinterpret_cast<char*>(&raw), sizeof(T)))
+            throw std::invalid_argument("List<T>::load");
+        tmp.push_back(*reinterpret_cast<const T*>(&raw));
+    }
+
+    tmp.compactAt  = compactAt;
+    tmp.prefetchAt = prefetchAt;
+    swapNodes(tmp);
 
     return *this;
 }
 
+// ****************************** Iterators ************************************
+
+template<class T, class Alloc>
+typename List<T, Alloc>::iterator List<T, Alloc>::begin(void)
+{
+    return iterator(this->head);
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::const_iterator List<T, Alloc>::begin(void) const
+{
+    return const_iterator(this->head);
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::const_iterator List<T, Alloc>::cbegin(void) const
+{
+    return const_iterator(this->head);
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::iterator List<T, Alloc>::end(void)
+{
+    return iterator(static_cast<Node<T>*>(nullptr));
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::const_iterator List<T, Alloc>::end(void) const
+{
+    return const_iterator(static_cast<Node<T>*>(nullptr));
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::const_iterator List<T, Alloc>::cend(void) const
+{
+    return const_iterator(static_cast<Node<T>*>(nullptr));
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::iterator List<T, Alloc>::before_begin(void)
+{
+    return iterator(&this->head);
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::const_iterator List<T, Alloc>::before_begin(void) const
+{
+    return const_iterator(const_cast<Node<T>**>(&this->head));
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::const_iterator
+List<T, Alloc>::cbefore_begin(void) const
+{
+    return before_begin();
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::iterator
+List<T, Alloc>::insert_after(const_iterator pos,
+                                                 const T& data)
+{
+    return emplace_after(pos, data);
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::iterator
+List<T, Alloc>::insert_after(const_iterator pos, T&& data)
+{
+    return emplace_after(pos, std::move(data));
+}
+
+template<class T, class Alloc>
+template<class... Args>
+typename List<T, Alloc>::iterator
+List<T, Alloc>::emplace_after(const_iterator pos,
+                                                  Args&&... args)
+{
+    if (pos.link == nullptr)
+        throw std::invalid_argument("List<T>::emplace_after");
+
+    *pos.link = newNode(*pos.link, std::forward<Args>(args)...); this->n++;
+    if ((*pos.link)->getNext() == nullptr)
+        tail = *pos.link;
+    invalidate();
+
+    return iterator(*pos.link);
+}
+
+template<class T, class Alloc>
+typename List<T, Alloc>::iterator
+List<T, Alloc>::erase_after(const_iterator pos)
+{
+    if (pos.link == nullptr || *pos.link == nullptr)
+        throw std::invalid_argument("List<T>::erase_after");
+
+    Node<T>* tmp = *pos.link;
+    *pos.link    = tmp->getNext();
+    if (tmp == tail)
+        tail = pos.node;
+    freeNode(tmp); this->n--;
+    invalidate();
+
+    return iterator(*pos.link);
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::splice_after(const_iterator pos, List<T, Alloc>& from)
+{
+    if (pos.link == nullptr || &from == this || !sameSource(from))
+        throw std::invalid_argument("List<T>::splice_after");
+    if (from.head == nullptr)
+        return;
+
+    // Link 'from' in between pos and the node after it
+    from.tail->setNext(*pos.link);
+    if (*pos.link == nullptr)
+        tail = from.tail;
+    *pos.link = from.head;
+    this->n  += from.n;
+    invalidate();
+
+    // Clean up 'from'
+    from.head = from.tail = nullptr;
+    from.n    = 0;
+    from.invalidate();
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::splice_after(const_iterator pos, List<T, Alloc>& from,
+                                  const_iterator it)
+{
+    if (pos.link == nullptr || it.link == nullptr || *it.link == nullptr ||
+        !sameSource(from))
+        throw std::invalid_argument("List<T>::splice_after");
+
+    // Nothing to do if the node is already right after pos
+    Node<T>* moved = *it.link;
+    if (pos.link == it.link || pos.node == moved)
+        return;
+
+    *it.link = moved->getNext();
+    if (moved == from.tail)
+        from.tail = it.node;
+    moved->setNext(*pos.link);
+    *pos.link = moved;
+    if (moved->getNext() == nullptr)
+        tail = moved;
+    from.n--; this->n++;
+    from.invalidate();
+    invalidate();
+}
+
+// ****************************** Protected ************************************
+
+template<class T, class Alloc>
+template<class... Args>
+Node<T>* List<T, Alloc>::newNode(Args&&... args)
+{
+    if (pool)
+        return pool->create(std::forward<Args>(args)...);
+
+    NodeAlloc nodes(alloc);
+    Node<T>* node = NodeTraits::allocate(nodes, 1);
+    try {
+        NodeTraits::construct(nodes, node, std::forward<Args>(args)...);
+    }
+    catch (...) {
+        NodeTraits::deallocate(nodes, node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::freeNode(Node<T>* node)
+{
+    if (pool)
+        pool->destroy(node);
+    else {
+        NodeAlloc nodes(alloc);
+        NodeTraits::destroy(nodes, node);
+        NodeTraits::deallocate(nodes, node, 1);
+    }
+}
+
+template<class T, class Alloc>
+bool List<T, Alloc>::sameSource(const List<T, Alloc>& with) const
+{
+    if (pool || with.pool)
+        return pool == with.pool;
+    return alloc == with.alloc;
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::invalidate(void)
+{
+    finger = nullptr;
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::jump(int pos, Node<T>* node)
+{
+    if (prefetchAt == 0)
+        return;
+
+    std::size_t at = pos, size = this->n;
+    if (at >= jumps.size())
+        jumps.resize(at < size ? size : at + 1);
+    jumps[at] = node;
+    ahead(pos);
+}
+
+template<class T, class Alloc>
+inline void List<T, Alloc>::ahead(int pos) const
+{
+    // Where the table has the node we'll get to in prefetchAt steps.
+    // Prefetching a stale (even freed) node is harmless, it can't fault.
+#if defined(__GNUC__)
+    std::size_t at = pos + static_cast<std::size_t>(prefetchAt);
+    if (prefetchAt != 0 && at < jumps.size())
+        __builtin_prefetch(jumps[at]);
+#endif
+}
+
 // ****************************** Private **************************************
 
-template<class T>
-void List<T>::sort_r(Node<T>** head)
+template<class T, class Alloc>
+void List<T, Alloc>::swapAlloc(Alloc& a, Alloc& b, std::true_type)
+{
+    using std::swap;
+    swap(a, b);
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::swapAlloc(Alloc&, Alloc&, std::false_type)
+{
+    // Allocator doesn't propagate, each list keeps its own
+}
+
+template<class T, class Alloc>
+Node<T>** List<T, Alloc>::linkTo(int pos, Node<T>** prev)
+{
+    // Address of the link pointing at pos, resume from the finger if it's
+    // in front of pos
+    Node<T>** curr = &this->head;
+    int i          = 0;
+    *prev          = nullptr;
+    if (finger != nullptr && fingerPos < pos) {
+        *prev   = finger;
+        curr    = finger->nextAdr();
+        i       = fingerPos + 1;
+        nSaved += i;
+    }
+
+    nHops += pos - i;
+    for (; i < pos; i++) {
+        *prev = *curr;
+        jump(i, *prev);
+        curr  = (*curr)->nextAdr();
+    }
+
+    // Keep the node before pos, it stays put whatever happens at pos
+    if (*prev != nullptr) {
+        finger    = *prev;
+        fingerPos = pos - 1;
+    }
+
+    return curr;
+}
+
+template<class T, class Alloc>
+template<class Compare>
+void List<T, Alloc>::sortChain(Chain& chain, Compare comp)
+{
+    // pending[k] is either empty or holds 2^k merged runs. Adding a run works
+    // like incrementing a binary counter, so every merge is between equal
+    // numbers of runs and the older run is always the left one (stable).
+    Chain pending[8 * sizeof(int)] = {};
+    Chain run     = { nullptr, nullptr };
+    Chain sorted  = { nullptr, nullptr };
+    Node<T>* rest = chain.head;
+    int top       = 0;
+
+    try {
+        while (rest != nullptr) {
+            run = nextRun(&rest, comp);
+
+            int k = 0;
+            for (; k < top && pending[k].head != nullptr; k++) {
+                merge(pending[k], run, comp);
+                std::swap(pending[k], run);
+            }
+            if (k == top)
+                top++;
+            std::swap(pending[k], run);
+        }
+
+        // Fold what's left, newest runs first
+        for (int k = 0; k < top; k++)
+            if (pending[k].head != nullptr) {
+                merge(pending[k], sorted, comp);
+                std::swap(pending[k], sorted);
+            }
+    }
+    catch (...) {
+        // A comparison threw. merge() and nextRun() keep their nodes linked,
+        // gather the pieces so that the caller loses none.
+        Chain all = { nullptr, nullptr };
+        for (int k = 0; k < top; k++)
+            append(all, pending[k]);
+        append(all, run);
+        append(all, sorted);
+        if (rest != nullptr) {
+            Chain tail = { rest, rest };
+            while (tail.tail->getNext() != nullptr)
+                tail.tail = tail.tail->getNext();
+            append(all, tail);
+        }
+        chain = all;
+        throw;
+    }
+
+    chain = sorted;
+}
+
+template<class T, class Alloc>
+template<class Compare>
+void List<T, Alloc>::mergeSegments(std::vector<Chain>& seg, Compare comp)
+{
+    // Merge neighbours pairwise, one thread per pair, until one chain is left.
+    // The left segment always comes first in the list, so this is stable.
+    while (seg.size() > 1) {
+        std::size_t pairs = seg.size() / 2;
+        runThreads(pairs, [&seg, comp](std::size_t p) {
+            merge(seg[2 * p], seg[2 * p + 1], comp);
+        });
+
+        // Compact merged chains (and an odd one out) to the front
+        for (std::size_t p = 1; p < pairs; p++)
+            seg[p] = seg[2 * p];
+        if (seg.size() % 2 != 0)
+            seg[pairs] = seg.back();
+        seg.resize(pairs + seg.size() % 2);
+    }
+}
+
+template<class T, class Alloc>
+void List<T, Alloc>::append(Chain& to, Chain& from)
 {
-    // base case
-    if (*head == nullptr || (*head)->getNext() == nullptr)
+    if (from.head == nullptr)
         return;
 
-    // Divide list into two halves
-    Node<T>* leftSide;
-    Node<T>* rightSide;
-    split(*head, &leftSide, &rightSide);
+    if (to.head == nullptr)
+        to.head = from.head;
+    else
+        to.tail->setNext(from.head);
+    to.tail   = from.tail;
+    from.head = from.tail = nullptr;
+}
+
+template<class T, class Alloc>
+template<class Job>
+void List<T, Alloc>::runThreads(std::size_t count, Job job)
+{
+    // job(0) runs on this thread, the others each on their own thread, or on
+    // this one too if no more threads can be started. Exceptions are held
+    // until every job is done (a joinable thread must not be destroyed),
+    // then the first one is rethrown.
+    std::vector<std::exception_ptr> error(count);
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+
+    std::size_t started = 1;
+    try {
+        for (; started < count; started++)
+            workers.emplace_back([&job, &error, started] {
+                try {
+                    job(started);
+                }
+                catch (...) {
+                    error[started] = std::current_exception();
+                }
+            });
+    }
+    catch (const std::system_error&) {
+        // Out of threads
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        if (i > 0 && i < started)
+            continue;
+        try {
+            job(i);
+        }
+        catch (...) {
+            error[i] = std::current_exception();
+        }
+    }
+    for (std::size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+
+    for (std::size_t i = 0; i < count; i++)
+        if (error[i])
+            std::rethrow_exception(error[i]);
+}
 
-    sort_r(&leftSide);
-    sort_r(&rightSide);
-    *head = merge(leftSide, rightSide);
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::sortDefault(std::true_type)
+{
+    if (this->n >= RADIX_SORT_MIN)
+        return radixSort();
+    return sort(std::less<T>());
 }
 
-template<class T>
-void List<T>::split(Node<T>* head, Node<T>** l, Node<T>** r)
+template<class T, class Alloc>
+List<T, Alloc>& List<T, Alloc>::sortDefault(std::false_type)
 {
-    Node<T>* fast;
-    Node<T>* slow;
+    return sort(std::less<T>());
+}
 
-    slow = head;
-    fast = head->getNext();
-    while (fast != nullptr) {
-        fast = fast->getNext();
-        if (fast != nullptr) {
-            slow = slow->getNext();
-            fast = fast->getNext();
+template<class T, class Alloc>
+template<class Compare>
+typename List<T, Alloc>::Chain
+List<T, Alloc>::nextRun(Node<T>** rest, Compare comp)
+{
+    Chain run     = { *rest, *rest };
+    Node<T>* next = run.head->getNext();
+
+    // Strictly descending run, reverse it while detaching. Equal elements end
+    // the run, otherwise reversing would break stability.
+    if (next != nullptr && comp(next->getData(), run.head->getData())) {
+        run.head->setNext(nullptr);
+        try {
+            while (next != nullptr &&
+                   comp(next->getData(), run.head->getData())) {
+                Node<T>* tmp = next->getNext();
+                next->setNext(run.head);
+                run.head = next;
+                next     = tmp;
+            }
+        }
+        catch (...) {
+            // Put the reversed part back in front of the rest
+            run.tail->setNext(next);
+            *rest = run.head;
+            throw;
         }
+        *rest = next;
+        return run;
+    }
+
+    // Non-descending run
+    while (next != nullptr && !comp(next->getData(), run.tail->getData())) {
+        run.tail = next;
+        next     = next->getNext();
     }
+    run.tail->setNext(nullptr);
+    *rest = next;
 
-    *l = head;
-    *r = slow->getNext();
-    slow->setNext(nullptr);
+    return run;
 }
 
-template<class T>
-Node<T>* List<T>::merge(Node<T>* l, Node<T>* r)
+template<class T, class Alloc>
+template<class Compare>
+void List<T, Alloc>::merge(Chain& left, Chain& right, Compare comp)
 {
-    // Base cases
-    if (l == nullptr)
-        return r;
-    if (r == nullptr)
-        return l;
+    Chain l = left, r = right;
+    Node<T>** tail = &left.head;
+    right.head = right.tail = nullptr;
+
+    // Take from the right only if strictly smaller, keeps equal keys in order.
+    // If comp throws, what's left is linked after the merged part so that
+    // left still holds every node.
+    try {
+        while (l.head != nullptr && r.head != nullptr) {
+            if (comp(r.head->getData(), l.head->getData())) {
+                *tail  = r.head;
+                r.head = r.head->getNext();
+            }
+            else {
+                *tail  = l.head;
+                l.head = l.head->getNext();
+            }
+            tail = (*tail)->nextAdr();
+        }
+    }
+    catch (...) {
+        *tail = l.head;
+        if (l.head != nullptr)
+            tail = l.tail->nextAdr();
+        *tail = r.head;
+        if (r.head != nullptr)
+            left.tail = r.tail;
+        throw;
+    }
 
-    Node<T>* subHead;
-    if (l->getData() > r->getData()) {
-        subHead = r;
-        r->setNext(merge(l, r->getNext()));
+    // Whichever side is left over ends the merged chain
+    if (l.head != nullptr) {
+        *tail     = l.head;
+        left.tail = l.tail;
     }
     else {
-        subHead = l;
-        l->setNext(merge(l->getNext(), r));
+        *tail     = r.head;
+        left.tail = r.tail;
     }
+}
 
-    return subHead;
+#if __cplusplus >= 201703L
+namespace pmr {
+    template<class T>
+    using List = ::List<T, std::pmr::polymorphic_allocator<T>>;
 }
+#endif
 
 #endif // __LIST_H__
@@ -0,0 +1,718 @@
+#ifndef __MAPPED_LIST_H__
+#define __MAPPED_LIST_H__
+
+// Libraries
+#include <cerrno>
+#include <cstddef>      // size_t, ptrdiff_t
+#include <cstdint>      // uint64_t
+#include <cstring>      // memcmp, memcpy
+#include <iterator>     // forward_iterator_tag
+#include <stdexcept>    // invalid_argument
+#include <string>
+#include <system_error>
+#include <type_traits>  // is_trivially_copyable
+#include <vector>
+
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap, msync, munmap
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close, ftruncate
+
+/**
+ * My notes:
+ *  - Singly linked list that lives in a memory mapped file. Links are byte
+ *    offsets from the start of the file (0 is null), so the file means the
+ *    same thing wherever it gets mapped. Opening an existing file maps it
+ *    and the list is ready to traverse, nothing is parsed or rebuilt.
+ *  - The file starts with a header (head, tail, n, free list, ...) followed
+ *    by fixed size slots, each holding an element and the offset of the
+ *    next slot. Freed slots are recycled, the file grows by doubling.
+ *  - Only trivially copyable T, elements are stored as plain bytes. The
+ *    file is in native byte order and layout, for the machine that made it.
+ *  - Updates write the new slot first and link it last, so the file is
+ *    never worse than "list cut short, some slots lost" if the process
+ *    dies half way. The header is marked dirty by the first update after
+ *    a sync(), and opening a dirty file walks the list and rebuilds n,
+ *    tail and the free list. A clean file is trusted as it is.
+ *  - Growing the file remaps it, references, pointers and iterators to
+ *    elements are invalidated by anything that adds an element.
+ *  - One process at a time, there is no locking.
+ */
+template<class T>
+class MappedList {
+private:
+    class Iterator;
+
+public:
+    typedef Iterator iterator;
+    typedef Iterator const_iterator;
+
+// Life cycle
+
+    /** Constructor, opens or creates the file
+     *
+     * @param path          File to map, created if it doesn't exist.
+     * @param slots         Room for this many elements in a new file.
+     *
+     * @invalid_argument    Generated if the file isn't a list of T.
+     * @system_error        Generated if the file can't be opened or mapped.
+     */
+    explicit MappedList(const std::string& path, std::size_t slots = 1024);
+
+    /** Copy constructor
+     *
+     * Two lists mapping one file would trample on each other.
+     */
+    MappedList(const MappedList<T>& from) = delete;
+
+    /** Destructor
+     *
+     * Syncs and unmaps the file.
+     */
+    ~MappedList(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not assignable, see copy constructor.
+     */
+    const MappedList<T>& operator=(const MappedList<T>& from) = delete;
+
+// Operations
+
+    /** Add new node at position
+     *
+     * @param pos           Position to add new node at.
+     * @param data          Data to store in the new node.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     * @system_error        Generated if the file couldn't grow.
+     */
+    MappedList<T>& add(const int& pos, const T& data);
+
+    /** Add new node at the front (O(1))
+     *
+     * @param data          Data to store in the new node.
+     * @return              Reference to this object.
+     */
+    MappedList<T>& push_front(const T& data);
+
+    /** Add new node at the end (O(1))
+     *
+     * @param data          Data to store in the new node.
+     * @return              Reference to this object.
+     */
+    MappedList<T>& push_back(const T& data);
+
+    /** Remove node at position
+     *
+     * @param pos           Position to remove node at.
+     * @return              The removed data.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    T rm(const int& pos);
+
+    /** Remove all nodes in the list
+     *
+     * The file keeps its size, all slots go on the free list.
+     *
+     * @return              Reference to this object.
+     */
+    MappedList<T>& clear(void);
+
+    /** Make room for count more elements without growing the file again
+     *
+     * @param count         Number of elements to make room for.
+     * @return              Reference to this object.
+     *
+     * @system_error        Generated if the file couldn't grow.
+     */
+    MappedList<T>& reserve(std::size_t count);
+
+    /** Checkpoint, write everything to disk and mark the file clean
+     *
+     * @return              Reference to this object.
+     *
+     * @system_error        Generated if msync failed.
+     */
+    MappedList<T>& sync(void);
+
+// Access
+
+    /** Get size
+     *
+     * @return              Current size of the list.
+     */
+    int size(void) const;
+
+    /** Is list empty?
+     *
+     * @return              true or false.
+     */
+    bool isEmpty(void) const;
+
+    /** Peek at position
+     *
+     * @param pos           Position to peek at.
+     * @return              Data at the specified position, valid until the
+     *                      next element is added.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    T& peek(const int& pos);
+    const T& peek(const int& pos) const;
+
+    /** Did opening the file have to repair it?
+     *
+     * @return              true if the list was cut short or its size or
+     *                      tail didn't match the nodes in the file.
+     */
+    bool recovered(void) const;
+
+    /** Bytes from the start of the file to the first slot
+     */
+    static const std::size_t DATA_START;
+
+    /** Bytes per slot
+     */
+    static const std::size_t STRIDE;
+
+// Iterators
+
+    /** Iterator to the first element
+     */
+    const_iterator begin(void) const;
+
+    /** Iterator past the last element
+     */
+    const_iterator end(void) const;
+
+private:
+    // File header, offsets count from the start of the file
+    struct Header {
+        char magic[8];              // "MLIST01"
+        std::uint64_t elemSize;     // sizeof(T)
+        std::uint64_t capacity;     // File size
+        std::uint64_t used;         // End of the slots handed out so far
+        std::uint64_t head;         // First node
+        std::uint64_t tail;         // Last node
+        std::uint64_t n;            // List size
+        std::uint64_t freeList;     // Recycled slots
+        std::uint64_t dirty;        // Changed since the last sync()
+    };
+
+    // Slot in the file
+    struct Cell {
+        T data;
+        std::uint64_t next;
+    };
+
+    int fd;             // Mapped file
+    char* base;         // Start of the mapping
+    bool repaired;      // Opening had to fix the list
+
+    // Helper functions
+    Header* header(void) const;
+    Cell* cell(std::uint64_t off) const;
+    bool validSlot(std::uint64_t off) const;
+    std::uint64_t* linkTo(int pos);
+    std::uint64_t newSlot(const T& data);
+    void map(std::size_t size);
+    void grow(std::size_t slots);
+    void recover(void);
+    static void fail(const char* what);     // Throw errno
+};
+
+/**
+ * Forward iterator over a MappedList, read only.
+ */
+template<class T>
+class MappedList<T>::Iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    /** Default constructor
+     */
+    Iterator(void)
+        : base(nullptr), off(0)
+    {
+    }
+
+    /** Equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    bool operator==(const Iterator& that) const
+    {
+        return this->off == that.off;
+    }
+
+    /** Not equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    bool operator!=(const Iterator& that) const
+    {
+        return this->off != that.off;
+    }
+
+    /** Prefix increment operator
+     *
+     * @return          Reference to this object.
+     */
+    Iterator& operator++(void)
+    {
+        off = cell()->next;
+        return *this;
+    }
+
+    /** Postfix increment operator
+     *
+     * @return          Rvalue object with pre increment position.
+     */
+    Iterator operator++(int)
+    {
+        Iterator tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    /** Dereference operator
+     *
+     * @return          Reference to the iterators current element.
+     */
+    reference operator*(void) const
+    {
+        return cell()->data;
+    }
+
+    /** Member access operator
+     *
+     * @return          Pointer to the iterators current element.
+     */
+    pointer operator->(void) const
+    {
+        return &cell()->data;
+    }
+
+private:
+    friend class MappedList<T>;
+
+    /** Constructor
+     *
+     * @param Base      Start of the mapping.
+     * @param Off       Offset of the current node, 0 at end.
+     */
+    Iterator(const char* Base, std::uint64_t Off)
+        : base(Base), off(Off)
+    {
+    }
+
+    const typename MappedList<T>::Cell* cell(void) const
+    {
+        return reinterpret_cast<const typename MappedList<T>::Cell*>(
+            base + off);
+    }
+
+    const char* base;   // Start of the mapping
+    std::uint64_t off;  // Current node
+};
+
+template<class T>
+const std::size_t MappedList<T>::DATA_START =
+    (sizeof(typename MappedList<T>::Header) + 63) / 64 * 64;
+
+template<class T>
+const std::size_t MappedList<T>::STRIDE =
+    sizeof(typename MappedList<T>::Cell);
+
+// ****************************** Life cycle ***********************************
+
+template<class T>
+MappedList<T>::MappedList(const std::string& path, std::size_t slots)
+    : fd(-1), base(nullptr), repaired(false)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "MappedList stores elements as plain bytes");
+    static_assert(alignof(Cell) <= 64, "slots are aligned to 64 bytes");
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        fail("MappedList<T>::open");
+
+    // From here on, a throw must not leave the file open or mapped
+    std::size_t size = 0;
+    try {
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+            fail("MappedList<T>::open");
+
+        // New file, lay out an empty list
+        if (st.st_size == 0) {
+            size = DATA_START + (slots > 0 ? slots : 1) * STRIDE;
+            if (::ftruncate(fd, size) != 0)
+                fail("MappedList<T>::open");
+            map(size);
+            Header* h = header();
+            std::memcpy(h->magic, "MLIST01", sizeof(h->magic));
+            h->elemSize = sizeof(T);
+            h->capacity = size;
+            h->used     = DATA_START;
+            h->head     = h->tail = h->freeList = 0;
+            h->n        = 0;
+            h->dirty    = 0;
+            return;
+        }
+
+        // Existing file, check it's a list of T before touching anything
+        size = st.st_size;
+        if (size < DATA_START)
+            throw std::invalid_argument("MappedList<T>::open");
+        map(size);
+        Header* h = header();
+        if (std::memcmp(h->magic, "MLIST01", sizeof(h->magic)) != 0 ||
+            h->elemSize != sizeof(T))
+            throw std::invalid_argument("MappedList<T>::open");
+
+        // A file that grew (or was cut) behind the header's back, or a
+        // process that died before sync(), means the links can't be trusted
+        // as they are
+        bool consistent = h->capacity == size && h->used >= DATA_START &&
+                          h->used <= size &&
+                          (h->used - DATA_START) % STRIDE == 0 &&
+                          (h->head == 0) == (h->tail == 0) &&
+                          (h->head == 0 || validSlot(h->head)) &&
+                          (h->tail == 0 || validSlot(h->tail));
+        if (h->dirty != 0 || !consistent)
+            recover();
+    }
+    catch (...) {
+        if (base != nullptr)
+            ::munmap(base, size);
+        ::close(fd);
+        throw;
+    }
+}
+
+template<class T>
+MappedList<T>::~MappedList(void)
+{
+    Header* h = header();
+    ::msync(base, h->capacity, MS_SYNC);
+    h->dirty = 0;
+    std::size_t size = h->capacity;
+    ::msync(base, DATA_START, MS_SYNC);
+    ::munmap(base, size);
+    ::close(fd);
+}
+
+// ****************************** Operations ***********************************
+
+template<class T>
+MappedList<T>& MappedList<T>::add(const int& pos, const T& data)
+{
+    if (pos < 0 || pos > size())
+        throw std::invalid_argument("MappedList<T>::add");
+
+    // Take the slot first, growing remaps the file and moves every link
+    std::uint64_t off   = newSlot(data);
+    Header*       h     = header();
+    std::uint64_t* link = pos == size() && h->tail != 0 ? &cell(h->tail)->next
+                                                        : linkTo(pos);
+
+    cell(off)->next = *link;
+    *link           = off;      // from here on it's in the list
+    if (cell(off)->next == 0)
+        h->tail = off;
+    h->n++;
+
+    return *this;
+}
+
+template<class T>
+MappedList<T>& MappedList<T>::push_front(const T& data)
+{
+    return add(0, data);
+}
+
+template<class T>
+MappedList<T>& MappedList<T>::push_back(const T& data)
+{
+    return add(size(), data);
+}
+
+template<class T>
+T MappedList<T>::rm(const int& pos)
+{
+    if (pos < 0 || pos >= size())
+        throw std::invalid_argument("MappedList<T>::rm");
+
+    // Keep the node in front, it becomes the tail if the last one goes
+    Header*        h    = header();
+    std::uint64_t  prev = pos > 0 ? *linkTo(pos - 1) : 0;
+    std::uint64_t* link = prev != 0 ? &cell(prev)->next : &h->head;
+    std::uint64_t  off  = *link;
+    Cell*          c    = cell(off);
+    T              data = c->data;
+
+    h->dirty = 1;
+    *link    = c->next;
+    if (h->tail == off)
+        h->tail = prev;
+    h->n--;
+
+    c->next     = h->freeList;
+    h->freeList = off;
+
+    return data;
+}
+
+template<class T>
+MappedList<T>& MappedList<T>::clear(void)
+{
+    Header* h = header();
+    if (h->head == 0)
+        return *this;
+
+    // The whole chain goes on the free list in one go
+    h->dirty             = 1;
+    cell(h->tail)->next  = h->freeList;
+    h->freeList          = h->head;
+    h->head = h->tail    = 0;
+    h->n                 = 0;
+
+    return *this;
+}
+
+template<class T>
+MappedList<T>& MappedList<T>::reserve(std::size_t count)
+{
+    Header* h = header();
+    if (h->capacity - h->used < count * STRIDE)
+        grow(count);
+
+    return *this;
+}
+
+template<class T>
+MappedList<T>& MappedList<T>::sync(void)
+{
+    // Data first, then the clean mark
+    Header* h = header();
+    if (::msync(base, h->capacity, MS_SYNC) != 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "MappedList<T>::sync");
+    h->dirty = 0;
+    if (::msync(base, DATA_START, MS_SYNC) != 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "MappedList<T>::sync");
+
+    return *this;
+}
+
+// ****************************** Access ***************************************
+
+template<class T>
+int MappedList<T>::size(void) const
+{
+    return static_cast<int>(header()->n);
+}
+
+template<class T>
+bool MappedList<T>::isEmpty(void) const
+{
+    return header()->n == 0;
+}
+
+template<class T>
+T& MappedList<T>::peek(const int& pos)
+{
+    if (pos < 0 || pos >= size())
+        throw std::invalid_argument("MappedList<T>::peek");
+
+    Header* h = header();
+    if (pos == size() - 1)
+        return cell(h->tail)->data;
+    return cell(*linkTo(pos))->data;
+}
+
+template<class T>
+const T& MappedList<T>::peek(const int& pos) const
+{
+    return const_cast<MappedList<T>*>(this)->peek(pos);
+}
+
+template<class T>
+bool MappedList<T>::recovered(void) const
+{
+    return repaired;
+}
+
+// ****************************** Iterators ************************************
+
+template<class T>
+typename MappedList<T>::const_iterator MappedList<T>::begin(void) const
+{
+    return const_iterator(base, header()->head);
+}
+
+template<class T>
+typename MappedList<T>::const_iterator MappedList<T>::end(void) const
+{
+    return const_iterator(base, 0);
+}
+
+// ****************************** Private **************************************
+
+template<class T>
+typename MappedList<T>::Header* MappedList<T>::header(void) const
+{
+    return reinterpret_cast<Header*>(base);
+}
+
+template<class T>
+typename MappedList<T>::Cell* MappedList<T>::cell(std::uint64_t off) const
+{
+    return reinterpret_cast<Cell*>(base + off);
+}
+
+template<class T>
+bool MappedList<T>::validSlot(std::uint64_t off) const
+{
+    return off >= DATA_START && off < header()->used &&
+           (off - DATA_START) % STRIDE == 0;
+}
+
+template<class T>
+std::uint64_t* MappedList<T>::linkTo(int pos)
+{
+    std::uint64_t* link = &header()->head;
+    for (int i = 0; i < pos; i++)
+        link = &cell(*link)->next;
+
+    return link;
+}
+
+template<class T>
+std::uint64_t MappedList<T>::newSlot(const T& data)
+{
+    // data may live in the mapping (push_back(peek(0))), which growing
+    // unmaps, so copy it out first
+    const T value = data;
+    Header* h = header();
+    if (h->freeList == 0 && h->capacity - h->used < STRIDE) {
+        grow(1);
+        h = header();
+    }
+
+    // Recycle a freed slot, or carve the next one off the end
+    h->dirty = 1;
+    std::uint64_t off;
+    if (h->freeList != 0) {
+        off         = h->freeList;
+        h->freeList = cell(off)->next;
+    }
+    else {
+        off      = h->used;
+        h->used += STRIDE;
+    }
+    std::memcpy(&cell(off)->data, &value, sizeof(T));
+
+    return off;
+}
+
+template<class T>
+void MappedList<T>::map(std::size_t size)
+{
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+    if (addr == MAP_FAILED)
+        fail("MappedList<T>::map");
+    base = static_cast<char*>(addr);
+}
+
+template<class T>
+void MappedList<T>::grow(std::size_t slots)
+{
+    // At least double, so adding n elements remaps O(log n) times
+    Header*     h    = header();
+    std::size_t old  = h->capacity;
+    std::size_t size = old * 2;
+    if (size < h->used + slots * STRIDE)
+        size = h->used + slots * STRIDE;
+
+    if (::ftruncate(fd, size) != 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "MappedList<T>::grow");
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+    if (addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(),
+                                "MappedList<T>::grow");
+    ::munmap(base, old);
+    base = static_cast<char*>(addr);
+    header()->capacity = size;
+}
+
+template<class T>
+void MappedList<T>::recover(void)
+{
+    Header* h = header();
+
+    // Trust the file size over the header, keep only whole slots
+    std::size_t size = h->capacity;
+    struct stat st;
+    if (::fstat(fd, &st) == 0)
+        size = st.st_size;
+    if (h->used < DATA_START || h->used > size)
+        h->used = size;
+    h->used     = DATA_START + (h->used - DATA_START) / STRIDE * STRIDE;
+    h->capacity = size;
+
+    // Walk the list, cut it at the first link that leads nowhere valid or
+    // back into the list
+    std::vector<bool> seen((h->used - DATA_START) / STRIDE, false);
+    std::uint64_t* link = &h->head;
+    std::uint64_t  last = 0, count = 0;
+    while (*link != 0) {
+        if (!validSlot(*link) || seen[(*link - DATA_START) / STRIDE]) {
+            *link    = 0;
+            repaired = true;
+            break;
+        }
+        seen[(*link - DATA_START) / STRIDE] = true;
+        last = *link;
+        count++;
+        link = &cell(*link)->next;
+    }
+    if (h->tail != last || h->n != count)
+        repaired = true;
+    h->tail = last;
+    h->n    = count;
+
+    // Every slot not in the list is free, whatever the old free list said
+    h->freeList = 0;
+    for (std::size_t i = seen.size(); i-- > 0;)
+        if (!seen[i]) {
+            std::uint64_t off = DATA_START + i * STRIDE;
+            cell(off)->next   = h->freeList;
+            h->freeList       = off;
+        }
+
+    sync();
+}
+
+template<class T>
+void MappedList<T>::fail(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+#endif // __MAPPED_LIST_H__
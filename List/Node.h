@@ -1,6 +1,9 @@
 #ifndef __NODE_H__
 #define __NODE_H__
 
+// Libraries
+#include <utility>      // forward, move
+
 template<class T>
 class Node {
 public:
@@ -17,6 +20,21 @@ public:
      */
     Node(const T& Data, Node<T>* Next = nullptr);
 
+    /** Constructor (move version)
+     *
+     * @param Data      Data to move into the node.
+     * @param Next      Pointer to next node, NULL if not specified.
+     */
+    Node(T&& Data, Node<T>* Next = nullptr);
+
+    /** Constructor (in place version)
+     *
+     * @param Next      Pointer to next node.
+     * @param args      Arguments forwarded to the constructor of T.
+     */
+    template<class... Args>
+    Node(Node<T>* Next, Args&&... args);
+
     /** Copy constructor
      *
      * @param from      Node to copy to this node with. Here, from.data is
@@ -63,6 +81,13 @@ public:
      */
     Node<T>& setData(const T& Data);
 
+    /** Set data (move version)
+     *
+     * @param Data      Value to move into this->data.
+     * @return          Reference to this node.
+     */
+    Node<T>& setData(T&& Data);
+
     /** Set next node
      *
      * @param Next      Pointer to a node that is to be assigned to this->next.
@@ -84,6 +109,12 @@ public:
      */
     const T& getData(void) const;
 
+    /** Get data (non-constant version)
+     *
+     * @return          Reference to this->data.
+     */
+    T& getData(void);
+
     /** Get next node
      * 
      * @return          Pointer to the next node.   
@@ -108,6 +139,19 @@ Node<T>::Node(const T& Data, Node<T>* Next)
 {
 }
 
+template<class T>
+Node<T>::Node(T&& Data, Node<T>* Next)
+    : data(std::move(Data)), next(Next)
+{
+}
+
+template<class T>
+template<class... Args>
+Node<T>::Node(Node<T>* Next, Args&&... args)
+    : data(std::forward<Args>(args)...), next(Next)
+{
+}
+
 template<class T>
 Node<T>::Node(const Node<T>& from)
     : data(from.data), next(nullptr)
@@ -128,6 +172,13 @@ Node<T>& Node<T>::setData(const T& Data)
     return *this;
 }
 
+template<class T>
+Node<T>& Node<T>::setData(T&& Data)
+{
+    data = std::move(Data);
+    return *this;
+}
+
 template<class T>
 Node<T>& Node<T>::setNext(Node<T>* Next)
 {
@@ -141,6 +192,12 @@ const T& Node<T>::getData(void) const
     return data;
 }
 
+template<class T>
+T& Node<T>::getData(void)
+{
+    return data;
+}
+
 template<class T>
 Node<T>* Node<T>::getNext(void) const
 {
@@ -0,0 +1,325 @@
+#ifndef __NODE_POOL_H__
+#define __NODE_POOL_H__
+
+// Libraries
+#include <cstddef>      // size_t
+#include <memory>       // allocator, allocator_traits
+#include <new>          // placement new, bad_alloc
+#include <type_traits>  // aligned_storage
+#include <utility>      // forward, swap
+#include <vector>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+
+// My headers
+#include "Node.h"
+
+/**
+ * My notes:
+ *  - Nodes are carved out of contiguous slabs and recycled through an
+ *    intrusive free list, so add / rm stop going through global new / delete.
+ *  - A pool can back a single list or be shared between several lists. All
+ *    slabs are handed back in one go by release() or by the destructor.
+ *  - Slabs come from Alloc (rebound to the slot type), so a pool can sit on
+ *    top of an arena or a memory resource.
+ */
+template<class T, class Alloc = std::allocator<T>>
+class NodePool {
+public:
+// Life cycle
+
+    /** Constructor
+     *
+     * @param SlabSize      Number of nodes carved out of each slab.
+     * @param Allocator     Allocator slabs are taken from.
+     */
+    explicit NodePool(std::size_t SlabSize = SLAB_SIZE,
+                      const Alloc& Allocator = Alloc());
+
+    /** Copy constructor
+     *
+     * A pool owns raw memory that lists point into, copying it makes no sense.
+     */
+    NodePool(const NodePool<T, Alloc>& from) = delete;
+
+    /** Destructor
+     *
+     * Releases every slab. Nodes that are still handed out are not destroyed.
+     */
+    ~NodePool(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * Not assignable, see copy constructor.
+     */
+    const NodePool<T, Alloc>& operator=(const NodePool<T, Alloc>& from)
+        = delete;
+
+// Operations
+
+    /** Create a node
+     *
+     * @param args          Arguments forwarded to the Node<T> constructor.
+     * @return              Pointer to the new node.
+     *
+     * @bad_alloc           Generated if a new slab could not be allocated.
+     */
+    template<class... Args>
+    Node<T>* create(Args&&... args);
+
+    /** Destroy a node and put its slot on the free list
+     *
+     * @param node          Node previously returned by create().
+     */
+    void destroy(Node<T>* node);
+
+    /** Release all slabs
+     *
+     * Every node handed out by this pool becomes invalid. Nodes are not
+     * destroyed, the caller is responsible for that if T needs it.
+     */
+    void release(void);
+
+    /** Make room for count nodes in one run of consecutive slots
+     *
+     * The next count calls to create() that don't recycle a freed slot
+     * hand out neighbouring slots in address order.
+     *
+     * @param count         Number of nodes to make room for.
+     *
+     * @bad_alloc           Generated if a new slab could not be allocated.
+     */
+    void reserve(std::size_t count);
+
+    /** Swap slabs and nodes with another pool
+     *
+     * Slab sizes and allocators stay put, each pool keeps growing by its own.
+     * The allocators must be equal.
+     *
+     * @param with          Pool to swap contents with.
+     */
+    void swap(NodePool<T, Alloc>& with);
+
+// Access
+
+    /** Get number of nodes currently handed out
+     *
+     * @return              Number of live nodes.
+     */
+    std::size_t live(void) const;
+
+    /** Get number of slots in all slabs
+     *
+     * @return              Total capacity in nodes.
+     */
+    std::size_t capacity(void) const;
+
+    /** Get number of slabs
+     *
+     * @return              Number of slabs currently held.
+     */
+    std::size_t slabs(void) const;
+
+    /** Get the allocator slabs are taken from
+     *
+     * @return              Copy of the allocator.
+     */
+    Alloc get_allocator(void) const;
+
+    /** Distance in bytes between neighbouring slots
+     */
+    static const std::size_t STRIDE;
+
+    /** Default number of nodes per slab
+     */
+    static const std::size_t SLAB_SIZE = 1024;
+
+private:
+
+    // A slot either holds a node or links to the next free slot
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(Node<T>),
+                                      alignof(Node<T>)>::type raw;
+    };
+
+    // Slabs differ in size, deallocation needs both
+    struct Slab {
+        Slot* start;
+        std::size_t count;
+    };
+
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Slot>
+        SlotAlloc;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Slab>
+        SlabAlloc;
+
+    Alloc alloc;                // Source of the slabs
+    std::vector<Slab, SlabAlloc> slab;  // Every slab
+    std::size_t slabSize;       // Slots per slab
+    std::size_t nSlots;         // Slots in all slabs
+    std::size_t nLive;          // Nodes handed out
+    Slot* freeList;             // Recycled slots
+    Slot* bump;                 // Next untouched slot in the newest slab
+    Slot* limit;                // End of the newest slab
+
+    // Helper functions
+    Slot* grab(void);
+    void carve(std::size_t count);
+};
+
+template<class T, class Alloc>
+const std::size_t NodePool<T, Alloc>::STRIDE =
+    sizeof(typename NodePool<T, Alloc>::Slot);
+
+template<class T, class Alloc>
+const std::size_t NodePool<T, Alloc>::SLAB_SIZE;
+
+// ****************************** Life cycle ***********************************
+
+template<class T, class Alloc>
+NodePool<T, Alloc>::NodePool(std::size_t SlabSize, const Alloc& Allocator)
+    : alloc(Allocator), slab(SlabAlloc(Allocator)),
+      slabSize(SlabSize > 0 ? SlabSize : 1), nSlots(0), nLive(0),
+      freeList(nullptr), bump(nullptr), limit(nullptr)
+{
+}
+
+template<class T, class Alloc>
+NodePool<T, Alloc>::~NodePool(void)
+{
+    release();
+}
+
+// ****************************** Operations ***********************************
+
+template<class T, class Alloc>
+template<class... Args>
+Node<T>* NodePool<T, Alloc>::create(Args&&... args)
+{
+    Slot* slot = grab();
+
+    Node<T>* node;
+    try {
+        node = new (&slot->raw) Node<T>(std::forward<Args>(args)...);
+    }
+    catch (...) {
+        slot->next = freeList;  // constructor threw, give the slot back
+        freeList   = slot;
+        throw;
+    }
+    nLive++;
+
+    return node;
+}
+
+template<class T, class Alloc>
+void NodePool<T, Alloc>::destroy(Node<T>* node)
+{
+    node->~Node<T>();
+
+    Slot* slot = reinterpret_cast<Slot*>(node);
+    slot->next = freeList;
+    freeList   = slot;
+    nLive--;
+}
+
+template<class T, class Alloc>
+void NodePool<T, Alloc>::release(void)
+{
+    SlotAlloc slots(alloc);
+    for (std::size_t i = 0; i < slab.size(); i++)
+        std::allocator_traits<SlotAlloc>::deallocate(slots, slab[i].start,
+                                                     slab[i].count);
+    slab.clear();
+
+    freeList = bump = limit = nullptr;
+    nLive    = nSlots = 0;
+}
+
+template<class T, class Alloc>
+void NodePool<T, Alloc>::reserve(std::size_t count)
+{
+    if (static_cast<std::size_t>(limit - bump) < count)
+        carve(count > slabSize ? count : slabSize);
+}
+
+template<class T, class Alloc>
+void NodePool<T, Alloc>::swap(NodePool<T, Alloc>& with)
+{
+    slab.swap(with.slab);
+    std::swap(nSlots, with.nSlots);
+    std::swap(nLive, with.nLive);
+    std::swap(freeList, with.freeList);
+    std::swap(bump, with.bump);
+    std::swap(limit, with.limit);
+}
+
+// ****************************** Access ***************************************
+
+template<class T, class Alloc>
+std::size_t NodePool<T, Alloc>::live(void) const
+{
+    return nLive;
+}
+
+template<class T, class Alloc>
+std::size_t NodePool<T, Alloc>::capacity(void) const
+{
+    return nSlots;
+}
+
+template<class T, class Alloc>
+std::size_t NodePool<T, Alloc>::slabs(void) const
+{
+    return slab.size();
+}
+
+template<class T, class Alloc>
+Alloc NodePool<T, Alloc>::get_allocator(void) const
+{
+    return alloc;
+}
+
+// ****************************** Private **************************************
+
+template<class T, class Alloc>
+typename NodePool<T, Alloc>::Slot* NodePool<T, Alloc>::grab(void)
+{
+    // Recycle freed slots first, they are most likely still in cache
+    if (freeList != nullptr) {
+        Slot* slot = freeList;
+        freeList   = slot->next;
+        return slot;
+    }
+
+    // Carve a new slab when the current one is used up
+    if (bump == limit)
+        carve(slabSize);
+
+    return bump++;
+}
+
+template<class T, class Alloc>
+void NodePool<T, Alloc>::carve(std::size_t count)
+{
+    slab.reserve(slab.size() + 1);  // don't leak the slab if this throws
+    SlotAlloc slots(alloc);
+    bump  = std::allocator_traits<SlotAlloc>::allocate(slots, count);
+    limit = bump + count;
+    Slab s = { bump, count };
+    slab.push_back(s);
+    nSlots += count;
+}
+
+#if __cplusplus >= 201703L
+namespace pmr {
+    template<class T>
+    using NodePool = ::NodePool<T, std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
+#endif // __NODE_POOL_H__
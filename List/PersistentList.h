@@ -0,0 +1,680 @@
+#ifndef __PERSISTENT_LIST_H__
+#define __PERSISTENT_LIST_H__
+
+// Libraries
+#include <atomic>
+#include <cstddef>      // ptrdiff_t
+#include <iostream>
+#include <iterator>     // forward_iterator_tag
+#include <stdexcept>    // invalid_argument
+#include <utility>      // forward, move, swap
+
+/**
+ * My notes:
+ *  - Immutable list, every "modifying" operation returns a new list and
+ *    leaves this one as it is. Nodes are reference counted and shared
+ *    between all lists that can reach them, so copying a list is O(1).
+ *  - A list is a view of its first n nodes. push_back() links the new node
+ *    after the last one if nobody did so yet, so a writer appending to its
+ *    latest version never copies, and every older version still sees only
+ *    its own n nodes. Appending to an older version copies it first.
+ *  - push_front() and pop_front() share the whole rest. add(), rm() and
+ *    set() copy the nodes in front of the position and share the rest.
+ *  - Nodes are never changed once a list can see them, so lists can be
+ *    handed to other threads and read there without locking. Copying and
+ *    destroying lists from several threads is safe too, reference counts
+ *    are atomic.
+ */
+template<class T>
+class PersistentList {
+private:
+    struct Cell;
+    class Iterator;
+
+public:
+    typedef Iterator iterator;
+    typedef Iterator const_iterator;
+
+// Life cycle
+
+    /** Default constructor
+     */
+    PersistentList(void);
+
+    /** Copy constructor (O(1))
+     *
+     * @param from          This object is copied to this list (shared).
+     */
+    PersistentList(const PersistentList<T>& from);
+
+    /** Move constructor
+     *
+     * @param from          This object is copied to this list (stolen).
+     */
+    PersistentList(PersistentList<T>&& from);
+
+    /** Destructor
+     *
+     * Drops this list's reference, nodes no other list can reach are freed.
+     */
+    ~PersistentList(void);
+
+// Operators
+
+    /** Assignment operator (O(1))
+     *
+     * @param from          This object is assigned to this list (shared).
+     * @return              This object.
+     */
+    PersistentList<T>& operator=(PersistentList<T> from);
+
+    /** Equal to operator
+     *
+     * @param obj           Object to compare this object with.
+     * @return              true if both lists hold equal elements.
+     */
+    bool operator==(const PersistentList<T>& obj) const;
+
+    /** Not equal to operator
+     *
+     * @param obj           Object to compare this object with.
+     * @return              true if the lists differ.
+     */
+    bool operator!=(const PersistentList<T>& obj) const;
+
+// Operations
+
+    /** Add new node at the front (O(1))
+     *
+     * @param data          Data to store in the new node.
+     * @return              New list, this list is shared as its rest.
+     */
+    PersistentList<T> push_front(const T& data) const;
+    PersistentList<T> push_front(T&& data) const;
+
+    /** Remove the first node (O(1))
+     *
+     * @return              New list sharing everything after the first node.
+     *
+     * @invalid_argument    An exception is generated if the list is empty.
+     */
+    PersistentList<T> pop_front(void) const;
+
+    /** Add new node at the end
+     *
+     * O(1) if no other list appended to this one's last node yet, otherwise
+     * this list is copied first.
+     *
+     * @param data          Data to store in the new node.
+     * @return              New list.
+     */
+    PersistentList<T> push_back(const T& data) const;
+    PersistentList<T> push_back(T&& data) const;
+
+    /** Add new node at position
+     *
+     * Copies the pos nodes in front of the new one, shares the rest.
+     *
+     * @param pos           Position of the new node.
+     * @param data          Data to store in the new node.
+     * @return              New list.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    PersistentList<T> add(const int& pos, const T& data) const;
+
+    /** Replace the element at position
+     *
+     * Copies the pos nodes in front of it, shares the rest.
+     *
+     * @param pos           Position to replace.
+     * @param data          New data.
+     * @return              New list.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    PersistentList<T> set(const int& pos, const T& data) const;
+
+    /** Remove node at position
+     *
+     * Copies the pos nodes in front of it, shares the rest. Removing the last
+     * node copies nothing, the new list is a shorter view of this one.
+     *
+     * @param pos           Position to remove.
+     * @return              New list.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    PersistentList<T> rm(const int& pos) const;
+
+    /** Reverse the list (copies every node)
+     *
+     * @return              New list.
+     */
+    PersistentList<T> reverse(void) const;
+
+    /** Swap with another list (O(1))
+     *
+     * @param with          List to swap contents with.
+     */
+    void swap(PersistentList<T>& with);
+
+// Access
+
+    /** Get size
+     *
+     * @return              Current size of the list.
+     */
+    const int& size(void) const;
+
+    /** Is list empty?
+     *
+     * @return              true or false.
+     */
+    bool isEmpty(void) const;
+
+    /** Get the first element
+     *
+     * @return              Data stored in the first node.
+     *
+     * @invalid_argument    An exception is generated if the list is empty.
+     */
+    const T& front(void) const;
+
+    /** Peek at position
+     *
+     * @param pos           Possition to peek at.
+     * @return              Data stored in the specified position.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    const T& peek(const int& pos) const;
+
+    /** Prints the list
+     *
+     * @return              Reference to this object.
+     */
+    const PersistentList<T>& print(void) const;
+
+// Iterators
+
+    /** Iterator to the first element
+     */
+    const_iterator begin(void) const;
+
+    /** Iterator past the last element
+     */
+    const_iterator end(void) const;
+
+private:
+    // Reference counted node, next is set at most once after the node is
+    // linked into a list
+    struct Cell {
+        template<class... Args>
+        explicit Cell(Cell* Next, Args&&... args)
+            : data(std::forward<Args>(args)...), next(Next), refs(1)
+        {
+        }
+
+        T data;
+        std::atomic<Cell*> next;    // Owned reference, nullptr if none
+        std::atomic<long> refs;     // Lists and cells pointing here
+    };
+
+    Cell* head;     // First node, nullptr if empty
+    Cell* tail;     // Last node seen by this list, nullptr if empty
+    int n;          // List size, nodes after tail belong to other lists
+
+    /** Constructor, adopts a reference to Head
+     */
+    PersistentList(Cell* Head, Cell* Tail, int N);
+
+    // Helper functions
+    static Cell* hold(Cell* cell);
+    static void drop(Cell* cell);
+    Cell* at(int pos) const;
+    Cell* copyFront(int count, Cell* rest) const;
+    template<class... Args>
+    PersistentList<T> append(Args&&... args) const;
+};
+
+/**
+ * Forward iterator over the first n nodes of a PersistentList<T>.
+ */
+template<class T>
+class PersistentList<T>::Iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    /** Default constructor
+     */
+    Iterator(void)
+        : cell(nullptr), left(0)
+    {
+    }
+
+    /** Equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    bool operator==(const Iterator& that) const
+    {
+        return this->left == that.left;
+    }
+
+    /** Not equal to operator
+     *
+     * @param that      Iterator to compare this object with.
+     */
+    bool operator!=(const Iterator& that) const
+    {
+        return this->left != that.left;
+    }
+
+    /** Prefix increment operator
+     *
+     * @return          Reference to this object.
+     */
+    Iterator& operator++(void)
+    {
+        if (--left > 0)
+            cell = cell->next.load(std::memory_order_acquire);
+        else
+            cell = nullptr;
+        return *this;
+    }
+
+    /** Postfix increment operator
+     *
+     * @return          Rvalue object with pre increment position.
+     */
+    Iterator operator++(int)
+    {
+        Iterator tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    /** Dereference operator
+     *
+     * @return          Reference to the iterators current element.
+     */
+    reference operator*(void) const
+    {
+        return cell->data;
+    }
+
+    /** Member access operator
+     *
+     * @return          Pointer to the iterators current element.
+     */
+    pointer operator->(void) const
+    {
+        return &cell->data;
+    }
+
+private:
+    friend class PersistentList<T>;
+
+    /** Constructor
+     *
+     * @param Curr      Current node.
+     * @param Left      Elements left including the current one.
+     */
+    Iterator(const typename PersistentList<T>::Cell* Curr, int Left)
+        : cell(Curr), left(Left)
+    {
+    }
+
+    const typename PersistentList<T>::Cell* cell;   // Current node
+    int left;                                       // 0 at end
+};
+
+// ****************************** Life cycle ***********************************
+
+template<class T>
+PersistentList<T>::PersistentList(void)
+    : head(nullptr), tail(nullptr), n(0)
+{
+}
+
+template<class T>
+PersistentList<T>::PersistentList(const PersistentList<T>& from)
+    : head(hold(from.head)), tail(from.tail), n(from.n)
+{
+}
+
+template<class T>
+PersistentList<T>::PersistentList(PersistentList<T>&& from)
+    : head(from.head), tail(from.tail), n(from.n)
+{
+    from.head = from.tail = nullptr;
+    from.n    = 0;
+}
+
+template<class T>
+PersistentList<T>::PersistentList(Cell* Head, Cell* Tail, int N)
+    : head(Head), tail(Tail), n(N)
+{
+}
+
+template<class T>
+PersistentList<T>::~PersistentList(void)
+{
+    drop(head);
+}
+
+// ****************************** Operators  ***********************************
+
+template<class T>
+PersistentList<T>& PersistentList<T>::operator=(PersistentList<T> from)
+{
+    swap(from);
+    return *this;
+}
+
+template<class T>
+bool PersistentList<T>::operator==(const PersistentList<T>& obj) const
+{
+    if (this->n != obj.n)
+        return false;
+
+    const_iterator a = begin(), b = obj.begin();
+    for (; a != end(); ++a, ++b)
+        if (!(*a == *b))
+            return false;
+
+    return true;
+}
+
+template<class T>
+bool PersistentList<T>::operator!=(const PersistentList<T>& obj) const
+{
+    return !(*this == obj);
+}
+
+// ****************************** Operations ***********************************
+
+template<class T>
+PersistentList<T> PersistentList<T>::push_front(const T& data) const
+{
+    Cell* cell = new Cell(nullptr, data);
+    cell->next.store(hold(head), std::memory_order_relaxed);
+    return PersistentList<T>(cell, n == 0 ? cell : tail, n + 1);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::push_front(T&& data) const
+{
+    Cell* cell = new Cell(nullptr, std::move(data));
+    cell->next.store(hold(head), std::memory_order_relaxed);
+    return PersistentList<T>(cell, n == 0 ? cell : tail, n + 1);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::pop_front(void) const
+{
+    if (n == 0)
+        throw std::invalid_argument("PersistentList<T>::pop_front");
+
+    if (n == 1)
+        return PersistentList<T>();
+    return PersistentList<T>(hold(head->next.load(std::memory_order_acquire)),
+                             tail, n - 1);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::push_back(const T& data) const
+{
+    return append(data);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::push_back(T&& data) const
+{
+    return append(std::move(data));
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::add(const int& pos, const T& data) const
+{
+    if (pos < 0 || pos > n)
+        throw std::invalid_argument("PersistentList<T>::add");
+
+    if (pos == 0)
+        return push_front(data);
+    if (pos == n)
+        return push_back(data);
+
+    // Copy the front, the new node takes over the rest
+    Cell* cell = new Cell(nullptr, data);
+    cell->next.store(hold(at(pos)), std::memory_order_relaxed);
+    Cell* front;
+    try {
+        front = copyFront(pos, cell);
+    }
+    catch (...) {
+        drop(cell);
+        throw;
+    }
+    drop(cell);     // copyFront() took its own reference
+
+    return PersistentList<T>(front, tail, n + 1);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::set(const int& pos, const T& data) const
+{
+    if (pos < 0 || pos >= n)
+        throw std::invalid_argument("PersistentList<T>::set");
+
+    Cell* old  = at(pos);
+    Cell* cell = new Cell(nullptr, data);
+    cell->next.store(hold(old->next.load(std::memory_order_acquire)),
+                     std::memory_order_relaxed);
+    Cell* front;
+    try {
+        front = copyFront(pos, cell);
+    }
+    catch (...) {
+        drop(cell);
+        throw;
+    }
+    drop(cell);     // copyFront() took its own reference
+
+    return PersistentList<T>(front, old == tail ? cell : tail, n);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::rm(const int& pos) const
+{
+    if (pos < 0 || pos >= n)
+        throw std::invalid_argument("PersistentList<T>::rm");
+
+    if (pos == 0)
+        return pop_front();
+    if (pos == n - 1)   // shorter view, nothing to copy
+        return PersistentList<T>(hold(head), at(pos - 1), n - 1);
+
+    Cell* front = copyFront(pos, at(pos)->next.load(std::memory_order_acquire));
+
+    return PersistentList<T>(front, tail, n - 1);
+}
+
+template<class T>
+PersistentList<T> PersistentList<T>::reverse(void) const
+{
+    PersistentList<T> rev;
+    for (const_iterator it = begin(); it != end(); ++it)
+        rev = rev.push_front(*it);
+
+    return rev;
+}
+
+template<class T>
+void PersistentList<T>::swap(PersistentList<T>& with)
+{
+    std::swap(this->head, with.head);
+    std::swap(this->tail, with.tail);
+    std::swap(this->n, with.n);
+}
+
+// ****************************** Access ***************************************
+
+template<class T>
+const int& PersistentList<T>::size(void) const
+{
+    return this->n;
+}
+
+template<class T>
+bool PersistentList<T>::isEmpty(void) const
+{
+    return this->n <= 0;
+}
+
+template<class T>
+const T& PersistentList<T>::front(void) const
+{
+    if (n == 0)
+        throw std::invalid_argument("PersistentList<T>::front");
+
+    return head->data;
+}
+
+template<class T>
+const T& PersistentList<T>::peek(const int& pos) const
+{
+    if (pos < 0 || pos >= n)
+        throw std::invalid_argument("PersistentList<T>::peek");
+
+    return at(pos)->data;
+}
+
+template<class T>
+const PersistentList<T>& PersistentList<T>::print(void) const
+{
+    for (const_iterator it = begin(); it != end(); ++it)
+        std::cout << *it << " ";
+    std::cout << std::endl;
+
+    return *this;
+}
+
+// ****************************** Iterators ************************************
+
+template<class T>
+typename PersistentList<T>::const_iterator PersistentList<T>::begin(void) const
+{
+    return const_iterator(head, n);
+}
+
+template<class T>
+typename PersistentList<T>::const_iterator PersistentList<T>::end(void) const
+{
+    return const_iterator();
+}
+
+// ****************************** Private **************************************
+
+template<class T>
+typename PersistentList<T>::Cell* PersistentList<T>::hold(Cell* cell)
+{
+    if (cell != nullptr)
+        cell->refs.fetch_add(1, std::memory_order_relaxed);
+    return cell;
+}
+
+template<class T>
+void PersistentList<T>::drop(Cell* cell)
+{
+    // Iterative, a long chain must not recurse once per node
+    while (cell != nullptr &&
+           cell->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Cell* next = cell->next.load(std::memory_order_relaxed);
+        delete cell;
+        cell = next;
+    }
+}
+
+template<class T>
+typename PersistentList<T>::Cell* PersistentList<T>::at(int pos) const
+{
+    if (pos == n - 1)
+        return tail;
+
+    Cell* curr = head;
+    for (int i = 0; i < pos; i++)
+        curr = curr->next.load(std::memory_order_acquire);
+
+    return curr;
+}
+
+template<class T>
+typename PersistentList<T>::Cell*
+PersistentList<T>::copyFront(int count, Cell* rest) const
+{
+    // Nothing in front of rest, it becomes the head itself
+    if (count == 0)
+        return hold(rest);
+
+    // Copies are built front to back, each owns the next one
+    Cell* front = nullptr;
+    Cell* prev  = nullptr;
+    Cell* curr  = head;
+    try {
+        for (int i = 0; i < count; i++) {
+            Cell* copy = new Cell(nullptr, curr->data);
+            if (prev == nullptr)
+                front = copy;
+            else
+                prev->next.store(copy, std::memory_order_relaxed);
+            prev = copy;
+            curr = curr->next.load(std::memory_order_acquire);
+        }
+    }
+    catch (...) {
+        drop(front);
+        throw;
+    }
+
+    prev->next.store(hold(rest), std::memory_order_release);
+
+    return front;
+}
+
+template<class T>
+template<class... Args>
+PersistentList<T> PersistentList<T>::append(Args&&... args) const
+{
+    Cell* cell = new Cell(nullptr, std::forward<Args>(args)...);
+    if (n == 0)
+        return PersistentList<T>(cell, cell, 1);
+
+    // Claim the slot after our last node, it's free unless another version
+    // of this list appended there already
+    Cell* expected = nullptr;
+    if (tail->next.compare_exchange_strong(expected, cell,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed))
+        return PersistentList<T>(hold(head), cell, n + 1);
+
+    // Taken, copy this list and append to the copy
+    Cell* front;
+    try {
+        front = copyFront(n, cell);
+    }
+    catch (...) {
+        drop(cell);
+        throw;
+    }
+    drop(cell);     // copyFront() took its own reference
+
+    return PersistentList<T>(front, cell, n + 1);
+}
+
+#endif // __PERSISTENT_LIST_H__
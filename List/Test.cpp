@@ -1,7 +1,1638 @@
 #include "Node.h"
+#include "List.h"
+#include "UnrolledList.h"
+#include "IndexedList.h"
+#include "PersistentList.h"
+#include "ConcurrentQueue.h"
+#include "IntrusiveList.h"
+#include "MappedList.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Count every heap allocation made by the test program, and fail the one
+// numbered failAt
+static std::atomic<long> allocations(0);
+static std::atomic<long> failAt(0);
+
+void* operator new(std::size_t size)
+{
+	if (++allocations == failAt)
+		throw std::bad_alloc();
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+static void testPool(void)
+{
+	std::shared_ptr<NodePool<int>> pool = std::make_shared<NodePool<int>>(4);
+	List<int> a(pool), b(pool);
+
+	for (int i = 0; i < 10; i++)
+		a.add(a.size(), i);
+	for (int i = 0; i < 3; i++)
+		b.add(0, i);
+	assert(pool->live() == 13 && pool->slabs() == 4);
+
+	// Freed slots are recycled before a new slab is carved
+	assert(a.rm(0) == 0 && a.size() == 9);
+	b.add(0, 42);
+	assert(pool->live() == 13 && pool->slabs() == 4);
+
+	// Shared pool, so clear() must give back nodes one by one
+	a.clear();
+	assert(pool->live() == 4 && pool->slabs() == 4);
+
+	// Sole user, all slabs go in one shot
+	b.clear();
+	assert(pool->live() == 0 && pool->slabs() == 0);
+
+	// Copies share the pool
+	List<int> c(pool);
+	c.add(0, 1).add(1, 2);
+	List<int> d(c);
+	assert(d == c && pool->live() == 4);
+
+	// Nodes can't migrate between pools
+	List<int> e;
+	e.add(0, 3);
+	bool threw = false;
+	try { c.merge(0, e); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw);
+}
+
+// Element by element comparison against List<T> as the reference
+template<class T, class A, class U>
+static bool same(const List<T, A>& ref, const U& other)
+{
+	if (ref.size() != other.size())
+		return false;
+	for (int i = 0; i < ref.size(); i++)
+		if (!(ref.peek(i) == other.peek(i)))
+			return false;
+	return true;
+}
+
+static void testUnrolled(void)
+{
+	// Small blocks so splits and merges happen all the time
+	List<int> ref;
+	UnrolledList<int, 32> ul;
+	std::srand(1);
+	for (int step = 0; step < 4000; step++) {
+		int pos = ref.size() > 0 ? std::rand() % (ref.size() + 1) : 0;
+		if (std::rand() % 3 != 0 || ref.isEmpty()) {
+			ref.add(pos, step % 50);
+			ul.add(pos, step % 50);
+		}
+		else {
+			pos %= ref.size();
+			assert(ref.rm(pos) == ul.rm(pos));
+		}
+	}
+	assert(same(ref, ul));
+	assert((ul.blocks() * UnrolledList<int, 32>::CAP <= 2 * ul.size() + 64));
+	assert(same(ref.search(7), ul.search(7)));
+
+	ref.reverse();
+	ul.reverse();
+	assert(same(ref, ul));
+
+	ref.sort();
+	ul.sort();
+	assert(same(ref, ul));
+
+	// Merge mid-block, at the front and at the end
+	UnrolledList<int, 32> other, copy(ul);
+	List<int> refOther;
+	for (int i = 0; i < 20; i++) {
+		other.add(i, -i);
+		refOther.add(i, -i);
+	}
+	UnrolledList<int, 32> front(other), back(other);
+	List<int> refFront(refOther), refBack(refOther);
+	ul.merge(7, other).merge(0, front);
+	ul.merge(ul.size(), back);
+	ref.merge(7, refOther).merge(0, refFront);
+	ref.merge(ref.size(), refBack);
+	assert(same(ref, ul) && other.isEmpty());
+	assert(copy != ul);
+
+	// Appending packs blocks full
+	typedef UnrolledList<int, 32> Small;
+	Small packed;
+	for (int i = 0; i < 100; i++)
+		packed.add(packed.size(), i);
+	assert(packed.blocks() == (100 + Small::CAP - 1) / Small::CAP);
+	assert(packed.peek(99) == 99);
+
+	// Blocks sit on their own cache lines
+	UnrolledList<int> lines;
+	for (int i = 0; i < 1000; i++)
+		lines.add(i / 2, i);
+	assert(lines.peek(0) == 1 && lines.size() == 1000);
+	for (int i = 0; i < lines.size(); i++)
+		assert(reinterpret_cast<std::uintptr_t>(&lines.peek(i)) % 64 >=
+		       UnrolledList<int>::SLOTS_AT);
+
+	// Non-trivial element type
+	UnrolledList<std::string> words;
+	for (int i = 0; i < 100; i++)
+		words.add(i / 2, std::to_string(i));
+	UnrolledList<std::string> moved(std::move(words));
+	assert(moved.size() == 100 && words.isEmpty());
+	while (!moved.isEmpty())
+		moved.rm(moved.size() / 2);
+}
+
+// Ascending by key only, so stability is visible in the second member
+struct ByKey {
+	bool operator()(const std::pair<int, int>& a,
+	                const std::pair<int, int>& b) const
+	{
+		return a.first < b.first;
+	}
+};
+
+static void testSort(void)
+{
+	// Deep enough to overflow the stack with a recursive merge
+	const int n = 300000;
+	List<int> big;
+	for (int i = 0; i < n; i++)
+		big.add(0, i);
+	big.sort();
+	for (int i = 0; i < 1000; i++)
+		assert(big.peek(i) == i);
+	assert(big.peek(n - 1) == n - 1);
+	big.sort(std::greater<int>());
+	assert(big.peek(0) == n - 1 && big.peek(n - 1) == 0);
+
+	// Random input, stable on equal keys, mixed runs
+	List<std::pair<int, int>> pairs;
+	std::srand(3);
+	for (int i = 0; i < 5000; i++)
+		pairs.add(0, std::make_pair(std::rand() % 20, 5000 - i));
+	for (int i = 0; i < 100; i++)
+		pairs.add(0, std::make_pair(100 - i, 0));
+	pairs.sort(ByKey());
+	for (int i = 1; i < pairs.size(); i++) {
+		const std::pair<int, int>& a = pairs.peek(i - 1);
+		const std::pair<int, int>& b = pairs.peek(i);
+		assert(a.first < b.first || (a.first == b.first && a.second < b.second));
+	}
+
+	// Descending runs with duplicates stay stable too
+	List<std::pair<int, int>> desc;
+	for (int i = 0; i < 50; i++)
+		desc.add(desc.size(), std::make_pair((50 - i) / 2, i));
+	desc.sort(ByKey());
+	for (int i = 1; i < desc.size(); i++)
+		assert(desc.peek(i - 1).first < desc.peek(i).first ||
+		       desc.peek(i - 1).second < desc.peek(i).second);
+
+	List<int> empty;
+	empty.sort();
+	assert(empty.isEmpty());
+
+	// Parallel path, odd thread count so one segment waits a round
+	List<std::pair<int, int>> par;
+	for (int i = 0; i < 100000; i++)
+		par.add(0, std::make_pair(std::rand() % 1000, 100000 - i));
+	par.sortParallel(3, ByKey());
+	assert(par.size() == 100000);
+	for (std::pair<int, int> a = par.rm(0), b; !par.isEmpty(); a = b) {
+		b = par.rm(0);
+		assert(a.first < b.first || (a.first == b.first && a.second < b.second));
+	}
+
+	// A throwing comparator leaves every element in the list, serial and
+	// parallel, on the calling thread or a worker
+	for (long limit : { 10L, 1000L, 200000L, 1500000L }) {
+		for (unsigned threads : { 1u, 3u }) {
+			List<int> thrower;
+			long sum = 0;
+			for (int i = 0; i < 100000; i++) {
+				thrower.add(0, std::rand() % 1000);
+				sum += thrower.peek(0);
+			}
+			std::atomic<long> calls(0);
+			bool thrown = false;
+			try {
+				thrower.sortParallel(threads, [&](int a, int b) {
+					if (++calls == limit)
+						throw std::runtime_error("compare");
+					return a < b;
+				});
+			}
+			catch (const std::runtime_error&) { thrown = true; }
+			assert(thrown == (calls >= limit));
+			long seen = 0;
+			int count = 0;
+			for (int x : thrower) {
+				seen += x;
+				count++;
+			}
+			assert(count == 100000 && thrower.size() == 100000 && seen == sum);
+			thrower.sort();
+			for (int i = 1; i < 100; i++)
+				assert(thrower.peek(i - 1) <= thrower.peek(i));
+			thrower.push_back(-1);
+			assert(thrower.peek(100000) == -1);
+		}
+	}
+}
+
+static void testIterators(void)
+{
+	List<int> list;
+	for (int i = 0; i < 10; i++)
+		list.add(i, i);
+
+	// Range-for, <algorithm> and const iteration
+	int sum = 0;
+	for (int& x : list)
+		x *= 2;
+	for (const int& x : static_cast<const List<int>&>(list))
+		sum += x;
+	assert(sum == 90);
+	assert(*std::find(list.begin(), list.end(), 8) == 8);
+	assert(std::count_if(list.cbegin(), list.cend(),
+	                     [](int x) { return x % 4 == 0; }) == 5);
+	assert(std::is_sorted(list.begin(), list.end()));
+	List<int>::const_iterator ci = list.begin();
+	assert(ci == list.begin() && ++ci != list.begin());
+
+	// Streaming edit: drop multiples of 4, duplicate the rest
+	for (List<int>::iterator prev = list.before_begin(), it = list.begin();
+	     it != list.end(); ) {
+		if (*it % 4 == 0) {
+			it = list.erase_after(prev);
+		}
+		else {
+			prev = list.insert_after(it, *it);
+			it   = prev;
+			++it;
+		}
+	}
+	assert(list.size() == 10 && list.peek(0) == 2 && list.peek(1) == 2);
+	assert(list.peek(9) == 18);
+
+	// Emplace at the front
+	List<std::pair<int, int>> pairs;
+	pairs.emplace_after(pairs.before_begin(), 1, 2);
+	assert(pairs.begin()->second == 2 && pairs.size() == 1);
+
+	// Splice a whole list and single nodes
+	List<int> other;
+	other.add(0, -1).add(1, -2);
+	list.splice_after(list.before_begin(), other);
+	assert(other.isEmpty() && list.size() == 12 && list.peek(1) == -2);
+	list.splice_after(list.before_begin(), list, list.begin());
+	assert(list.peek(0) == -2 && list.peek(1) == -1);
+	list.splice_after(list.begin(), list, list.before_begin());
+	assert(list.peek(0) == -2 && list.size() == 12);
+	other.add(0, 7);
+	other.splice_after(other.begin(), list, list.before_begin());
+	assert(other.size() == 2 && other.peek(1) == -2 && list.size() == 11);
+
+	bool threw = false;
+	try { list.erase_after(list.end()); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw);
+}
+
+// peek(size() - 1) reads the tail pointer, compare it with a full walk
+template<class T>
+static bool tailOk(const List<T>& list)
+{
+	if (list.isEmpty())
+		return list.begin() == list.end();
+	const T* last = nullptr;
+	for (const T& x : list)
+		last = &x;
+	return last == &list.peek(list.size() - 1);
+}
+
+static void testTail(void)
+{
+	List<int> list;
+	for (int i = 0; i < 5; i++)
+		list.push_back(i);
+	list.emplace_back(5);
+	assert(tailOk(list) && list.peek(5) == 5);
+
+	list.rm(5);
+	assert(tailOk(list) && list.peek(4) == 4);
+	list.add(list.size(), 9).add(2, 7);
+	assert(tailOk(list) && list.peek(6) == 9);
+	list.reverse();
+	assert(tailOk(list) && list.peek(6) == 0);
+	list.sort();
+	assert(tailOk(list) && list.peek(6) == 9);
+	list.sortParallel(2);
+	assert(tailOk(list));
+
+	// Appending and merging in the middle or at the end
+	List<int> other, more;
+	other.push_back(10).push_back(11);
+	more.push_back(-1);
+	list.append(other);
+	assert(tailOk(list) && list.peek(list.size() - 1) == 11 && tailOk(other));
+	list.merge(1, more);
+	assert(tailOk(list) && list.size() == 10);
+
+	// The donor's finger doesn't outlive its nodes
+	List<int> a, b;
+	a.push_back(0).push_back(1);
+	b.push_back(2).push_back(3).push_back(4).push_back(5);
+	b.peek(2);
+	a.merge(1, b);
+	assert(a.size() == 6 && a.peek(1) == 2 && a.peek(5) == 1 && b.size() == 0);
+	for (int i = 0; i < 6; i++)
+		b.push_back(10 + i);
+	assert(b.peek(3) == 13);
+	b.rm(3);
+	assert(tailOk(b) && b.size() == 5 && b.peek(3) == 14);
+	assert(a.size() == 6 && a.peek(2) == 3 && a.peek(5) == 1 && tailOk(a));
+
+	// Iterator operations on the last node
+	List<int>::iterator last = list.begin();
+	for (int i = 1; i < list.size(); i++)
+		++last;
+	list.insert_after(last, 12);
+	assert(tailOk(list) && list.peek(list.size() - 1) == 12);
+	list.erase_after(last);
+	assert(tailOk(list) && list.peek(list.size() - 1) == 11);
+	other.push_back(20);
+	list.splice_after(list.before_begin(), other, other.before_begin());
+	assert(tailOk(list) && tailOk(other) && other.isEmpty());
+	other.push_back(21);
+	list.splice_after(last, other);
+	assert(tailOk(list) && list.peek(list.size() - 1) == 21);
+
+	while (list.size() > 1)
+		list.rm(list.size() - 1);
+	assert(tailOk(list));
+	list.rm(0);
+	assert(tailOk(list));
+	list.push_back(1);
+	list.clear();
+	assert(tailOk(list));
+	list.push_back(2);
+	assert(tailOk(list) && list.peek(0) == 2);
+}
+
+// Payload that owns a heap buffer and counts deep copies
+struct Buffer {
+	static int copies;
+	std::unique_ptr<char[]> data;
+
+	explicit Buffer(int size) : data(new char[size]) {}
+	Buffer(const Buffer& from) : data(new char[1]) { copies++; (void)from; }
+	Buffer(Buffer&& from) = default;
+	Buffer& operator=(const Buffer& from) { copies++; (void)from; return *this; }
+	Buffer& operator=(Buffer&& from) = default;
+	bool operator==(const Buffer& that) const { return data == that.data; }
+};
+int Buffer::copies = 0;
+
+static void testMove(void)
+{
+	List<Buffer> list;
+	Buffer b(64);
+	list.push_back(std::move(b));
+	list.add(0, Buffer(32));
+	list.emplace(1, 16);
+	list.emplace_back(8);
+	list.insert_after(list.begin(), Buffer(4));
+	list.emplace_after(list.before_begin(), 2);
+	assert(Buffer::copies == 0 && list.size() == 6);
+
+	// Removing moves the payload out of the node
+	Buffer out = list.rm(2);
+	assert(Buffer::copies == 0 && out.data != nullptr);
+
+	// Whole lists change hands without touching a single element
+	long before = allocations;
+	List<Buffer> moved(std::move(list));
+	List<Buffer> assigned;
+	assigned = std::move(moved);
+	assert(allocations == before && Buffer::copies == 0);
+	assert(assigned.size() == 5 && list.isEmpty() && moved.isEmpty());
+
+	// Copy assignment is deep and leaves the source alone
+	List<Buffer> copy;
+	copy.emplace_back(1);
+	copy = assigned;
+	assert(Buffer::copies == 5 && copy.size() == 5 && assigned.size() == 5);
+	copy = copy;
+	assert(copy.size() == 5);
+
+	List<std::string> words, other;
+	words.push_back("a").push_back("b");
+	other.push_back("c");
+	words.swap(other);
+	assert(words.size() == 1 && words.peek(0) == "c" && other.peek(1) == "b");
+}
+
+static void testIndexed(void)
+{
+	List<int> ref;
+	IndexedList<int> il;
+	std::srand(5);
+	for (int step = 0; step < 20000; step++) {
+		int pos = std::rand() % (ref.size() + 1);
+		if (std::rand() % 4 != 0 || ref.isEmpty()) {
+			ref.add(pos, step);
+			il.add(pos, step);
+		}
+		else {
+			pos %= ref.size();
+			assert(ref.rm(pos) == il.rm(pos));
+		}
+		if (step % 1000 == 0) {
+			pos = std::rand() % ref.size();
+			assert(ref.peek(pos) == il.peek(pos));
+		}
+	}
+	assert(same(ref, il) && il.lanes() > 1);
+
+	// Iteration walks the plain node chain
+	List<int>::const_iterator r = ref.begin();
+	for (int x : il)
+		assert(x == *r++);
+
+	// Towers are rebuilt after bulk reordering and copies
+	ref.sort();
+	il.sort();
+	assert(same(ref, il));
+	ref.reverse();
+	il.reverse();
+	IndexedList<int> copy(il), moved(std::move(il));
+	assert(same(ref, copy) && same(ref, moved) && il.isEmpty());
+	il = copy;
+	assert(same(ref, il));
+
+	// Down to nothing and back
+	while (!copy.isEmpty())
+		copy.rm(copy.size() / 2);
+	assert(copy.lanes() == 0);
+	copy.add(0, 1).add(1, 3).add(1, 2);
+	assert(copy.peek(1) == 2 && copy.peek(2) == 3);
+	copy.clear();
+	assert(copy.isEmpty() && copy.begin() == copy.end());
+}
+
+static void testFinger(void)
+{
+	const int n = 2000;
+	List<int> list;
+	for (int i = 0; i < n; i++)
+		list.push_back(i);
+
+	// Sequential peeks resume from the finger, so they walk n hops in total
+	long sum = 0;
+	for (int i = 0; i < list.size(); i++)
+		sum += list.peek(i);
+	assert(sum == (long)n * (n - 1) / 2);
+	assert(list.hops() < 2 * n && list.hopsSaved() > (long)n * (n - 10) / 2);
+
+	// Editing while walking by position stays linear and correct
+	long before = list.hops();
+	for (int i = 0; i < list.size(); i++)
+		if (list.peek(i) % 2 != 0)
+			list.rm(i--);
+		else
+			list.add(++i, -1);
+	assert(list.size() == n && list.hops() - before < 6 * n);
+	for (int i = 0; i < 20; i += 2)
+		assert(list.peek(i) == i && list.peek(i + 1) == -1);
+
+	// Every other mutation drops the finger
+	list.peek(10);
+	list.reverse();
+	assert(list.peek(10) == -1 && list.peek(11) == n - 12);
+	list.sort();
+	assert(list.peek(0) == -1 && list.peek(n - 1) == n - 2);
+	list.peek(5);
+	list.erase_after(list.before_begin());
+	assert(list.peek(5) == -1 && list.peek(n / 2 - 1) == 0);
+	list.peek(3);
+	list.insert_after(list.before_begin(), 99);
+	assert(list.peek(0) == 99 && list.peek(4) == -1);
+	List<int> other;
+	other.push_back(7);
+	list.peek(2);
+	list.merge(1, other);
+	assert(list.peek(1) == 7 && list.peek(2) == -1);
+	list.peek(1);
+	list.clear();
+	list.push_back(1);
+	assert(list.peek(0) == 1);
+}
+
+static bool isOdd(const int& x)
+{
+	return x % 2 != 0;
+}
+
+static void testSearch(void)
+{
+	List<int> list;
+	for (int i = 0; i < 30; i++)
+		list.push_back(i % 10);
+
+	// search() now lists positions in ascending order
+	List<int> pos = list.search(3);
+	assert(pos.size() == 3 && pos.peek(0) == 3 && pos.peek(1) == 13 && pos.peek(2) == 23);
+
+	// None of the lazy forms touch the heap
+	long before = allocations;
+	assert(list.find_first(7) == 7 && list.find_first(10) == -1);
+	assert(list.find_first_if(isOdd) == 1);
+	assert(list.count(0) == 3 && list.count(10) == 0);
+	assert(list.count_if(isOdd) == 15);
+
+	int seen = 0, last = -1;
+	int hits = list.visit(5, [&](int p, const int& x) {
+		assert(x == 5 && p > last);
+		last = p; seen++;
+		return true;
+	});
+	assert(hits == 3 && seen == 3 && last == 25);
+
+	// Visitors stop early by returning false
+	hits = list.visit_if(isOdd, [&](int p, const int&) { return p < 5; });
+	assert(hits == 3);
+
+	int want[] = { 4, 14, 24 }, k = 0;
+	for (int p : list.matches(4))
+		assert(p == want[k++]);
+	assert(k == 3);
+
+	List<int>::Matches<List<int>::KeyEqual> none = list.matches(-1);
+	assert(none.begin() == none.end());
+
+	// Break out of the range, the rest is never scanned
+	k = 0;
+	List<int>::Matches<bool (*)(const int&)> odd = list.matches_if(isOdd);
+	for (List<int>::Matches<bool (*)(const int&)>::iterator it = odd.begin(); ; ++it, k++)
+		if (it.value() == 7) {
+			assert(*it == 7 && k == 3);
+			break;
+		}
+	assert(allocations == before);
+
+	// Same API on IndexedList
+	IndexedList<std::string> il;
+	il.add(0, "b").add(0, "a").add(2, "b");
+	assert(il.find_first("b") == 1 && il.count("b") == 2);
+}
+
+static void testCompact(void)
+{
+	const int n = 1000;
+
+	// Pool shared with another list, churn and sort scatter the nodes
+	std::shared_ptr<NodePool<int>> pool = std::make_shared<NodePool<int>>(64);
+	List<int> list(pool), other(pool);
+	for (int i = 0; i < n; i++)
+		list.add(i / 2, i * 7919 % n);
+	for (int i = 0; i < n; i += 3)
+		list.add(i, list.rm(n - 1 - i));
+	list.sort();
+	assert(list.fragmentation() > 0.5);
+
+	// Other list holds nodes in the pool, leave it alone
+	other.push_back(-1);
+	const int* first = &list.peek(0);
+	list.compact();
+	assert(&list.peek(0) == first);
+	other.clear();
+
+	// Sole user now, nodes end up in one run in list order
+	List<int> ref;
+	for (List<int>::iterator it = list.begin(); it != list.end(); ++it)
+		ref.push_back(*it);
+	list.compact();
+	assert(list.fragmentation() == 0 && same(ref, list) && tailOk(list));
+	assert(pool->slabs() == 1 && pool->live() == (std::size_t)n);
+	assert(list.peek(n - 1) == n - 1);
+
+	// Same pool object, so lists sharing it still merge
+	other.push_back(n);
+	list.merge(n, other);
+	list.push_back(n + 1);
+	assert(list.size() == n + 2 && list.peek(n + 1) == n + 1 && tailOk(list));
+
+	// Heap list moves to a pool of its own
+	List<std::string> words;
+	for (int i = 0; i < 100; i++)
+		words.add(0, std::string(20 + i % 7, 'a' + i % 26));
+	List<std::string> wref(words);
+	words.compact();
+	assert(words.fragmentation() == 0 && same(wref, words) && tailOk(words));
+
+	// autoCompact only kicks in above the threshold
+	List<int> a;
+	for (int i = 0; i < n; i++)
+		a.push_back(std::rand());
+	a.autoCompact(0.5).sort();
+	assert(a.fragmentation() == 0);
+	List<int> b;
+	const int m = List<int>::PARALLEL_SORT_MIN * 2;
+	for (int i = 0; i < m; i++)
+		b.push_back(std::rand());
+	b.autoCompact(0.5).sortParallel(2, std::greater<int>());
+	assert(b.fragmentation() == 0 && b.peek(0) >= b.peek(m - 1));
+	b.autoCompact(1).sort();
+	assert(b.fragmentation() > 0.5);
+}
+
+template<class T>
+static bool same(const List<T>& ref, const PersistentList<T>& other)
+{
+	if (ref.size() != other.size())
+		return false;
+	typename PersistentList<T>::const_iterator it = other.begin();
+	for (typename List<T>::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it)
+		if (!(*r == *it))
+			return false;
+	return it == other.end();
+}
+
+static void testPersistent(void)
+{
+	typedef PersistentList<std::string> Words;
+
+	// Copies and prepends share every node
+	Words a = Words().push_front("c").push_front("b");
+	long before = allocations;
+	Words b(a);
+	Words c = a.push_front("a");
+	assert(allocations - before <= 2);
+	assert(a.size() == 2 && b == a && c.size() == 3 && c.front() == "a");
+	assert(c.pop_front() == a && c.peek(2) == "c");
+
+	// Appending to the latest version links in place, older ones don't see it
+	PersistentList<int> v0;
+	PersistentList<int> v1 = v0.push_back(1);
+	PersistentList<int> v2 = v1.push_back(2);
+	before = allocations;
+	PersistentList<int> v3 = v2.push_back(3);
+	assert(allocations - before == 1);
+	assert(v1.size() == 1 && v2.size() == 2 && v3.size() == 3 && v3.peek(2) == 3);
+
+	// A second append to v2 can't link in place, it copies v2 first
+	PersistentList<int> w3 = v2.push_back(4);
+	assert(w3.peek(2) == 4 && v3.peek(2) == 3 && w3.peek(0) == 1);
+	PersistentList<int> v4 = v3.push_back(5);
+	assert(v4.size() == 4 && v4.peek(3) == 5);
+
+	// Positional updates copy the front only
+	List<int> ref;
+	PersistentList<int> p;
+	for (int i = 0; i < 100; i++) {
+		ref.push_back(i);
+		p = p.push_back(i);
+	}
+	PersistentList<int> snap = p;
+	before = allocations;
+	PersistentList<int> q = p.set(10, -1);
+	assert(allocations - before == 11);
+	ref.rm(10);
+	ref.add(10, -1);
+	assert(same(ref, q) && q.peek(99) == 99 && q.peek(9) == 9);
+	before = allocations;
+	q = q.add(5, 42).rm(0);
+	q = q.rm(q.size() - 1).rm(3);
+	assert(allocations - before == 6 + 3);
+	ref.add(5, 42);
+	ref.rm(0);
+	ref.rm(ref.size() - 1);
+	ref.rm(3);
+	assert(same(ref, q));
+	assert(q.push_back(7).peek(q.size()) == 7 && snap.size() == 100);
+	for (int i = 0; i < 100; i++)
+		assert(snap.peek(i) == i && p.peek(i) == i);
+	assert(p.reverse().peek(0) == 99 && p.reverse().reverse() == p);
+
+	// Replacing the head copies nothing, also when it's the tail too
+	PersistentList<int> two = PersistentList<int>().push_back(1).push_back(2);
+	before = allocations;
+	PersistentList<int> head = two.set(0, 9);
+	assert(allocations - before == 1);
+	assert(head.size() == 2 && head.peek(0) == 9 && head.peek(1) == 2);
+	assert(two.peek(0) == 1 && head.push_back(3).peek(2) == 3);
+	PersistentList<int> one = PersistentList<int>().push_back(1).set(0, 5);
+	assert(one.size() == 1 && one.peek(0) == 5 && one.push_back(6).peek(1) == 6);
+
+	bool thrown = false;
+	try { PersistentList<int>().pop_front(); }
+	catch (const std::invalid_argument&) { thrown = true; }
+	assert(thrown);
+
+	// Readers walk snapshots while the writer keeps appending
+	const int n = 20000;
+	std::mutex m;
+	PersistentList<int> latest;
+	std::thread reader([&] {
+		for (int seen = 0; seen < n; ) {
+			PersistentList<int> snap;
+			{
+				std::lock_guard<std::mutex> lock(m);
+				snap = latest;
+			}
+			int i = 0;
+			for (PersistentList<int>::const_iterator it = snap.begin();
+			     it != snap.end(); ++it)
+				assert(*it == i++);
+			assert(i == snap.size() && i >= seen);
+			seen = i;
+		}
+	});
+	PersistentList<int> w;
+	for (int i = 0; i < n; i++) {
+		w = w.push_back(i);
+		if (i % 64 == 0 || i == n - 1) {
+			std::lock_guard<std::mutex> lock(m);
+			latest = w;
+		}
+	}
+	reader.join();
+}
+
+static void testConcurrentQueue(void)
+{
+	ConcurrentQueue<std::string> words;
+	std::string w;
+	assert(words.isEmpty() && !words.pop(w));
+	words.push("a");
+	words.emplace(3, 'b');
+	std::string c("c");
+	words.push(std::move(c));
+	assert(!words.isEmpty() && words.pop(w) && w == "a");
+	List<std::string> rest;
+	assert(words.popAll(rest) == 2 && rest.size() == 2);
+	assert(rest.peek(0) == "bbb" && rest.peek(1) == "c" && words.isEmpty());
+	words.push("left behind");     // freed by the destructor
+
+	// Producers hammer the queue, every producer's items come out in order
+	const int producers = 4, each = 50000;
+	ConcurrentQueue<long> q;
+	std::atomic<int> ready(0);
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producers; p++)
+		threads.emplace_back([&q, &ready, p, producers] {
+			ready++;
+			while (ready < producers)
+				std::this_thread::yield();
+			for (long i = 0; i < each; i++)
+				q.push((long)p << 32 | i);
+		});
+
+	std::vector<long> next(producers, 0);
+	List<long> batch;
+	long x;
+	for (int got = 0; got < producers * each; ) {
+		if (got % 3 == 0 && q.popAll(batch) > 0) {
+			while (!batch.isEmpty()) {
+				x = batch.rm(0);
+				assert((x & 0xffffffff) == next[x >> 32]++);
+				got++;
+			}
+		}
+		else if (q.pop(x)) {
+			assert((x & 0xffffffff) == next[x >> 32]++);
+			got++;
+		}
+		else
+			std::this_thread::yield();
+	}
+	for (std::size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+	for (int p = 0; p < producers; p++)
+		assert(next[p] == each);
+	assert(q.isEmpty() && !q.pop(x));
+}
+
+// Stateful allocator counting live objects, equal if ids match
+template<class T, bool Propagate>
+struct Counting {
+	typedef T value_type;
+	typedef std::integral_constant<bool, Propagate> Tag;
+	typedef Tag propagate_on_container_copy_assignment;
+	typedef Tag propagate_on_container_move_assignment;
+	typedef Tag propagate_on_container_swap;
+	template<class U> struct rebind { typedef Counting<U, Propagate> other; };
+
+	Counting(long* Live, int Id) : live(Live), id(Id) {}
+	template<class U>
+	Counting(const Counting<U, Propagate>& from) : live(from.live), id(from.id) {}
+
+	T* allocate(std::size_t k)
+	{
+		*live += k;
+		return static_cast<T*>(::operator new(k * sizeof(T)));
+	}
+	void deallocate(T* p, std::size_t k)
+	{
+		*live -= k;
+		::operator delete(p);
+	}
+
+	long* live;
+	int id;
+};
+
+template<class T, class U, bool P>
+static bool operator==(const Counting<T, P>& a, const Counting<U, P>& b)
+{
+	return a.id == b.id;
+}
+
+template<class T, class U, bool P>
+static bool operator!=(const Counting<T, P>& a, const Counting<U, P>& b)
+{
+	return a.id != b.id;
+}
+
+static void testAllocator(void)
+{
+	long live1 = 0, live2 = 0;
+	{
+		typedef Counting<int, false> Sticky;
+		List<int, Sticky> a(Sticky(&live1, 1)), b(Sticky(&live2, 2));
+		for (int i = 0; i < 10; i++)
+			a.push_back(i);
+		assert(live1 == 10);
+
+		// Copies keep the source's allocator, assignment keeps the target's
+		List<int, Sticky> c(a);
+		assert(live1 == 20 && c.get_allocator().id == 1);
+		b = a;
+		assert(live2 == 10 && b.get_allocator().id == 2 && same(a, b));
+
+		// Unequal allocators that don't propagate, elements are moved over
+		b.clear();
+		b = std::move(c);
+		assert(live1 == 10 && live2 == 10 && c.isEmpty() && same(a, b));
+
+		// Nodes can't cross to an allocator that can't free them
+		bool thrown = false;
+		try { a.swap(b); }
+		catch (const std::invalid_argument&) { thrown = true; }
+		assert(thrown);
+		thrown = false;
+		try { a.merge(0, b); }
+		catch (const std::invalid_argument&) { thrown = true; }
+		assert(thrown && a.size() == 10 && b.size() == 10);
+		List<int, Sticky> d(Sticky(&live1, 1));
+		d.push_back(-1);
+		a.merge(0, d);
+		assert(a.size() == 11 && a.peek(0) == -1 && live1 == 11);
+
+		// compact() takes its slabs from the allocator too
+		a.compact();
+		assert(a.fragmentation() == 0 && live2 == 10);
+		assert(a.size() == 11 && a.peek(10) == 9);
+
+		// The pool compact() made stays, later growth takes normal slabs
+		List<int, Sticky> big(Sticky(&live2, 2));
+		for (int i = 0; i < 20000; i++)
+			big.push_back(i);
+		big.compact();
+		long before = live2;
+		big.push_back(-1);
+		assert(live2 - before <= 2 * (long)NodePool<int>::SLAB_SIZE);
+		assert(big.fragmentation() <= 1.0 / 20000 && big.peek(20000) == -1);
+	}
+	assert(live1 == 0 && live2 == 0);
+	{
+		typedef Counting<int, true> Follow;
+		List<int, Follow> a(Follow(&live1, 1)), b(Follow(&live2, 2));
+		for (int i = 0; i < 10; i++) {
+			a.push_back(i);
+			b.push_back(-i);
+		}
+
+		// Propagating allocators travel with the nodes
+		a.swap(b);
+		assert(a.get_allocator().id == 2 && b.get_allocator().id == 1);
+		a = b;
+		assert(a.get_allocator().id == 1 && live1 == 20 && live2 == 0);
+		List<int, Follow> c(Follow(&live2, 2));
+		c.push_back(1);
+		c = std::move(a);
+		assert(c.get_allocator().id == 1 && live1 == 20 && live2 == 0);
+	}
+	assert(live1 == 0 && live2 == 0);
+
+	// A request scoped arena backs the whole list, the heap is never touched
+	{
+		static char buffer[1 << 16];
+		std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+		                                          std::pmr::null_memory_resource());
+		long before = allocations;
+		pmr::List<int> list(&arena);
+		for (int i = 0; i < 100; i++)
+			list.add(0, i);
+		list.sort();
+		list.compact();
+		pmr::List<int> other(list, &arena);
+		std::shared_ptr<pmr::NodePool<int>> pool =
+			std::allocate_shared<pmr::NodePool<int>>(
+				std::pmr::polymorphic_allocator<int>(&arena), 16, &arena);
+		pmr::List<int> pooled(pool, &arena);
+		pooled.push_back(1);
+		assert(allocations == before);
+		assert(list.get_allocator().resource() == &arena && same(list, other));
+
+		// Copy construction doesn't carry the resource over
+		pmr::List<int> copy(list);
+		assert(copy.get_allocator().resource() == std::pmr::get_default_resource());
+		assert(same(list, copy) && list.peek(99) == 99);
+	}
+}
+
+template<class T>
+static List<T> fromVector(const std::vector<T>& v)
+{
+	List<T> list;
+	for (std::size_t i = 0; i < v.size(); i++)
+		list.push_back(v[i]);
+	return list;
+}
+
+template<class T>
+static bool same(const List<T>& list, const std::vector<T>& v)
+{
+	if (list.size() != static_cast<int>(v.size()) || !tailOk(list))
+		return false;
+	std::size_t i = 0;
+	for (const T& x : list)
+		if (!(x == v[i++]))
+			return false;
+	return true;
+}
+
+static std::vector<int> sortedRandom(int n, int range)
+{
+	std::vector<int> v;
+	for (int i = 0; i < n; i++)
+		v.push_back(std::rand() % range);
+	std::sort(v.begin(), v.end());
+	return v;
+}
+
+static void testSetAlgebra(void)
+{
+	// Multisets of every size against the std:: algorithms
+	std::srand(3);
+	for (int round = 0; round < 200; round++) {
+		std::vector<int> x = sortedRandom(std::rand() % 30, 20);
+		std::vector<int> y = sortedRandom(std::rand() % 30, 20);
+		std::vector<int> expect;
+
+		List<int> a = fromVector(x), b = fromVector(y);
+		expect.resize(x.size() + y.size());
+		std::merge(x.begin(), x.end(), y.begin(), y.end(), expect.begin());
+		assert(same(a.mergeSorted(b), expect) && b.isEmpty() && tailOk(b));
+
+		a = fromVector(x); b = fromVector(y);
+		expect.clear();
+		std::set_union(x.begin(), x.end(), y.begin(), y.end(),
+		               std::back_inserter(expect));
+		assert(same(a.unite(b), expect) && b.isEmpty());
+
+		a = fromVector(x); b = fromVector(y);
+		expect.clear();
+		std::set_intersection(x.begin(), x.end(), y.begin(), y.end(),
+		                      std::back_inserter(expect));
+		assert(same(a.intersect(b), expect) && same(b, y));
+
+		a = fromVector(x);
+		expect.clear();
+		std::set_difference(x.begin(), x.end(), y.begin(), y.end(),
+		                    std::back_inserter(expect));
+		assert(same(a.subtract(b), expect) && same(b, y));
+
+		a = fromVector(x);
+		expect = x;
+		expect.erase(std::unique(expect.begin(), expect.end()), expect.end());
+		assert(same(a.unique(), expect));
+	}
+
+	// k-way merge is stable: equal keys keep list order, this list first
+	typedef std::pair<int, int> Item;   // key, source list
+	auto byKey = [](const Item& l, const Item& r) { return l.first > r.first; };
+	std::vector<Item> all;
+	std::vector<List<Item>> lists(7);
+	std::vector<List<Item>*> others;
+	for (int i = 0; i < 7; i++) {
+		std::vector<Item> v;
+		for (int j = std::rand() % 50; j > 0; j--)
+			v.push_back(Item(std::rand() % 10, i));
+		std::stable_sort(v.begin(), v.end(), byKey);
+		lists[i] = fromVector(v);
+		all.insert(all.end(), v.begin(), v.end());
+		if (i > 0)
+			others.push_back(&lists[i]);
+	}
+	others.push_back(&lists[3]);    // given twice, merged once
+	std::stable_sort(all.begin(), all.end(), byKey);
+	lists[0].mergeSorted(others, byKey);
+	assert(same(lists[0], all));
+	for (int i = 1; i < 7; i++)
+		assert(lists[i].isEmpty());
+
+	// Nodes are relinked, not copied
+	auto pool = std::make_shared<NodePool<int>>(16);
+	List<int> p(pool), q(pool), r(pool);
+	for (int i = 0; i < 10; i++) {
+		p.push_back(2 * i);
+		q.push_back(2 * i + 1);
+		r.push_back(i);
+	}
+	const int* seven = &q.peek(3);
+	std::vector<List<int>*> qr;
+	qr.push_back(&q);
+	qr.push_back(&r);
+	p.mergeSorted(qr);
+	assert(pool->live() == 30 && &p.peek(14) == seven);
+	p.unique();
+	assert(p.size() == 20 && pool->live() == 20 && p.peek(19) == 19);
+
+	List<int> s(pool);
+	s.push_back(7).push_back(40);
+	long before = allocations;
+	p.unite(s);
+	assert(allocations == before);
+	assert(p.size() == 21 && pool->live() == 21 && tailOk(p));
+	p.subtract(p);
+	assert(p.isEmpty() && pool->live() == 0 && tailOk(p));
+
+	// Nodes can't migrate between pools
+	List<int> heap;
+	heap.push_back(1);
+	bool threw = false;
+	try { p.mergeSorted(heap); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw);
+	threw = false;
+	try { p.unite(p); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw);
+	threw = false;
+	qr.assign(1, &heap);
+	try { p.mergeSorted(qr); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw && heap.size() == 1);
+}
+
+template<class T>
+static void checkRadix(const std::vector<T>& v)
+{
+	List<T> list = fromVector(v);
+	std::vector<T> expect = v;
+	std::sort(expect.begin(), expect.end());
+	long before = allocations;
+	list.radixSort();
+	assert(allocations == before && same(list, expect));
+}
+
+static void testRadix(void)
+{
+	std::srand(5);
+	std::vector<int> ints;
+	std::vector<unsigned long long> wide;
+	std::vector<double> reals;
+	std::vector<signed char> chars;
+	std::vector<bool> bits;
+	for (int i = 0; i < 5000; i++) {
+		ints.push_back(std::rand() - RAND_MAX / 2);
+		wide.push_back(static_cast<unsigned long long>(std::rand()) << (i % 40));
+		reals.push_back((std::rand() - RAND_MAX / 2) / 7.0);
+		chars.push_back(static_cast<signed char>(std::rand()));
+		bits.push_back(std::rand() % 2 == 0);
+	}
+	ints.push_back(INT_MIN);
+	ints.push_back(INT_MAX);
+	reals.push_back(-1.0 / 0.0);
+	reals.push_back(1.0 / 0.0);
+	reals.push_back(0.0);
+	checkRadix(ints);
+	checkRadix(wide);
+	checkRadix(reals);
+	checkRadix(chars);
+	checkRadix(std::vector<float>(reals.begin(), reals.end()));
+	checkRadix(std::vector<int>(ints.begin(), ints.begin() + 1));
+	std::vector<long long> many;     // wide digits
+	for (int i = 0; i < List<long long>::RADIX_WIDE_MIN + 7; i++)
+		many.push_back((static_cast<long long>(std::rand()) << 33) - std::rand());
+	checkRadix(many);
+	checkRadix(std::vector<int>());
+	List<bool> b = fromVector(bits);
+	b.radixSort();
+	assert(b.count(false) + b.count(true) == b.size() && !b.peek(0) &&
+	       b.peek(b.count(false)) && tailOk(b));
+
+	// Only the low bytes differ, the others are skipped
+	List<int> small;
+	for (int i = 0; i < 1000; i++)
+		small.push_back((i * 7919) % 1000);
+	small.radixSort();
+	for (int i = 0; i < 1000; i++)
+		assert(small.peek(i) == i);
+
+	// Stable by an extracted key, nodes are relinked not copied
+	typedef std::pair<double, int> Item;
+	std::vector<Item> items;
+	for (int i = 0; i < 3000; i++)
+		items.push_back(Item(std::rand() % 20 - 10.5, i));
+	List<Item> list = fromVector(items);
+	const Item* first = &list.peek(0);
+	list.radixSort([](const Item& x) { return x.first; });
+	std::stable_sort(items.begin(), items.end(),
+	                 [](const Item& l, const Item& r) { return l.first < r.first; });
+	assert(same(list, items));
+	bool found = false;
+	for (const Item& x : list)
+		found = found || &x == first;
+	assert(found);
+
+	// sort() switches over by itself for long lists of numbers
+	auto pool = std::make_shared<NodePool<int>>();
+	List<int> big(pool);
+	for (std::size_t i = 0; i < ints.size(); i++)
+		big.push_back(ints[i]);
+	std::sort(ints.begin(), ints.end());
+	long before = allocations;
+	big.sort();
+	assert(allocations == before && same(big, ints));
+	assert(pool->live() == ints.size());
+
+	// Floating point lists keep operator<'s stable order, -0.0 and 0.0
+	// compare equal and stay as they were
+	List<double> zeros;
+	for (int i = 0; i < 1000; i++)
+		zeros.push_back(i % 3 == 0 ? -0.0 : i % 3 == 1 ? 0.0 : i % 7 - 3.5);
+	zeros.sort();
+	std::vector<bool> signs;
+	for (double x : zeros)
+		if (x == 0)
+			signs.push_back(std::signbit(x));
+	for (std::size_t i = 0; i < signs.size(); i++)
+		assert(signs[i] == (i % 2 == 0));
+
+	// radixSort() orders by the bits, -0.0 first
+	zeros.radixSort();
+	signs.clear();
+	for (double x : zeros)
+		if (x == 0)
+			signs.push_back(std::signbit(x));
+	assert(std::is_sorted(signs.rbegin(), signs.rend()));
+	assert(signs.front() && !signs.back());
+}
+
+// Sink recording the size of every block it gets
+static void countBlocks(void* blocks, const char*, std::size_t size)
+{
+	static_cast<std::vector<std::size_t>*>(blocks)->push_back(size);
+}
+
+static void testBufferedIO(void)
+{
+	// Text, integers through to_chars, the rest as operator<< writes it
+	std::ostringstream text;
+	{
+		Writer out(text, 16);   // tiny buffer, flushed all the time
+		List<int> ints;
+		ints.push_back(-12).push_back(0).push_back(INT_MAX);
+		ints.print(out);
+		List<double> reals;
+		reals.push_back(0.1).push_back(-2.5).push_back(1e300);
+		reals.print(out.put('|'), ',');
+		List<std::string> words;
+		words.push_back("a").push_back("bc");
+		words.print(out.put('|'));
+		List<char> chars;
+		chars.push_back('x').push_back('y');
+		chars.print(out.put('|'), '.');
+	}
+	assert(text.str() == "-12 0 2147483647 |0.1,-2.5,1e+300,|a bc |x.y.");
+
+	// print() keeps its output format
+	std::ostringstream console;
+	std::streambuf* old = std::cout.rdbuf(console.rdbuf());
+	List<int> small;
+	small.push_back(1).push_back(2);
+	small.print();
+	List<double> reals;
+	reals.push_back(1234567.0).push_back(0.1 + 0.2).push_back(-1e-7);
+	reals.print();
+
+	// ... and std::cout's own format when the caller set one
+	std::ios_base::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	std::cout << std::hex << std::showbase;
+	small.print();
+	std::cout.flags(flags);
+	std::cout << std::fixed << std::setprecision(2);
+	reals.print();
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+	std::cout << std::setw(3);
+	small.print();
+	std::cout.rdbuf(old);
+	assert(console.str() == "1 2 \n1.23457e+06 0.3 -1e-07 \n"
+	                        "0x1 0x2 \n1234567.00 0.30 -0.00 \n  1 2 \n");
+
+	// Binary round trip, into a list with and without a pool
+	List<long> big;
+	for (long i = 0; i < 100000; i++)
+		big.push_back(i * i - 7);
+	std::stringstream bin;
+	{
+		Writer out(bin);
+		big.save(out);
+	}
+	Reader in(bin);
+	List<long> loaded;
+	loaded.push_back(3);
+	loaded.load(in);
+	assert(loaded == big && tailOk(loaded));
+
+	// Nodes come in two runs of consecutive slots (64K, then the rest)
+	assert(loaded.fragmentation() * (loaded.size() - 1) < 1.5);
+
+	auto pool = std::make_shared<NodePool<long>>(16);
+	List<long> pooled(pool), other(pool);
+	pooled.push_back(1);
+	other.push_back(2);
+	bin.clear();
+	bin.seekg(0);
+	Reader again(bin);
+	pooled.load(again);
+	assert(pooled == big && pool->live() == 100001);
+	pooled.append(other);     // still shares its pool
+	assert(pooled.size() == 100001);
+
+	// Broken input leaves the list alone
+	std::string dump = bin.str();
+	std::istringstream cut(dump.substr(0, dump.size() - 1));
+	Reader shortIn(cut);
+	bool threw = false;
+	try { loaded.load(shortIn); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw && loaded == big);
+	std::istringstream wrongType(dump);
+	Reader wrongIn(wrongType);
+	List<int> ints;
+	threw = false;
+	try { ints.load(wrongIn); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw && ints.isEmpty());
+
+	// A corrupt count is not believed up front, the data runs out first
+	std::stringstream lying;
+	{
+		Writer out(lying);
+		writeHeader<long>(out, 0x7fffffff);
+		long some[4] = { 1, 2, 3, 4 };
+		out.write(reinterpret_cast<const char*>(some), sizeof(some));
+	}
+	Reader lyingIn(lying);
+	std::size_t slots = pool->capacity();
+	threw = false;
+	try { pooled.load(lyingIn); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw && pooled.size() == 100001);
+	assert(pool->capacity() - slots <= 1 << 16);
+
+	// Contiguous blocks larger than the buffer skip it, one sink call
+	std::vector<int> block(10000, 7);
+	std::vector<std::size_t> blocks;
+	{
+		Writer out(countBlocks, &blocks, 1024);
+		writeBinary(out, block.data(), block.size());
+	}
+	assert(blocks.size() == 2 && blocks[0] == 16 &&
+	       blocks[1] == block.size() * sizeof(int));
+}
+
+static void testMapped(void)
+{
+	char path[] = "/tmp/MappedListXXXXXX";
+	int fd = mkstemp(path);
+	assert(fd >= 0);
+	close(fd);
+	unlink(path);
+
+	// Grows past its first few slots, survives closing and reopening
+	{
+		MappedList<long> list(path, 4);
+		for (long i = 0; i < 1000; i++)
+			list.push_back(i);
+		list.push_front(-1).add(500, -2);
+		assert(list.rm(0) == -1 && list.rm(list.size() - 1) == 999);
+		assert(list.size() == 1000 && list.peek(999) == 998);
+	}
+	{
+		MappedList<long> list(path);
+		assert(!list.recovered() && list.size() == 1000);
+		long i = 0;
+		for (long x : list) {
+			assert(x == (i == 499 ? -2 : i < 499 ? i : i - 1));
+			i++;
+		}
+		assert(list.rm(499) == -2);
+		list.push_back(999);    // takes the freed slot
+	}
+
+	// Appending the list's own elements while the file grows under them
+	{
+		char grown[] = "/tmp/MappedListXXXXXX";
+		int gfd = mkstemp(grown);
+		assert(gfd >= 0);
+		close(gfd);
+		unlink(grown);
+		MappedList<long> list(grown, 1);
+		list.push_back(42);
+		for (int i = 0; i < 20; i++) {
+			list.push_back(list.peek(0));
+			list.push_front(*list.begin());
+		}
+		assert(list.size() == 41);
+		for (long x : list)
+			assert(x == 42);
+		unlink(grown);
+	}
+
+	// A process dies without syncing, then a link gets clobbered
+	pid_t pid = fork();
+	if (pid == 0) {
+		MappedList<long> list(path);
+		for (long i = 1000; i < 1100; i++)
+			list.push_back(i);
+		_exit(0);
+	}
+	int status;
+	waitpid(pid, &status, 0);
+	assert(WIFEXITED(status));
+	{
+		MappedList<long> list(path);
+		assert(!list.recovered() && list.size() == 1100);
+		for (int i = 0; i < 1100; i++)
+			assert(list.peek(i) == i);
+	}
+	fd = open(path, O_RDWR);
+	long garbage = 12345;
+	pwrite(fd, &garbage, sizeof(garbage),
+	       MappedList<long>::DATA_START + 10 * MappedList<long>::STRIDE +
+	       sizeof(long));
+	const char dirty[8] = { 1 };
+	pwrite(fd, dirty, sizeof(dirty), 8 * sizeof(std::uint64_t));  // flag
+	close(fd);
+	{
+		// Recovery fails, the file is neither left open nor mapped
+		std::string name(path);
+		int before = dup(0);
+		close(before);
+		bool threw = false;
+		failAt = allocations + 1;
+		try { MappedList<long> list(name); }
+		catch (const std::bad_alloc&) { threw = true; }
+		failAt = 0;
+		int after = dup(0);
+		close(after);
+		assert(threw && after == before);
+	}
+	{
+		// Slot 10 holds element 10, the list now ends there
+		MappedList<long> list(path);
+		assert(list.recovered() && list.size() == 11 && list.peek(10) == 10);
+		list.push_back(11);
+		assert(list.size() == 12 && list.peek(11) == 11);
+		list.clear();
+		assert(list.isEmpty() && list.begin() == list.end());
+	}
+
+	// Not a list of long
+	bool threw = false;
+	try { MappedList<int> wrong(path); } catch (const std::invalid_argument&) { threw = true; }
+	assert(threw);
+	unlink(path);
+}
+
+static void testPrefetch(void)
+{
+	// Same answers with the jump table on, also once it's stale
+	List<int> a, b;
+	for (int i = 0; i < 1000; i++) {
+		a.push_back(i % 17);
+		b.push_back(i % 17);
+	}
+	a.prefetch(8);
+	for (int round = 0; round < 3; round++) {
+		assert(a.count(3) == b.count(3));
+		assert(a.find_first(16) == b.find_first(16));
+		assert(a.search(5).size() == 59 && a == b && b == a);
+		assert(a.peek(999) == b.peek(999) && a.peek(500) == b.peek(500));
+		a.rm(round);
+		a.add(round, b.peek(round));
+		a.sort();
+		b.sort();
+	}
+
+	// Copies keep the setting, switching off drops the table
+	List<int> c(a);
+	assert(c == a);
+	c.clear();
+	assert(c.isEmpty() && c.count(0) == 0);
+	a.prefetch(0);
+	assert(a == b);
+
+	// Const scans and peeks only read, two threads may share a list
+	a.prefetch(8);
+	const List<int>& shared = a;
+	long seen[2] = { 0, 0 };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 2; t++)
+		readers.emplace_back([&shared, &seen, t] {
+			for (int i = 0; i < 200; i++)
+				seen[t] += shared.peek(i * 5) + shared.count(3) +
+				           shared.find_first(16);
+		});
+	for (std::thread& reader : readers)
+		reader.join();
+	assert(seen[0] == seen[1] && seen[0] > 0);
+	long before = a.hops();
+	assert(shared.peek(500) == a.peek(500) && a.hops() > before);
+	before = a.hops();
+	shared.peek(600);
+	assert(a.hops() == before);
+}
+
+// Large object linked into two lists at once, by its base and a member hook
+struct Job : ListHook<Job> {
+	Job(int Key = 0, int Age = 0) : key(Key), age(Age) {}
+	bool operator<(const Job& that) const { return key < that.key; }
+
+	int key, age;
+	char payload[256];
+	ListHook<Job> byAge;
+};
+
+static bool olderFirst(const Job& a, const Job& b)
+{
+	return a.age > b.age;
+}
+
+static void testIntrusive(void)
+{
+	typedef IntrusiveList<Job> ByKey;
+	typedef IntrusiveList<Job, void, &Job::byAge> ByAge;
+
+	const int n = 100;
+	std::vector<Job> jobs;
+	for (int i = 0; i < n; i++)
+		jobs.push_back(Job(i % 10, i));
+
+	long before = allocations;
+	ByKey keys;
+	ByAge ages;
+	for (int i = 0; i < n; i++) {
+		keys.add(keys.size() / 2, jobs[i]);
+		ages.push_front(jobs[i]);
+	}
+	assert(keys.size() == n && ages.size() == n && &ages.peek(0) == &jobs[n - 1]);
+
+	// Stable sort by key, ages order untouched
+	keys.sort();
+	int prevKey = -1, prevAge = -1;
+	for (ByKey::iterator it = keys.begin(); it != keys.end(); ++it) {
+		assert(it->key > prevKey || (it->key == prevKey && it->age != prevAge));
+		prevKey = it->key;
+		prevAge = it->age;
+	}
+	assert(keys.peek(n - 1).key == 9);
+	for (int i = 0; i < n; i++)
+		assert(ages.peek(i).age == n - 1 - i);
+
+	// rm / remove only unlink, objects stay where they are
+	Job& first = keys.rm(0);
+	assert(first.key == 0 && keys.size() == n - 1);
+	assert(ages.remove(jobs[50]) && !ages.remove(jobs[50]));
+	assert(ages.size() == n - 1);
+	keys.push_front(first);
+
+	// reverse and merge relink only
+	ages.reverse();
+	assert(ages.peek(0).age == 0 && ages.peek(n - 2).age == n - 1);
+	ByAge young;
+	young.push_back(jobs[50]);
+	ages.merge(50, young);
+	assert(young.isEmpty() && ages.size() == n && ages.peek(50).age == 50);
+	ages.sort(olderFirst);
+	assert(ages.peek(0).age == n - 1 && ages.peek(n - 1).age == 0);
+	ages.push_back(jobs[0]);    // tail is right after sort
+	assert(ages.peek(n).age == 0);
+	ages.rm(n);
+	assert(allocations == before);
+
+	// Stable: equal keys keep their insertion (age) order
+	keys.clear();
+	for (int i = 0; i < n; i++)
+		keys.push_back(jobs[i]);
+	keys.sort();
+	for (int i = 0; i < n; i++)
+		assert(keys.peek(i).key == i / 10 &&
+		       keys.peek(i).age == i / 10 + 10 * (i % 10));
+
+	// A throwing comparator leaves every object hooked in
+	for (int limit : { 1, 50, 300 }) {
+		int calls = 0;
+		bool threw = false;
+		try {
+			keys.sort([&](const Job& a, const Job& b) {
+				if (++calls == limit)
+					throw std::runtime_error("compare");
+				return a.age > b.age;
+			});
+		}
+		catch (const std::runtime_error&) { threw = true; }
+		assert(threw && keys.size() == n);
+		int count = 0, ageSum = 0;
+		for (ByKey::iterator it = keys.begin(); it != keys.end(); ++it) {
+			count++;
+			ageSum += it->age;
+		}
+		assert(count == n && ageSum == n * (n - 1) / 2);
+		Job& last = keys.rm(n - 1);     // tail is right after a throw too
+		keys.push_back(last);
+		assert(&keys.peek(n - 1) == &last);
+	}
+	keys.sort();
+	assert(keys.peek(0).key == 0 && keys.peek(n - 1).key == 9);
+
+	bool thrown = false;
+	try { keys.merge(0, keys); }
+	catch (const std::invalid_argument&) { thrown = true; }
+	assert(thrown);
+	ages.clear();
+	assert(ages.isEmpty() && ages.begin() == ages.end() && keys.size() == n);
+}
 
 int main(int argc, char *argv[])
 {
+	testPool();
+	testUnrolled();
+	testSort();
+	testIterators();
+	testTail();
+	testMove();
+	testIndexed();
+	testFinger();
+	testSearch();
+	testCompact();
+	testPersistent();
+	testConcurrentQueue();
+	testAllocator();
+	testIntrusive();
+	testSetAlgebra();
+	testRadix();
+	testBufferedIO();
+	testMapped();
+	testPrefetch();
+
+	std::cout << "All tests passed" << std::endl;
 	return 0;
 }
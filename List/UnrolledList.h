@@ -0,0 +1,621 @@
+#ifndef __UNROLLED_LIST_H__
+#define __UNROLLED_LIST_H__
+
+// Libraries
+#include <algorithm>    // reverse, stable_sort
+#include <cstddef>      // size_t
+#include <iostream>
+#include <iterator>     // make_move_iterator
+#include <new>          // placement new
+#include <stdexcept>    // invalid_argument
+#include <type_traits>  // aligned_storage
+#include <utility>      // move
+#include <vector>
+
+// My headers
+#include "List.h"
+
+/**
+ * My notes:
+ *  - Same interface as List<T>, but every node holds a block of elements
+ *    sized to fill BlockBytes (one cache line by default). Scans touch one
+ *    pointer per block instead of one per element.
+ *  - A full block is split in two on insert, and a block that drops below
+ *    half full is merged with its successor when both fit in one block.
+ */
+template<class T, std::size_t BlockBytes = 64>
+class UnrolledList {
+public:
+// Life cycle
+
+    /** Default constructor
+     */
+    UnrolledList(void);
+
+    /** Copy constructor
+     *
+     * @param from          This object is copied to this list (deep).
+     */
+    UnrolledList(const UnrolledList<T, BlockBytes>& from);
+
+    /** Move constructor
+     *
+     * @param from          This object is copied to this list (stolen).
+     */
+    UnrolledList(UnrolledList<T, BlockBytes>&& from);
+
+    /** Destructor
+     */
+    ~UnrolledList(void);
+
+// Operators
+
+    /** Assignment operator
+     *
+     * @param from          This object is assigned to this list (deep).
+     * @return              This object.
+     */
+    UnrolledList<T, BlockBytes>& operator=(UnrolledList<T, BlockBytes> from);
+
+    /** Equal to operator
+     *
+     * @param obj           List to compare with this object.
+     * @return              true / false.
+     */
+    bool operator==(const UnrolledList<T, BlockBytes>& obj) const;
+
+    /** Not equal to operator
+     *
+     * @param obj           List to compare with this object.
+     * @return              true / false.
+     */
+    bool operator!=(const UnrolledList<T, BlockBytes>& obj) const;
+
+// Operations
+
+    /** Add new element by position
+     *
+     * @param pos           List position to insert the new element.
+     * @param data          Data to store.
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid.
+     */
+    UnrolledList<T, BlockBytes>& add(const int& pos, const T& data);
+
+    /** Remove element by position
+     *
+     * @param pos           List position of the element to remove.
+     * @return              The removed element.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    T rm(const int& pos);
+
+    /** Remove all elements in the list
+     *
+     * @return              Reference to this object.
+     */
+    UnrolledList<T, BlockBytes>& clear(void);
+
+    /** Reverse the list
+     *
+     * @return              Reference to this object.
+     */
+    UnrolledList<T, BlockBytes>& reverse(void);
+
+    /** Merge lists
+     *
+     * @param pos           List position to do the merge.
+     * @param with          List to merge to this object (steal).
+     * @return              Reference to this object.
+     *
+     * @invalid_argument    An exception is generated if position is invalid or
+     *                      if with is a reference to this object.
+     */
+    UnrolledList<T, BlockBytes>& merge(const int& pos,
+                                       UnrolledList<T, BlockBytes>& with);
+
+    /** Sort the list (stable)
+     *
+     * Blocks are refilled to capacity afterwards.
+     *
+     * @return              Reference to this object.
+     */
+    UnrolledList<T, BlockBytes>& sort(void);
+
+// Access
+
+    /** Get size
+     *
+     * @return              Current size of the list.
+     */
+    const int& size(void) const;
+
+    /** Is list empty?
+     *
+     * @return              true or false.
+     */
+    bool isEmpty(void) const;
+
+    /** Search element (traverses the list for matches)
+     *
+     * @param key           Element to be searched for.
+     * @return              List with all positions containing a match, in
+     *                      ascending order.
+     */
+    List<int> search(const T& key) const;
+
+    /** Peek at position
+     *
+     * @param pos           Possition to peek at.
+     * @return              Data stored in the specified position.
+     *
+     * @invalid_argument    An exception is generated if invalid position.
+     */
+    const T& peek(const int& pos) const;
+
+    /** Prints the list
+     *
+     * @return              Reference to this object.
+     */
+    const UnrolledList<T, BlockBytes>& print(void) const;
+
+    /** Get number of blocks
+     *
+     * @return              Number of blocks currently linked.
+     */
+    int blocks(void) const;
+
+    /** Offset of the first element in a block, after the link, the count
+     *  and padding up to T's alignment
+     */
+    static const std::size_t SLOTS_AT =
+        (sizeof(void*) + sizeof(int) + alignof(T) - 1) / alignof(T) *
+        alignof(T);
+
+    /** Elements per block, at least one
+     */
+    static const int CAP =
+        BlockBytes >= SLOTS_AT + sizeof(T)
+            ? static_cast<int>((BlockBytes - SLOTS_AT) / sizeof(T))
+            : 1;
+
+private:
+
+    // Aligned to its size, so a block never straddles two cache lines
+    // (aligned new from C++17 on)
+    struct alignas(BlockBytes) Block {
+        Block* next;
+        int count;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type slot[CAP];
+
+        Block(void) : next(nullptr), count(0) {}
+        T* at(int i) { return reinterpret_cast<T*>(&slot[i]); }
+        const T* at(int i) const { return reinterpret_cast<const T*>(&slot[i]); }
+    };
+
+    // Only an element too large for one block makes it span several
+    static_assert(sizeof(Block) == BlockBytes ||
+                  (CAP == 1 && sizeof(Block) % BlockBytes == 0),
+                  "a block must fill BlockBytes exactly");
+
+    Block* head;        // First block
+    Block* tail;        // Last block
+    int n;              // List size
+
+    // Helper functions
+    Block* locate(int pos, int* offset) const;
+    Block* split(Block* b, int at);
+    void unlink(Block* prev, Block* b);
+    static void destroy(Block* b);
+};
+
+template<class T, std::size_t BlockBytes>
+const std::size_t UnrolledList<T, BlockBytes>::SLOTS_AT;
+
+template<class T, std::size_t BlockBytes>
+const int UnrolledList<T, BlockBytes>::CAP;
+
+// ****************************** Life cycle ***********************************
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>::UnrolledList(void)
+    : head(nullptr), tail(nullptr), n(0)
+{
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>::UnrolledList(const UnrolledList<T, BlockBytes>& from)
+    : head(nullptr), tail(nullptr), n(0)
+{
+    try {
+        for (Block* fr = from.head; fr != nullptr; fr = fr->next) {
+            Block* b = new Block;
+            (tail != nullptr ? tail->next : head) = b;
+            tail = b;
+            for (; b->count < fr->count; b->count++, n++)
+                new (b->at(b->count)) T(*fr->at(b->count));
+        }
+    }
+    catch (...) {
+        clear();    // destructor won't run, don't leak the partial copy
+        throw;
+    }
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>::UnrolledList(UnrolledList<T, BlockBytes>&& from)
+    : head(from.head), tail(from.tail), n(from.n)
+{
+    from.head = from.tail = nullptr;
+    from.n    = 0;
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>::~UnrolledList(void)
+{
+    clear();
+}
+
+// ****************************** Operators  ***********************************
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>&
+UnrolledList<T, BlockBytes>::operator=(UnrolledList<T, BlockBytes> from)
+{
+    std::swap(head, from.head);
+    std::swap(tail, from.tail);
+    std::swap(n, from.n);
+    return *this;
+}
+
+template<class T, std::size_t BlockBytes>
+bool UnrolledList<T, BlockBytes>::operator==(
+    const UnrolledList<T, BlockBytes>& obj) const
+{
+    if (this->n != obj.n)
+        return false;
+
+    // Block boundaries may differ, walk both lists element by element
+    const Block* b = obj.head;
+    int i = 0;
+    for (const Block* a = head; a != nullptr; a = a->next)
+        for (int j = 0; j < a->count; j++) {
+            if (i == b->count) {
+                b = b->next;
+                i = 0;
+            }
+            if (!(*a->at(j) == *b->at(i++)))
+                return false;
+        }
+    return true;
+}
+
+template<class T, std::size_t BlockBytes>
+bool UnrolledList<T, BlockBytes>::operator!=(
+    const UnrolledList<T, BlockBytes>& obj) const
+{
+    return !(*this == obj);
+}
+
+// ****************************** Operations ***********************************
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>&
+UnrolledList<T, BlockBytes>::add(const int& pos, const T& data)
+{
+    if (pos < 0 || pos > n)
+        throw std::invalid_argument("UnrolledList<T>::add");
+
+    // Get in position to insert element
+    int i;
+    Block* b = locate(pos, &i);
+    if (b == nullptr)
+        head = tail = b = new Block;
+
+    // Make room, split a full block in two halves. Appending to a full block
+    // just starts a new one so that append-built lists stay densely packed.
+    if (b->count == CAP && i == CAP) {
+        b = split(b, CAP);
+        i = 0;
+    }
+    else if (b->count == CAP) {
+        Block* upper = split(b, CAP / 2);
+        if (i > b->count) {
+            i -= b->count;
+            b  = upper;
+        }
+    }
+
+    // Insert element, shifting the rest of the block one step right
+    if (i == b->count) {
+        new (b->at(i)) T(data);
+    }
+    else {
+        T tmp(data);    // data may alias an element that is about to move
+        new (b->at(b->count)) T(std::move(*b->at(b->count - 1)));
+        for (int j = b->count - 1; j > i; j--)
+            *b->at(j) = std::move(*b->at(j - 1));
+        *b->at(i) = std::move(tmp);
+    }
+    b->count++; this->n++;
+
+    return *this;
+}
+
+template<class T, std::size_t BlockBytes>
+T UnrolledList<T, BlockBytes>::rm(const int& pos)
+{
+    if (pos < 0 || pos >= this->n)
+        throw std::invalid_argument("UnrolledList<T>::rm");
+
+    // Get in position to remove element, remember the previous block
+    Block* prev = nullptr;
+    Block* b    = head;
+    int i       = pos;
+    while (i >= b->count) {
+        i   -= b->count;
+        prev = b;
+        b    = b->next;
+    }
+
+    // Remove element, shifting the rest of the block one step left
+    T rmData(std::move(*b->at(i)));
+    for (int j = i; j < b->count - 1; j++)
+        *b->at(j) = std::move(*b->at(j + 1));
+    b->at(--b->count)->~T(); this->n--;
+
+    // Drop empty blocks, fold under-filled blocks into their successor
+    Block* next = b->next;
+    if (b->count == 0) {
+        unlink(prev, b);
+    }
+    else if (b->count < CAP / 2 && next != nullptr &&
+             b->count + next->count <= CAP) {
+        for (int j = 0; j < next->count; j++) {
+            new (b->at(b->count++)) T(std::move(*next->at(j)));
+            next->at(j)->~T();
+        }
+        next->count = 0;
+        unlink(b, next);
+    }
+
+    return rmData;
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>& UnrolledList<T, BlockBytes>::clear(void)
+{
+    for (Block* b = head, *next; b != nullptr; b = next) {
+        next = b->next;
+        destroy(b);
+    }
+    head = tail = nullptr;
+    n    = 0;
+
+    return *this;
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>& UnrolledList<T, BlockBytes>::reverse(void)
+{
+    // Reverse block order and the elements inside every block
+    Block* newHead = nullptr;
+    tail = head;
+    for (Block* b = head, *next; b != nullptr; b = next) {
+        next    = b->next;
+        std::reverse(b->at(0), b->at(0) + b->count);
+        b->next = newHead;
+        newHead = b;
+    }
+    head = newHead;
+
+    return *this;
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>&
+UnrolledList<T, BlockBytes>::merge(const int& pos,
+                                   UnrolledList<T, BlockBytes>& with)
+{
+    if (pos < 0 || pos > n || &with == this)
+        throw std::invalid_argument("UnrolledList<T>::merge");
+    if (with.head == nullptr)
+        return *this;
+
+    // Find the block to splice after, splitting it if pos is mid-block
+    Block* prev = nullptr;
+    if (pos == n) {
+        prev = tail;
+    }
+    else {
+        Block* b = head;
+        int i    = pos;
+        while (i >= b->count) {
+            i   -= b->count;
+            prev = b;
+            b    = b->next;
+        }
+        if (i > 0) {
+            split(b, i);
+            prev = b;
+        }
+    }
+
+    // Splice with's blocks in
+    Block* after = prev != nullptr ? prev->next : head;
+    (prev != nullptr ? prev->next : head) = with.head;
+    with.tail->next = after;
+    if (after == nullptr)
+        tail = with.tail;
+    this->n += with.n;
+
+    // Clean up 'with'
+    with.head = with.tail = nullptr;
+    with.n    = 0;
+
+    return *this;
+}
+
+template<class T, std::size_t BlockBytes>
+UnrolledList<T, BlockBytes>& UnrolledList<T, BlockBytes>::sort(void)
+{
+    // Sort a flat copy, then refill the blocks to capacity
+    std::vector<T> flat;
+    flat.reserve(n);
+    for (Block* b = head; b != nullptr; b = b->next)
+        flat.insert(flat.end(), std::make_move_iterator(b->at(0)),
+                    std::make_move_iterator(b->at(0) + b->count));
+    std::stable_sort(flat.begin(), flat.end());
+
+    Block* prev = nullptr;
+    Block* b    = head;
+    for (int k = 0; k < n; prev = b, b = b->next) {
+        int fill = n - k < CAP ? n - k : CAP;
+        for (int j = 0; j < fill; j++, k++)
+            if (j < b->count)
+                *b->at(j) = std::move(flat[k]);
+            else
+                new (b->at(j)) T(std::move(flat[k]));
+        for (int j = fill; j < b->count; j++)
+            b->at(j)->~T();
+        b->count = fill;
+    }
+
+    // Blocks past the refilled ones are no longer needed
+    if (prev != nullptr) {
+        for (Block* next; b != nullptr; b = next) {
+            next = b->next;
+            destroy(b);
+        }
+        prev->next = nullptr;
+        tail       = prev;
+    }
+
+    return *this;
+}
+
+// ****************************** Access ***************************************
+
+template<class T, std::size_t BlockBytes>
+const int& UnrolledList<T, BlockBytes>::size(void) const
+{
+    return this->n;
+}
+
+template<class T, std::size_t BlockBytes>
+bool UnrolledList<T, BlockBytes>::isEmpty(void) const
+{
+    return this->n <= 0;
+}
+
+template<class T, std::size_t BlockBytes>
+List<int> UnrolledList<T, BlockBytes>::search(const T& key) const
+{
+    List<int> matches;
+
+    // Find all matches
+    int pos = 0;
+    for (const Block* b = head; b != nullptr; b = b->next) {
+        const T* elem = b->at(0);
+        const int count = b->count;
+        for (int j = 0; j < count; j++)
+            if (elem[j] == key)
+                matches.push_back(pos + j);
+        pos += count;
+    }
+
+    return matches;
+}
+
+template<class T, std::size_t BlockBytes>
+const T& UnrolledList<T, BlockBytes>::peek(const int& pos) const
+{
+    if (pos < 0 || pos >= this->n)
+        throw std::invalid_argument("UnrolledList<T>::peek");
+
+    int i;
+    const Block* b = locate(pos, &i);
+    return *b->at(i);
+}
+
+template<class T, std::size_t BlockBytes>
+const UnrolledList<T, BlockBytes>& UnrolledList<T, BlockBytes>::print(void) const
+{
+    for (const Block* b = head; b != nullptr; b = b->next)
+        for (int j = 0; j < b->count; j++)
+            std::cout << *b->at(j) << " ";
+    std::cout << std::endl;
+
+    return *this;
+}
+
+template<class T, std::size_t BlockBytes>
+int UnrolledList<T, BlockBytes>::blocks(void) const
+{
+    int count = 0;
+    for (const Block* b = head; b != nullptr; b = b->next)
+        count++;
+    return count;
+}
+
+// ****************************** Private **************************************
+
+template<class T, std::size_t BlockBytes>
+typename UnrolledList<T, BlockBytes>::Block*
+UnrolledList<T, BlockBytes>::locate(int pos, int* offset) const
+{
+    // Position n maps to one past the last element of the last block
+    if (pos == n) {
+        *offset = tail != nullptr ? tail->count : 0;
+        return tail;
+    }
+
+    Block* b = head;
+    while (pos >= b->count) {
+        pos -= b->count;
+        b    = b->next;
+    }
+    *offset = pos;
+
+    return b;
+}
+
+template<class T, std::size_t BlockBytes>
+typename UnrolledList<T, BlockBytes>::Block*
+UnrolledList<T, BlockBytes>::split(Block* b, int at)
+{
+    // Move elements [at, count) to a new block linked right after b
+    Block* upper = new Block;
+    for (int j = at; j < b->count; j++) {
+        new (upper->at(upper->count++)) T(std::move(*b->at(j)));
+        b->at(j)->~T();
+    }
+    b->count    = at;
+    upper->next = b->next;
+    b->next     = upper;
+    if (tail == b)
+        tail = upper;
+
+    return upper;
+}
+
+template<class T, std::size_t BlockBytes>
+void UnrolledList<T, BlockBytes>::unlink(Block* prev, Block* b)
+{
+    (prev != nullptr ? prev->next : head) = b->next;
+    if (tail == b)
+        tail = prev;
+    destroy(b);
+}
+
+template<class T, std::size_t BlockBytes>
+void UnrolledList<T, BlockBytes>::destroy(Block* b)
+{
+    for (int j = 0; j < b->count; j++)
+        b->at(j)->~T();
+    delete b;
+}
+
+#endif // __UNROLLED_LIST_H__